@@ -2,3 +2,15 @@
 
 #include "pixel.hpp"
 #include "image.hpp"
+#include "convert.hpp"
+#include "image_reader.hpp"
+#include "image_writer.hpp"
+#include "padded_image.hpp"
+#include "integral_image.hpp"
+#include "filter.hpp"
+#include "geometry.hpp"
+#include "pyramid.hpp"
+#include "histogram.hpp"
+#include "lut.hpp"
+#include "threshold.hpp"
+#include "morphology.hpp"
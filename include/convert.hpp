@@ -0,0 +1,24 @@
+#pragma once
+
+#include "image.hpp"
+
+namespace qlm
+{
+	// Transfer functions used when moving between integer and floating-point pixels
+	enum class TransferFunction
+	{
+		LINEAR, // v / max
+		SRGB,   // IEC 61966-2-1 piecewise curve
+		GAMMA,  // pow(v / max, gamma)
+	};
+
+	// Convert an 8-bit image to linear floating-point in [0, 1]. Alpha is always converted linearly.
+	template<ImageFormat frmt>
+	void ConvertToFloat(const Image<frmt, uint8_t>& in, Image<frmt, float>& out,
+						TransferFunction transfer = TransferFunction::SRGB, float gamma = 2.2f);
+
+	// Convert a linear floating-point image to 8-bit, clamping to [0, 1]. Alpha is always converted linearly.
+	template<ImageFormat frmt>
+	void ConvertToU8(const Image<frmt, float>& in, Image<frmt, uint8_t>& out,
+					 TransferFunction transfer = TransferFunction::SRGB, float gamma = 2.2f);
+}
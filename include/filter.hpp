@@ -0,0 +1,56 @@
+#pragma once
+
+#include "image.hpp"
+#include <vector>
+
+namespace qlm
+{
+	// Algorithm of Filter2D
+	enum class FilterMethod
+	{
+		AUTO,   // the cheaper of DIRECT and FFT for the kernel and image size
+		DIRECT, // sum over the kernel taps, unrolled for 3x3 and 5x5 kernels
+		FFT,    // overlap-save FFT tiles, for large kernels
+	};
+
+	// Separable 2D convolution: the rows are filtered with kernel_x, then the columns with kernel_y.
+	// Kernels are centered on index size / 2 and all channels are filtered, alpha included (like Pixel::MAC).
+	// 8 and 16-bit images use fixed-point arithmetic, the work is split over row bands on all threads.
+	template<ImageFormat frmt, pixel_t T>
+	void SepFilter2D(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<float>& kernel_x, const std::vector<float>& kernel_y,
+					 const BorderMode<frmt, T>& border_mode = {});
+
+	// 2D correlation with an arbitrary kernel_width x kernel_height kernel stored row by row, centered on
+	// (kernel_width / 2, kernel_height / 2). All channels are filtered, alpha included (like Pixel::MAC).
+	// Small kernels are applied directly (8-bit images in fixed-point), large ones through FFT tiles.
+	template<ImageFormat frmt, pixel_t T>
+	void Filter2D(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<float>& kernel, int kernel_width, int kernel_height,
+				  const BorderMode<frmt, T>& border_mode = {}, FilterMethod method = FilterMethod::AUTO);
+
+	// Mean (or sum when "normalize" is false) over kernel_width x kernel_height boxes centered on
+	// (kernel_width / 2, kernel_height / 2). Running sums make the cost per pixel independent of the box size.
+	template<ImageFormat frmt, pixel_t T>
+	void BoxFilter(const Image<frmt, T>& in, Image<frmt, T>& out, int kernel_width, int kernel_height,
+				   const BorderMode<frmt, T>& border_mode = {}, bool normalize = true);
+
+	// Gaussian blur with standard deviations sigma_x and sigma_y (0 means sigma_x for sigma_y; a zero sigma_x
+	// with a zero sigma_y leaves the image unchanged). Small sigmas use a direct separable kernel of radius
+	// 3 sigma (4 sigma for floating-point images), larger ones Deriche's recursive filter whose cost does not
+	// depend on sigma.
+	template<ImageFormat frmt, pixel_t T>
+	void GaussianBlur(const Image<frmt, T>& in, Image<frmt, T>& out, float sigma_x, float sigma_y = 0.0f,
+					  const BorderMode<frmt, T>& border_mode = {});
+
+	// Median over ksize x ksize windows (ksize odd, up to 255) of all channels, alpha included, for 8 and 16-bit
+	// pixels. 3x3 and 5x5 use min/max sorting networks; larger 8-bit windows the constant-time histogram
+	// algorithm of Perreault and Hebert in column strips, larger 16-bit windows a three level histogram.
+	template<ImageFormat frmt, pixel_t T>
+	void MedianBlur(const Image<frmt, T>& in, Image<frmt, T>& out, int ksize,
+					const BorderMode<frmt, T>& border_mode = { BorderType::BORDER_REPLICATE });
+
+	// Edge-preserving smoothing over a disk of diameter "diameter" (radius 1.5 sigma_space if not positive), O(radius^2) per
+	// pixel: there is no fast path for the default window, only radii above 16 covering 3 sigma_space use a lattice.
+	template<ImageFormat frmt, pixel_t T>
+	void BilateralFilter(const Image<frmt, T>& in, Image<frmt, T>& out, int diameter, float sigma_color, float sigma_space,
+						 const BorderMode<frmt, T>& border_mode = { BorderType::BORDER_REFLECT_101 });
+}
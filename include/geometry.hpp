@@ -0,0 +1,134 @@
+#pragma once
+
+#include "image.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace qlm
+{
+	// Interpolation of geometric transforms
+	enum class Interpolation
+	{
+		NEAREST,  // closest source pixel
+		BILINEAR, // triangle filter, 2x2 source pixels when enlarging
+		BICUBIC,  // Keys cubic (a = -0.5), 4x4 source pixels when enlarging
+		AREA,     // exact pixel-area coverage
+		LANCZOS3, // windowed sinc over 3 lobes, 6x6 source pixels when enlarging
+	};
+
+	// Resize "in" to width x height. Pixel centers are aligned and, when shrinking, the bilinear, bicubic and
+	// Lanczos filters are widened by the scale factor so the result is antialiased. Both passes use per-column
+	// and per-row coefficient tables; 8-bit images are resampled in fixed-point. Rows are spread over all threads.
+	template<ImageFormat frmt, pixel_t T>
+	void Resize(const Image<frmt, T>& in, Image<frmt, T>& out, int width, int height, Interpolation interpolation = Interpolation::BILINEAR);
+
+	// Affine warp into a width x height image. "matrix" (row-major 2x3) maps input coordinates to output
+	// coordinates, or output to input when "inverse_map" is set; pixel centers are at integer coordinates.
+	// Only NEAREST and BILINEAR are supported. The source coordinates are stepped along each row from per-column
+	// tables instead of a matrix product per pixel, in fixed-point for integer pixels, and the output is
+	// processed in tiles so rotations read the source with locality.
+	template<ImageFormat frmt, pixel_t T>
+	void WarpAffine(const Image<frmt, T>& in, Image<frmt, T>& out, const std::array<double, 6>& matrix, int width, int height,
+					Interpolation interpolation = Interpolation::BILINEAR, const BorderMode<frmt, T>& border_mode = {}, bool inverse_map = false);
+
+	// Perspective warp with a row-major 3x3 homography, see WarpAffine
+	template<ImageFormat frmt, pixel_t T>
+	void WarpPerspective(const Image<frmt, T>& in, Image<frmt, T>& out, const std::array<double, 9>& matrix, int width, int height,
+						 Interpolation interpolation = Interpolation::BILINEAR, const BorderMode<frmt, T>& border_mode = {}, bool inverse_map = false);
+
+	// Source coordinates of every output pixel in a compact fixed-point form, built once from floating-point
+	// maps and reused by Remap: 16-bit integer parts plus a 1/32 pixel fraction index for bilinear sampling
+	// (6 bytes per pixel instead of 8). Coordinates are clamped to the 16-bit range.
+	class RemapMap
+	{
+	private:
+		int width{ 0 };
+		int height{ 0 };
+		Interpolation interpolation{ Interpolation::BILINEAR };
+		std::vector<int16_t> map_x;
+		std::vector<int16_t> map_y;
+		std::vector<uint16_t> fraction;
+
+	public:
+		RemapMap() = default;
+
+		RemapMap(const std::vector<float>& x, const std::vector<float>& y, int map_width, int map_height,
+				 Interpolation map_interpolation = Interpolation::BILINEAR)
+		{
+			Build(x, y, map_width, map_height, map_interpolation);
+		}
+
+	public:
+		// Convert row-major maps of map_width x map_height source coordinates, NEAREST or BILINEAR
+		bool Build(const std::vector<float>& x, const std::vector<float>& y, int map_width, int map_height,
+				   Interpolation map_interpolation = Interpolation::BILINEAR);
+
+		int Width() const
+		{
+			return width;
+		}
+
+		int Height() const
+		{
+			return height;
+		}
+
+		Interpolation GetInterpolation() const
+		{
+			return interpolation;
+		}
+
+		// Integer source coordinates of output row y
+		const int16_t* RowX(int y) const
+		{
+			return map_x.data() + static_cast<size_t>(y) * width;
+		}
+
+		const int16_t* RowY(int y) const
+		{
+			return map_y.data() + static_cast<size_t>(y) * width;
+		}
+
+		// Fraction indices (fy * 32 + fx) of output row y, bilinear maps only
+		const uint16_t* RowFraction(int y) const
+		{
+			return fraction.data() + static_cast<size_t>(y) * width;
+		}
+	};
+
+	// Generic remap into a map_width x map_height image: output pixel (x, y) samples the input at
+	// (map_x[i], map_y[i]) with i = y * map_width + x. Only NEAREST and BILINEAR are supported.
+	template<ImageFormat frmt, pixel_t T>
+	void Remap(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<float>& map_x, const std::vector<float>& map_y, int map_width,
+			   int map_height, Interpolation interpolation = Interpolation::BILINEAR, const BorderMode<frmt, T>& border_mode = {});
+
+	// Remap with a precomputed map, the per-frame cost is a streaming gather
+	template<ImageFormat frmt, pixel_t T>
+	void Remap(const Image<frmt, T>& in, Image<frmt, T>& out, const RemapMap& map, const BorderMode<frmt, T>& border_mode = {});
+
+	// Transpose: out(x, y) = in(y, x). The copies are blocked in tiles so both images are walked with locality.
+	// The in-place forms (out == in) work without a full copy when the image is square.
+	template<ImageFormat frmt, pixel_t T>
+	void Transpose(const Image<frmt, T>& in, Image<frmt, T>& out);
+
+	// Rotate by 90 degrees clockwise
+	template<ImageFormat frmt, pixel_t T>
+	void Rotate90(const Image<frmt, T>& in, Image<frmt, T>& out);
+
+	// Rotate by 180 degrees, in place for any size
+	template<ImageFormat frmt, pixel_t T>
+	void Rotate180(const Image<frmt, T>& in, Image<frmt, T>& out);
+
+	// Rotate by 270 degrees clockwise (90 degrees counterclockwise)
+	template<ImageFormat frmt, pixel_t T>
+	void Rotate270(const Image<frmt, T>& in, Image<frmt, T>& out);
+
+	// Mirror left to right, in place for any size
+	template<ImageFormat frmt, pixel_t T>
+	void FlipHorizontal(const Image<frmt, T>& in, Image<frmt, T>& out);
+
+	// Mirror top to bottom, in place for any size
+	template<ImageFormat frmt, pixel_t T>
+	void FlipVertical(const Image<frmt, T>& in, Image<frmt, T>& out);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "image.hpp"
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace qlm
+{
+	// Per-channel histogram of the color channels (alpha is not counted).
+	// Bins have equal width over [Min(), Max()); values outside the range are not counted. By default 8 and 16-bit
+	// pixels get one bin per value and floating-point pixels 256 bins over [0, 1). Rows are counted in parallel
+	// bands, each thread into several interleaved sub-histograms so repeated values do not serialize on one
+	// counter, and the bands are merged at the end.
+	template<ImageFormat frmt, pixel_t T>
+	class Histogram
+	{
+	public:
+		static constexpr int channels = frmt == ImageFormat::YCrCb ? 3 : PixelChannels<frmt, T>() - 1;
+
+	private:
+		int bins{ 0 };
+		double range_min{ 0.0 };
+		double range_max{ 0.0 };
+		std::vector<uint64_t> counts;
+
+	private:
+		template<bool masked>
+		void Count(const Image<frmt, T>& in, const Image<ImageFormat::GRAY, uint8_t>* mask, const Rect& roi);
+
+	public:
+		Histogram()
+		{
+			if constexpr (std::is_integral_v<T>)
+				SetBinning(static_cast<int>(std::numeric_limits<T>::max()) + 1, 0.0, static_cast<double>(std::numeric_limits<T>::max()) + 1.0);
+			else
+				SetBinning(256, 0.0, 1.0);
+		}
+
+		Histogram(int num_bins, double min_value, double max_value)
+		{
+			SetBinning(num_bins, min_value, max_value);
+		}
+
+	public:
+		// "num_bins" bins of equal width over [min_value, max_value), the counts are cleared
+		void SetBinning(int num_bins, double min_value, double max_value);
+
+		// Count the pixels of "in" inside "roi", the whole image when the rectangle is empty
+		void Compute(const Image<frmt, T>& in, const Rect& roi = {});
+
+		// Count only the pixels whose mask value is not zero, the mask has the size of the image
+		void Compute(const Image<frmt, T>& in, const Image<ImageFormat::GRAY, uint8_t>& mask, const Rect& roi = {});
+
+		int Bins() const
+		{
+			return bins;
+		}
+
+		double Min() const
+		{
+			return range_min;
+		}
+
+		double Max() const
+		{
+			return range_max;
+		}
+
+		// Bins() counts of channel c
+		const uint64_t* Channel(int c) const
+		{
+			return counts.data() + static_cast<size_t>(c) * bins;
+		}
+
+		uint64_t Count(int c, int bin) const
+		{
+			return counts[static_cast<size_t>(c) * bins + bin];
+		}
+
+		// Bin of a value, -1 outside the range
+		int Bin(double value) const
+		{
+			const double t = (value - range_min) * bins / (range_max - range_min);
+			return t >= 0.0 && t < bins ? static_cast<int>(t) : -1;
+		}
+	};
+
+	// Global histogram equalization of the first channel: gray for GRAY images, luma for YCrCb images.
+	// The other channels are copied. Available for uint8_t and uint16_t pixels.
+	template<ImageFormat frmt, pixel_t T>
+	void EqualizeHist(const Image<frmt, T>& in, Image<frmt, T>& out);
+
+	// Contrast Limited Adaptive Histogram Equalization of the first channel, see EqualizeHist.
+	// The image is cut into tiles_x x tiles_y tiles; every tile histogram is clipped at clip_limit times the
+	// average bin count, the excess is spread over all bins, and the tile mappings are interpolated bilinearly
+	// between tile centers. Tile histograms and the interpolation run on all threads.
+	template<ImageFormat frmt, pixel_t T>
+	void CLAHE(const Image<frmt, T>& in, Image<frmt, T>& out, double clip_limit = 40.0, int tiles_x = 8, int tiles_y = 8);
+}
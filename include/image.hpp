@@ -2,15 +2,25 @@
 
 #include "pixel.hpp"
 #include <string>
+#include <type_traits>
 
 
 namespace qlm
 {
+	// Number of interleaved channels (including alpha) stored in a pixel
+	template<ImageFormat frmt, pixel_t T>
+	constexpr int PixelChannels()
+	{
+		return static_cast<int>(sizeof(Pixel<frmt, T>) / sizeof(T));
+	}
+
 	enum class BorderType
 	{
-		BORDER_CONSTANT,
-		BORDER_REPLICATE,
-		BORDER_REFLECT,
+		BORDER_CONSTANT,    // iiiiii|abcdefgh|iiiiiii
+		BORDER_REPLICATE,   // aaaaaa|abcdefgh|hhhhhhh
+		BORDER_REFLECT,     // fedcba|abcdefgh|hgfedcb
+		BORDER_WRAP,        // cdefgh|abcdefgh|abcdefg
+		BORDER_REFLECT_101, // gfedcb|abcdefgh|gfedcba
 	};
 
 	template<ImageFormat frmt, pixel_t T>
@@ -20,6 +30,94 @@ namespace qlm
 		Pixel<frmt, T> border_pixel{};
 	};
 
+	// Index in [0, n) that position i (possibly outside) reads for a border type, -1 for constant borders.
+	// The border type is a template parameter so neighborhood kernels compile one branch-free loop per policy.
+	// Reflections and wraps repeat, borders wider than the image stay valid.
+	template<BorderType border_type>
+	constexpr int BorderIndex(int i, int n)
+	{
+		if (i >= 0 && i < n)
+			return i;
+
+		if constexpr (border_type == BorderType::BORDER_CONSTANT)
+		{
+			return -1;
+		}
+		else if constexpr (border_type == BorderType::BORDER_REPLICATE)
+		{
+			return i < 0 ? 0 : n - 1;
+		}
+		else if constexpr (border_type == BorderType::BORDER_WRAP)
+		{
+			i %= n;
+			return i < 0 ? i + n : i;
+		}
+		else if constexpr (border_type == BorderType::BORDER_REFLECT)
+		{
+			const int period = 2 * n;
+			i %= period;
+			i = i < 0 ? i + period : i;
+			return i < n ? i : period - 1 - i;
+		}
+		else
+		{
+			if (n == 1)
+				return 0;
+
+			const int period = 2 * n - 2;
+			i %= period;
+			i = i < 0 ? i + period : i;
+			return i < n ? i : period - i;
+		}
+	}
+
+	// Call func(std::integral_constant<BorderType, type>{}) with the run-time border type turned into a constant
+	template<typename Func>
+	decltype(auto) DispatchBorder(BorderType border_type, Func&& func)
+	{
+		switch (border_type)
+		{
+			case BorderType::BORDER_REPLICATE:
+				return func(std::integral_constant<BorderType, BorderType::BORDER_REPLICATE>{});
+			case BorderType::BORDER_REFLECT:
+				return func(std::integral_constant<BorderType, BorderType::BORDER_REFLECT>{});
+			case BorderType::BORDER_WRAP:
+				return func(std::integral_constant<BorderType, BorderType::BORDER_WRAP>{});
+			case BorderType::BORDER_REFLECT_101:
+				return func(std::integral_constant<BorderType, BorderType::BORDER_REFLECT_101>{});
+			default:
+				return func(std::integral_constant<BorderType, BorderType::BORDER_CONSTANT>{});
+		}
+	}
+
+	// Rectangle of pixels [x, x + width) x [y, y + height), an empty rectangle usually stands for the whole image
+	struct Rect
+	{
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+	};
+
+	enum class ChromaSubsampling
+	{
+		SUBSAMPLING_AUTO, // 4:2:0 up to quality 90, 4:4:4 above
+		SUBSAMPLING_444,
+		SUBSAMPLING_422,
+		SUBSAMPLING_420,
+	};
+
+	// Per-call encoder settings for SaveToFile
+	struct SaveOptions
+	{
+		bool alpha = true;
+		int quality = 100;     // JPEG quality, 1 to 100
+		int png_level = 5;     // deflate level, 0 stores the rows uncompressed and 9 is the smallest
+		int png_filter = -1;   // PNG row filter 0 to 4, -1 picks the best filter for every row
+		bool png_fast = false; // run-length only deflate with the Sub filter (unless png_filter is set)
+		ChromaSubsampling chroma_subsampling = ChromaSubsampling::SUBSAMPLING_AUTO;
+	};
+
 	template<ImageFormat frmt, pixel_t T>
 	class Image
 	{
@@ -33,20 +131,6 @@ namespace qlm
 		int height;
 
 	private:
-		int ReflectBorderIndex(int idx, int max_idx) const
-		{
-			int reflect_idx = idx;
-			if (idx < 0)
-			{
-				reflect_idx = -idx - 1;
-			}
-			else if (idx >= max_idx)
-			{
-				reflect_idx = max_idx - (idx - max_idx) - 1;
-			}
-			return reflect_idx;
-		}
-
 		void SetNumChannels()
 		{
 			if constexpr (frmt == ImageFormat::GRAY)
@@ -59,6 +143,10 @@ namespace qlm
 				num_of_channels = 4; // HSV/HLS + Alpha
 		}
 
+		bool SaveHDR(const std::string& file_name, bool alpha) const;
+
+		bool SavePFM(const std::string& file_name) const;
+
 	public:
 		Image(): data(nullptr), width(0), height(0), stride(0)
 		{
@@ -203,12 +291,37 @@ namespace qlm
 			}
 		}
 
+		Pixel<frmt, T>* GetData()
+		{
+			return data;
+		}
+
+		const Pixel<frmt, T>* GetData() const
+		{
+			return data;
+		}
+
+		Pixel<frmt, T>* GetRow(int y)
+		{
+			return data + y * stride;
+		}
+
+		const Pixel<frmt, T>* GetRow(int y) const
+		{
+			return data + y * stride;
+		}
+
 		Pixel<frmt, T> GetPixel(int x, int y, const BorderMode<frmt, T>& border_mode) const;
 
 		bool LoadFromFile(const std::string& file_name);
 
+		// Load a downscaled image (area averaging while copying the decoded channels), a target dimension of 0 keeps the aspect ratio
+		bool LoadScaled(const std::string& file_name, int target_width, int target_height = 0);
+
 		bool SaveToFile(const std::string& file_name, bool alpha = true,int quality = 100);
 
+		bool SaveToFile(const std::string& file_name, const SaveOptions& options);
+
 		int NumerOfChannels() const
 		{
 			return num_of_channels;
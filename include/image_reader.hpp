@@ -0,0 +1,68 @@
+#pragma once
+
+#include "image.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace qlm
+{
+	namespace detail
+	{
+		class RowDecoder;
+	}
+
+	// Streaming reader: rows are decoded band by band into caller-provided storage so the full image never has
+	// to be in memory. Supported formats are the ones stored row by row without compression:
+	// binary PNM (pgm, ppm, pam), uncompressed BMP and TGA, and PFM.
+	// 8-bit samples read into floating-point images are sRGB decoded, alpha is always linear.
+	template<ImageFormat frmt, pixel_t T>
+	class ImageReader
+	{
+	private:
+		std::unique_ptr<detail::RowDecoder> decoder;
+		std::vector<uint8_t> sample_buffer;
+		int next_row;
+
+	public:
+		ImageReader();
+		~ImageReader();
+
+		ImageReader(const ImageReader&) = delete;
+		ImageReader& operator=(const ImageReader&) = delete;
+
+	public:
+		// Parse the header, the pixel data is not read
+		bool Open(const std::string& file_name);
+
+		void Close();
+
+		int Width() const;
+
+		int Height() const;
+
+		// Channels stored in the file (1 gray, 2 gray + alpha, 3 RGB, 4 RGB + alpha)
+		int NumerOfChannels() const;
+
+		// Index of the next row returned by ReadRows
+		int NextRow() const
+		{
+			return next_row;
+		}
+
+		// Move the read position to row y, bands can be re-read to build a sliding window
+		bool SeekRow(int y);
+
+		// Decode up to "num_rows" rows, "row_stride" is in pixels (0 means the image width).
+		// Returns the number of rows decoded, 0 at the end of the image and -1 on error.
+		int ReadRows(Pixel<frmt, T>* rows, int num_rows, int row_stride = 0);
+
+		// Fill the rows of "band", its width must match the image width
+		int ReadRows(Image<frmt, T>& band);
+
+		// Decode the whole image in bands of "band_rows" rows and call "callback(band, first_row)" for each one.
+		// The same band storage is reused, the callback returns false to stop early.
+		bool ForEachBand(int band_rows, const std::function<bool(const Image<frmt, T>&, int)>& callback);
+	};
+}
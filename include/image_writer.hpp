@@ -0,0 +1,53 @@
+#pragma once
+
+#include "image.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace qlm
+{
+	namespace detail
+	{
+		class RowEncoder;
+	}
+
+	// Streaming writer: the output file is produced band by band so the full image never has to be in memory.
+	// Supported formats: PNM (pgm, ppm, pnm, pam), BMP and PNG. Floating-point pixels are sRGB encoded to 8 bits.
+	template<ImageFormat frmt, pixel_t T>
+	class ImageWriter
+	{
+	private:
+		std::unique_ptr<detail::RowEncoder> encoder;
+		std::vector<uint8_t> row_buffer;
+		int width;
+		int height;
+		int rows_written;
+		bool alpha;
+
+	public:
+		ImageWriter();
+		~ImageWriter();
+
+		ImageWriter(const ImageWriter&) = delete;
+		ImageWriter& operator=(const ImageWriter&) = delete;
+
+	public:
+		// Open the file and write the header, the format is chosen from the file extension
+		bool Begin(const std::string& file_name, int img_width, int img_height, bool alpha = true);
+
+		// Append "num_rows" rows, "row_stride" is in pixels (0 means img_width)
+		bool WriteRows(const Pixel<frmt, T>* rows, int num_rows, int row_stride = 0);
+
+		// Append all the rows of a band, its width must match the output width
+		bool WriteRows(const Image<frmt, T>& band);
+
+		// Finish the file, fails if fewer rows than the declared height were written
+		bool End();
+
+		int RowsWritten() const
+		{
+			return rows_written;
+		}
+	};
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "image.hpp"
+#include <type_traits>
+#include <vector>
+
+namespace qlm
+{
+	// Accumulator of integral sums, two steps wider than the pixel: uint8_t -> uint32_t, int16_t -> int64_t, float -> double.
+	// Unsigned sums wrap around, so box sums taken as differences stay exact as long as the box itself fits.
+	template<pixel_t T>
+	using integral_t = wider_t<wider_t<T>>;
+
+	// Accumulator of integral squared sums: uint8_t -> uint64_t, other types -> double
+	template<pixel_t T>
+	using integral_sq_t = std::conditional_t<std::is_unsigned_v<integral_t<T>>, wider_t<integral_t<T>>, double>;
+
+	// Summed-area table of all interleaved channels (alpha included), with optional squared sums.
+	// The table has (width + 1) x (height + 1) entries per channel, the first row and column are zero,
+	// so the sum of any rectangle is four lookups. Rows are summed in parallel bands, then the columns in
+	// parallel strips.
+	template<ImageFormat frmt, pixel_t T>
+	class IntegralImage
+	{
+	public:
+		using sum_t = integral_t<T>;
+		using sq_sum_t = integral_sq_t<T>;
+		static constexpr int channels = PixelChannels<frmt, T>();
+
+	private:
+		int width{ 0 };
+		int height{ 0 };
+		std::vector<sum_t> sum;
+		std::vector<sq_sum_t> sq_sum;
+
+	public:
+		IntegralImage() = default;
+
+		explicit IntegralImage(const Image<frmt, T>& in, bool squared = false)
+		{
+			Compute(in, squared);
+		}
+
+	public:
+		// Compute the sums of "in", and the squared sums when "squared" is set
+		void Compute(const Image<frmt, T>& in, bool squared = false);
+
+		int Width() const
+		{
+			return width;
+		}
+
+		int Height() const
+		{
+			return height;
+		}
+
+		bool HasSquared() const
+		{
+			return !sq_sum.empty();
+		}
+
+		// Row y (0 <= y <= Height()) of the table, (Width() + 1) * channels interleaved values.
+		// Entry x holds the sums of the pixels in [0, x) x [0, y).
+		const sum_t* SumRow(int y) const
+		{
+			return sum.data() + static_cast<size_t>(y) * (width + 1) * channels;
+		}
+
+		const sq_sum_t* SquaredSumRow(int y) const
+		{
+			return sq_sum.data() + static_cast<size_t>(y) * (width + 1) * channels;
+		}
+
+		// Sum of channel c over the rectangle [x0, x1) x [y0, y1)
+		sum_t Sum(int x0, int y0, int x1, int y1, int c) const
+		{
+			const sum_t* top = SumRow(y0);
+			const sum_t* bottom = SumRow(y1);
+			return bottom[x1 * channels + c] - bottom[x0 * channels + c] - top[x1 * channels + c] + top[x0 * channels + c];
+		}
+
+		// Sum of the squares of channel c over the rectangle [x0, x1) x [y0, y1), requires HasSquared()
+		sq_sum_t SquaredSum(int x0, int y0, int x1, int y1, int c) const
+		{
+			const sq_sum_t* top = SquaredSumRow(y0);
+			const sq_sum_t* bottom = SquaredSumRow(y1);
+			return bottom[x1 * channels + c] - bottom[x0 * channels + c] - top[x1 * channels + c] + top[x0 * channels + c];
+		}
+	};
+}
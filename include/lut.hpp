@@ -0,0 +1,91 @@
+#pragma once
+
+#include "image.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace qlm
+{
+	// One lookup table per interleaved channel (alpha included) of an 8 or 16-bit pixel.
+	// A new table maps every channel to itself. The builders evaluate a function once per value, so any tone
+	// curve (gamma, inversion, contrast, ...) costs a single pass over the image in ApplyLUT.
+	template<ImageFormat frmt, pixel_t T>
+	class LookupTable
+	{
+		static_assert(std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>, "LookupTable needs uint8_t or uint16_t pixels");
+
+	public:
+		static constexpr int channels = PixelChannels<frmt, T>();
+		static constexpr int levels = static_cast<int>(std::numeric_limits<T>::max()) + 1;
+
+	private:
+		std::vector<T> table;
+
+	public:
+		LookupTable() : table(static_cast<size_t>(channels) * levels)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				for (int v = 0; v < levels; v++)
+					table[static_cast<size_t>(c) * levels + v] = static_cast<T>(v);
+			}
+		}
+
+		// The same function for all the color channels, alpha is left unchanged
+		template<typename Func>
+		explicit LookupTable(Func func) : LookupTable()
+		{
+			Set(func);
+		}
+
+	public:
+		// Fill the table of channel c with func(value), the results are rounded and clamped to the range of T
+		template<typename Func>
+		void Set(int channel, Func func)
+		{
+			T* dst = Channel(channel);
+			for (int v = 0; v < levels; v++)
+			{
+				const double r = static_cast<double>(func(static_cast<T>(v)));
+				if (r <= 0.0)
+					dst[v] = 0;
+				else if (r >= static_cast<double>(levels - 1))
+					dst[v] = static_cast<T>(levels - 1);
+				else
+					dst[v] = static_cast<T>(r + 0.5);
+			}
+		}
+
+		// Fill the tables of all the color channels with func(value), alpha keeps its table
+		template<typename Func>
+		void Set(Func func)
+		{
+			Set(0, func);
+			for (int c = 1; c < channels - 1; c++)
+				std::copy_n(Channel(0), levels, Channel(c));
+		}
+
+		// levels entries of channel c
+		T* Channel(int c)
+		{
+			return table.data() + static_cast<size_t>(c) * levels;
+		}
+
+		const T* Channel(int c) const
+		{
+			return table.data() + static_cast<size_t>(c) * levels;
+		}
+
+		T operator()(int c, T value) const
+		{
+			return table[static_cast<size_t>(c) * levels + value];
+		}
+	};
+
+	// out = lut(in) channel by channel. The rows are split over all threads; the output may be the input image.
+	template<ImageFormat frmt, pixel_t T>
+	void ApplyLUT(const Image<frmt, T>& in, Image<frmt, T>& out, const LookupTable<frmt, T>& lut);
+}
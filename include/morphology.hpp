@@ -0,0 +1,53 @@
+#pragma once
+
+#include "image.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace qlm
+{
+	// Shape of StructuringElement
+	enum class MorphShape
+	{
+		RECT,    // every element set
+		CROSS,   // the center row and the center column
+		ELLIPSE, // the ellipse inscribed in the rectangle
+	};
+
+	// Operation of MorphologyEx
+	enum class MorphOperation
+	{
+		ERODE,    // minimum over the structuring element
+		DILATE,   // maximum over the structuring element
+		OPEN,     // erode then dilate
+		CLOSE,    // dilate then erode
+		GRADIENT, // dilate - erode
+		TOPHAT,   // in - open
+		BLACKHAT, // close - in
+	};
+
+	// width x height structuring element stored row by row, non-zero entries belong to the element
+	std::vector<uint8_t> StructuringElement(MorphShape shape, int width, int height);
+
+	// Minimum over the structuring element centered on (element_width / 2, element_height / 2), repeated
+	// "iterations" times. All channels are processed, alpha included; pixels outside the image come from
+	// border_mode. Rectangles are separable: columns use van Herk/Gil-Werman blocks, whose cost per pixel does
+	// not depend on the height, and rows runs of doubling length; iterated rectangles with replicated borders
+	// are applied once as the equivalent larger rectangle. Other elements take the minimum of precomputed
+	// horizontal runs. The output may be the input image.
+	template<ImageFormat frmt, pixel_t T>
+	void Erode(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<uint8_t>& element, int element_width, int element_height,
+			   int iterations = 1, const BorderMode<frmt, T>& border_mode = { BorderType::BORDER_REPLICATE });
+
+	// Maximum over the structuring element, see Erode
+	template<ImageFormat frmt, pixel_t T>
+	void Dilate(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<uint8_t>& element, int element_width, int element_height,
+				int iterations = 1, const BorderMode<frmt, T>& border_mode = { BorderType::BORDER_REPLICATE });
+
+	// Erosion, dilation and the operations built on them; OPEN and CLOSE repeat each step "iterations" times.
+	// Differences saturate to the range of T.
+	template<ImageFormat frmt, pixel_t T>
+	void MorphologyEx(const Image<frmt, T>& in, Image<frmt, T>& out, MorphOperation operation, const std::vector<uint8_t>& element,
+					  int element_width, int element_height, int iterations = 1,
+					  const BorderMode<frmt, T>& border_mode = { BorderType::BORDER_REPLICATE });
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "image.hpp"
+
+namespace qlm
+{
+	// Image with a materialized border of "border" pixels on every side.
+	// Neighborhood kernels read up to "border" pixels outside the interior through Row() without any bounds
+	// check or per-pixel border handling; the border is filled once by Pad() or UpdateBorder().
+	template<ImageFormat frmt, pixel_t T>
+	class PaddedImage
+	{
+	private:
+		Image<frmt, T> storage;
+		int width{ 0 };
+		int height{ 0 };
+		int border{ 0 };
+
+	private:
+		template<BorderType border_type>
+		void FillBorder();
+
+	public:
+		PaddedImage() = default;
+
+		PaddedImage(const Image<frmt, T>& in, int border_size, const BorderMode<frmt, T>& border_mode = {})
+		{
+			Pad(in, border_size, border_mode);
+		}
+
+	public:
+		// Copy "in" into the interior and fill the border, the storage is reused when the padded size does not change
+		void Pad(const Image<frmt, T>& in, int border_size, const BorderMode<frmt, T>& border_mode = {});
+
+		// Fill the border again from the current interior, e.g. after the interior was written in place
+		void UpdateBorder(const BorderMode<frmt, T>& border_mode = {});
+
+		int Width() const
+		{
+			return width;
+		}
+
+		int Height() const
+		{
+			return height;
+		}
+
+		int Border() const
+		{
+			return border;
+		}
+
+		// distance in pixels between two rows
+		int Stride() const
+		{
+			return storage.stride;
+		}
+
+		// Interior row y (-Border() <= y < Height() + Border()), valid for x in [-Border(), Width() + Border())
+		Pixel<frmt, T>* Row(int y)
+		{
+			return storage.GetRow(y + border) + border;
+		}
+
+		const Pixel<frmt, T>* Row(int y) const
+		{
+			return storage.GetRow(y + border) + border;
+		}
+
+		// Copy the interior into a regular image
+		void CopyInterior(Image<frmt, T>& out) const;
+
+		// The whole padded buffer
+		const Image<frmt, T>& Storage() const
+		{
+			return storage;
+		}
+	};
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "image.hpp"
+#include <type_traits>
+#include <vector>
+
+namespace qlm
+{
+	// Type of Laplacian levels, signed and wide enough for the difference of two pixels:
+	// uint8_t -> int16_t, int16_t -> int32_t, float -> float
+	template<pixel_t T>
+	using laplacian_t = typename std::conditional_t<std::is_floating_point_v<T>, std::type_identity<T>, std::make_signed<wider_t<T>>>::type;
+
+	// Gaussian and Laplacian image pyramid. Level 0 is the input, every next level is blurred with the 5-tap
+	// binomial kernel and halved ((size + 1) / 2) in one fused pass that only computes the kept pixels.
+	// All the Gaussian levels share one contiguous buffer allocated up front, as do the Laplacian levels;
+	// levels can be built all at once or one by one when they are first needed.
+	// Laplacian level i is Gaussian level i minus the expanded level i + 1, the last level is the Gaussian one,
+	// so Collapse() gives level 0 back exactly.
+	template<ImageFormat frmt, pixel_t T>
+	class Pyramid
+	{
+	public:
+		using lap_t = laplacian_t<T>;
+
+	private:
+		int levels{ 0 };
+		int built{ 0 };
+		std::vector<int> widths;
+		std::vector<int> heights;
+		std::vector<size_t> offsets;
+		std::vector<Pixel<frmt, T>> gaussian;
+		std::vector<Pixel<frmt, lap_t>> laplacian;
+		std::vector<bool> laplacian_built;
+		BorderMode<frmt, T> border;
+
+	public:
+		Pyramid() = default;
+
+		// Build all the levels of "in", "num_levels" 0 means down to a 1x1 level
+		Pyramid(const Image<frmt, T>& in, int num_levels = 0, const BorderMode<frmt, T>& border_mode = { BorderType::BORDER_REFLECT_101 })
+		{
+			Create(in, num_levels, border_mode);
+			Build();
+		}
+
+	public:
+		// Allocate the levels and copy "in" into level 0, the other levels are built by Build() or BuildLevel().
+		// "num_levels" is clamped to the levels down to 1x1, 0 means all of them.
+		void Create(const Image<frmt, T>& in, int num_levels = 0, const BorderMode<frmt, T>& border_mode = { BorderType::BORDER_REFLECT_101 });
+
+		// Build the Gaussian levels up to "level", the levels already built are kept
+		void BuildLevel(int level);
+
+		// Build all the Gaussian levels
+		void Build()
+		{
+			BuildLevel(levels - 1);
+		}
+
+		// Build Laplacian level "level" and the Gaussian levels it needs
+		void BuildLaplacianLevel(int level);
+
+		// Build all the Laplacian levels
+		void BuildLaplacian()
+		{
+			for (int level = 0; level < levels; level++)
+				BuildLaplacianLevel(level);
+		}
+
+		// Rebuild level 0 from the Laplacian levels, e.g. after they were edited for blending.
+		// Requires all the Laplacian levels.
+		void Collapse(Image<frmt, T>& out) const;
+
+		int Levels() const
+		{
+			return levels;
+		}
+
+		// Number of Gaussian levels built so far, level 0 included
+		int BuiltLevels() const
+		{
+			return built;
+		}
+
+		int Width(int level) const
+		{
+			return widths[level];
+		}
+
+		int Height(int level) const
+		{
+			return heights[level];
+		}
+
+		// Row y of a built Gaussian level, the rows of a level are contiguous (the stride is Width(level))
+		Pixel<frmt, T>* Row(int level, int y)
+		{
+			return gaussian.data() + offsets[level] + static_cast<size_t>(y) * widths[level];
+		}
+
+		const Pixel<frmt, T>* Row(int level, int y) const
+		{
+			return gaussian.data() + offsets[level] + static_cast<size_t>(y) * widths[level];
+		}
+
+		// Row y of a built Laplacian level
+		Pixel<frmt, lap_t>* LaplacianRow(int level, int y)
+		{
+			return laplacian.data() + offsets[level] + static_cast<size_t>(y) * widths[level];
+		}
+
+		const Pixel<frmt, lap_t>* LaplacianRow(int level, int y) const
+		{
+			return laplacian.data() + offsets[level] + static_cast<size_t>(y) * widths[level];
+		}
+
+		// Copy a built Gaussian level into a regular image
+		void CopyLevel(int level, Image<frmt, T>& out) const;
+	};
+}
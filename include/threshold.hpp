@@ -0,0 +1,47 @@
+#pragma once
+
+#include "image.hpp"
+
+namespace qlm
+{
+	// Per-pixel rule of Threshold, v is the input value and t the threshold
+	enum class ThresholdType
+	{
+		BINARY,     // v > t ? max_value : 0
+		BINARY_INV, // v > t ? 0 : max_value
+		TRUNC,      // v > t ? t : v
+		TOZERO,     // v > t ? v : 0
+		TOZERO_INV, // v > t ? 0 : v
+	};
+
+	// Local threshold of AdaptiveThreshold
+	enum class AdaptiveMethod
+	{
+		MEAN,     // mean of the block
+		GAUSSIAN, // Gaussian weighted mean of the block
+	};
+
+	// Apply a fixed threshold to the gray channel, alpha is copied. 8-bit images compare against floor(thresh).
+	// The output may be the input image.
+	template<pixel_t T>
+	void Threshold(const Image<ImageFormat::GRAY, T>& in, Image<ImageFormat::GRAY, T>& out, double thresh, double max_value,
+				   ThresholdType type = ThresholdType::BINARY);
+
+	// Threshold maximizing the between-class variance of the histogram (Otsu). 8-bit images use one bin per
+	// value, floating-point images 256 bins between their minimum and maximum. Pixels above the returned value
+	// form the foreground.
+	template<pixel_t T>
+	double OtsuThreshold(const Image<ImageFormat::GRAY, T>& in);
+
+	// Threshold at the histogram bin farthest from the line joining the highest bin to the far end of the
+	// histogram (Zack's triangle method), suited to a bright or dark peak with a long tail. Binning as OtsuThreshold.
+	template<pixel_t T>
+	double TriangleThreshold(const Image<ImageFormat::GRAY, T>& in);
+
+	// Threshold every pixel against the mean of its block_size x block_size block minus c. "type" is BINARY or
+	// BINARY_INV and block_size is odd. MEAN takes the mean of the part of the block inside the image from an
+	// integral image, GAUSSIAN a Gaussian weighted mean with replicated borders. The output may be the input image.
+	template<pixel_t T>
+	void AdaptiveThreshold(const Image<ImageFormat::GRAY, T>& in, Image<ImageFormat::GRAY, T>& out, double max_value,
+						   AdaptiveMethod method, ThresholdType type, int block_size, double c);
+}
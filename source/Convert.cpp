@@ -0,0 +1,56 @@
+#include "convert.hpp"
+#include "transfer.hpp"
+
+namespace qlm
+{
+	template<ImageFormat frmt>
+	void ConvertToFloat(const Image<frmt, uint8_t>& in, Image<frmt, float>& out, TransferFunction transfer, float gamma)
+	{
+		constexpr int ch = PixelChannels<frmt, uint8_t>();
+		static_assert(ch == PixelChannels<frmt, float>());
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		const detail::U8ToFloatTable lut{ transfer, gamma };
+
+		for (int y = 0; y < in.height; y++)
+		{
+			const uint8_t* src = reinterpret_cast<const uint8_t*>(in.GetRow(y));
+			float* dst = reinterpret_cast<float*>(out.GetRow(y));
+
+			if (transfer == TransferFunction::LINEAR)
+				detail::RowToFloatLinear(src, dst, in.width * ch);
+			else
+				detail::RowToFloat(src, dst, in.width, ch, lut);
+		}
+	}
+
+	template<ImageFormat frmt>
+	void ConvertToU8(const Image<frmt, float>& in, Image<frmt, uint8_t>& out, TransferFunction transfer, float gamma)
+	{
+		constexpr int ch = PixelChannels<frmt, float>();
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		const detail::FloatToU8Table lut{ transfer, gamma };
+
+		for (int y = 0; y < in.height; y++)
+		{
+			const float* src = reinterpret_cast<const float*>(in.GetRow(y));
+			uint8_t* dst = reinterpret_cast<uint8_t*>(out.GetRow(y));
+
+			if (transfer == TransferFunction::LINEAR)
+				detail::RowToU8Linear(src, dst, in.width * ch);
+			else
+				detail::RowToU8(src, dst, in.width, ch, lut);
+		}
+	}
+
+	template void ConvertToFloat(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, float>&, TransferFunction, float);
+	template void ConvertToFloat(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, float>&, TransferFunction, float);
+
+	template void ConvertToU8(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, uint8_t>&, TransferFunction, float);
+	template void ConvertToU8(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, uint8_t>&, TransferFunction, float);
+}
@@ -0,0 +1,290 @@
+#include "histogram.hpp"
+#include "parallel.hpp"
+#include "saturate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+
+namespace qlm
+{
+	namespace detail
+	{
+		// Add the histogram of the first channel over [x0, x1) x [y0, y1) to "hist". 8-bit values are counted
+		// into four interleaved sub-histograms so runs of equal values do not serialize on one counter.
+		template<ImageFormat frmt, pixel_t T>
+		void CountFirstChannel(const Image<frmt, T>& in, int x0, int y0, int x1, int y1, uint64_t* hist)
+		{
+			constexpr int C = PixelChannels<frmt, T>();
+			constexpr int levels = static_cast<int>(std::numeric_limits<T>::max()) + 1;
+			constexpr int copies = sizeof(T) == 1 ? 4 : 1;
+
+			std::vector<uint32_t> local(static_cast<size_t>(copies) * levels, 0);
+			const int flush_rows = std::max(1, (1 << 30) / std::max(x1 - x0, 1));
+
+			const auto flush = [&]
+			{
+				for (int k = 0; k < copies; k++)
+				{
+					for (int v = 0; v < levels; v++)
+						hist[v] += local[static_cast<size_t>(k) * levels + v];
+				}
+				std::fill(local.begin(), local.end(), 0);
+			};
+
+			for (int y = y0; y < y1; y++)
+			{
+				const T* src = reinterpret_cast<const T*>(in.GetRow(y));
+				int x = x0;
+				if constexpr (copies == 4)
+				{
+					for (; x + 4 <= x1; x += 4)
+					{
+						local[src[x * C]]++;
+						local[levels + src[(x + 1) * C]]++;
+						local[2 * levels + src[(x + 2) * C]]++;
+						local[3 * levels + src[(x + 3) * C]]++;
+					}
+				}
+
+				for (; x < x1; x++)
+					local[src[x * C]]++;
+
+				if ((y - y0 + 1) % flush_rows == 0)
+					flush();
+			}
+
+			flush();
+		}
+
+		// out = in with the first channel mapped through "lut"
+		template<ImageFormat frmt, pixel_t T>
+		void ApplyFirstChannelLut(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<T>& lut)
+		{
+			constexpr int C = PixelChannels<frmt, T>();
+
+			ParallelFor(0, in.height, 32, [&](int y0, int y1)
+			{
+				for (int y = y0; y < y1; y++)
+				{
+					const T* src = reinterpret_cast<const T*>(in.GetRow(y));
+					T* dst = reinterpret_cast<T*>(out.GetRow(y));
+					const int width = in.width;
+
+					if (src != dst)
+						std::copy_n(in.GetRow(y), width, out.GetRow(y));
+
+					for (int x = 0; x < width; x++)
+						dst[x * C] = lut[src[x * C]];
+				}
+			});
+		}
+
+		// Contrast-limited mapping of one tile histogram: counts above "clip" are cut and spread evenly over
+		// all the levels, then the cumulative histogram is scaled to the value range
+		template<pixel_t T>
+		void ClippedEqualizationLut(std::vector<uint64_t>& hist, uint64_t pixels, uint64_t clip, T* lut)
+		{
+			const int levels = static_cast<int>(hist.size());
+
+			if (clip > 0)
+			{
+				uint64_t excess = 0;
+				for (uint64_t& h : hist)
+				{
+					if (h > clip)
+					{
+						excess += h - clip;
+						h = clip;
+					}
+				}
+
+				const uint64_t batch = excess / levels;
+				const uint64_t residual = excess - batch * levels;
+				for (uint64_t& h : hist)
+					h += batch;
+
+				// the remainder goes to evenly spaced levels
+				if (residual > 0)
+				{
+					const uint64_t step = std::max<uint64_t>(levels / residual, 1);
+					uint64_t left = residual;
+					for (uint64_t v = 0; v < static_cast<uint64_t>(levels) && left > 0; v += step, left--)
+						hist[v]++;
+				}
+			}
+
+			const double scale = static_cast<double>(std::numeric_limits<T>::max()) / static_cast<double>(std::max<uint64_t>(pixels, 1));
+			uint64_t cdf = 0;
+			for (int v = 0; v < levels; v++)
+			{
+				cdf += hist[v];
+				lut[v] = SaturateCast<T>(cdf * scale);
+			}
+		}
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void EqualizeHist(const Image<frmt, T>& in, Image<frmt, T>& out)
+	{
+		if (in.width <= 0 || in.height <= 0)
+		{
+			std::cerr << "Error: EqualizeHist input image is empty." << std::endl;
+			return;
+		}
+
+		if (&in != &out && (out.width != in.width || out.height != in.height))
+			out.create(in.width, in.height);
+
+		constexpr int levels = static_cast<int>(std::numeric_limits<T>::max()) + 1;
+		std::vector<uint64_t> hist(levels, 0);
+		std::mutex merge_mutex;
+
+		detail::ParallelFor(0, in.height, 64, [&](int y0, int y1)
+		{
+			std::vector<uint64_t> band(levels, 0);
+			detail::CountFirstChannel(in, 0, y0, in.width, y1, band.data());
+
+			const std::lock_guard<std::mutex> lock(merge_mutex);
+			for (int v = 0; v < levels; v++)
+				hist[v] += band[v];
+		});
+
+		// the lowest level present maps to 0 and the cumulative counts above it are stretched to the full range
+		const uint64_t total = static_cast<uint64_t>(in.width) * in.height;
+		const int first = static_cast<int>(std::find_if(hist.begin(), hist.end(), [](uint64_t h) { return h != 0; }) - hist.begin());
+		const uint64_t base = hist[first];
+
+		std::vector<T> lut(levels);
+		if (total == base)
+		{
+			// a single level: identity
+			for (int v = 0; v < levels; v++)
+				lut[v] = static_cast<T>(v);
+		}
+		else
+		{
+			const double scale = static_cast<double>(levels - 1) / static_cast<double>(total - base);
+			uint64_t cdf = 0;
+			for (int v = 0; v < levels; v++)
+			{
+				cdf += hist[v];
+				lut[v] = v < first ? T(0) : detail::SaturateCast<T>((cdf - base) * scale);
+			}
+		}
+
+		detail::ApplyFirstChannelLut(in, out, lut);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void CLAHE(const Image<frmt, T>& in, Image<frmt, T>& out, double clip_limit, int tiles_x, int tiles_y)
+	{
+		if (in.width <= 0 || in.height <= 0)
+		{
+			std::cerr << "Error: CLAHE input image is empty." << std::endl;
+			return;
+		}
+
+		if (tiles_x <= 0 || tiles_y <= 0)
+		{
+			std::cerr << "Error: CLAHE needs at least one tile in each direction." << std::endl;
+			return;
+		}
+
+		if (&in == &out)
+		{
+			const Image<frmt, T> copy = in;
+			CLAHE(copy, out, clip_limit, tiles_x, tiles_y);
+			return;
+		}
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		constexpr int C = PixelChannels<frmt, T>();
+		constexpr int levels = static_cast<int>(std::numeric_limits<T>::max()) + 1;
+		const int width = in.width;
+		const int height = in.height;
+		tiles_x = std::min(tiles_x, width);
+		tiles_y = std::min(tiles_y, height);
+
+		// tile t covers [t * size / tiles, (t + 1) * size / tiles)
+		const auto tile_begin = [](int t, int size, int tiles) { return static_cast<int>(static_cast<int64_t>(t) * size / tiles); };
+
+		// mapping of every tile
+		std::vector<T> luts(static_cast<size_t>(tiles_x) * tiles_y * levels);
+
+		detail::ParallelFor(0, tiles_x * tiles_y, 1, [&](int t0, int t1)
+		{
+			std::vector<uint64_t> hist(levels);
+			for (int t = t0; t < t1; t++)
+			{
+				const int tx = t % tiles_x;
+				const int ty = t / tiles_x;
+				const int x0 = tile_begin(tx, width, tiles_x);
+				const int x1 = tile_begin(tx + 1, width, tiles_x);
+				const int y0 = tile_begin(ty, height, tiles_y);
+				const int y1 = tile_begin(ty + 1, height, tiles_y);
+				const uint64_t pixels = static_cast<uint64_t>(x1 - x0) * (y1 - y0);
+
+				std::fill(hist.begin(), hist.end(), 0);
+				detail::CountFirstChannel(in, x0, y0, x1, y1, hist.data());
+
+				const uint64_t clip = clip_limit > 0.0 ? std::max<uint64_t>(1, static_cast<uint64_t>(clip_limit * pixels / levels)) : 0;
+				detail::ClippedEqualizationLut(hist, pixels, clip, luts.data() + static_cast<size_t>(t) * levels);
+			}
+		});
+
+		// tile centers and weights of every column
+		const double tile_width = static_cast<double>(width) / tiles_x;
+		const double tile_height = static_cast<double>(height) / tiles_y;
+		std::vector<int> left(width), right(width);
+		std::vector<float> weight_x(width);
+		for (int x = 0; x < width; x++)
+		{
+			const double t = (x + 0.5) / tile_width - 0.5;
+			const int t1 = static_cast<int>(std::floor(t));
+			weight_x[x] = static_cast<float>(t - t1);
+			left[x] = std::max(t1, 0);
+			right[x] = std::min(t1 + 1, tiles_x - 1);
+		}
+
+		detail::ParallelFor(0, height, 16, [&](int y0, int y1)
+		{
+			for (int y = y0; y < y1; y++)
+			{
+				const double t = (y + 0.5) / tile_height - 0.5;
+				const int t1 = static_cast<int>(std::floor(t));
+				const float wy = static_cast<float>(t - t1);
+				const T* top = luts.data() + static_cast<size_t>(std::max(t1, 0)) * tiles_x * levels;
+				const T* bottom = luts.data() + static_cast<size_t>(std::min(t1 + 1, tiles_y - 1)) * tiles_x * levels;
+
+				const T* src = reinterpret_cast<const T*>(in.GetRow(y));
+				T* dst = reinterpret_cast<T*>(out.GetRow(y));
+				std::copy_n(in.GetRow(y), width, out.GetRow(y));
+
+				for (int x = 0; x < width; x++)
+				{
+					const T v = src[x * C];
+					const size_t l = static_cast<size_t>(left[x]) * levels + v;
+					const size_t r = static_cast<size_t>(right[x]) * levels + v;
+					const float wx = weight_x[x];
+
+					const float a = top[l] + wx * (static_cast<float>(top[r]) - top[l]);
+					const float b = bottom[l] + wx * (static_cast<float>(bottom[r]) - bottom[l]);
+					dst[x * C] = detail::SaturateCast<T>(a + wy * (b - a));
+				}
+			}
+		});
+	}
+
+	template void EqualizeHist(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&);
+	template void EqualizeHist(const Image<ImageFormat::GRAY, uint16_t>&, Image<ImageFormat::GRAY, uint16_t>&);
+	template void EqualizeHist(const Image<ImageFormat::YCrCb, uint8_t>&, Image<ImageFormat::YCrCb, uint8_t>&);
+	template void EqualizeHist(const Image<ImageFormat::YCrCb, uint16_t>&, Image<ImageFormat::YCrCb, uint16_t>&);
+
+	template void CLAHE(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, double, int, int);
+	template void CLAHE(const Image<ImageFormat::GRAY, uint16_t>&, Image<ImageFormat::GRAY, uint16_t>&, double, int, int);
+	template void CLAHE(const Image<ImageFormat::YCrCb, uint8_t>&, Image<ImageFormat::YCrCb, uint8_t>&, double, int, int);
+	template void CLAHE(const Image<ImageFormat::YCrCb, uint16_t>&, Image<ImageFormat::YCrCb, uint16_t>&, double, int, int);
+}
@@ -0,0 +1,256 @@
+#include "filter.hpp"
+#include "bilateral.hpp"
+#include "box_filter.hpp"
+#include "filter2d.hpp"
+#include "gaussian.hpp"
+#include "median.hpp"
+#include "separable.hpp"
+#include <iostream>
+
+namespace qlm
+{
+	template<ImageFormat frmt, pixel_t T>
+	void SepFilter2D(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<float>& kernel_x, const std::vector<float>& kernel_y,
+					 const BorderMode<frmt, T>& border_mode)
+	{
+		// the bands read source rows while other bands write, so the output cannot be the input
+		if (&in == &out)
+		{
+			const Image<frmt, T> copy = in;
+			SepFilter2D(copy, out, kernel_x, kernel_y, border_mode);
+			return;
+		}
+
+		const std::vector<float> identity{ 1.0f };
+		detail::SeparableFilter(in, out, kernel_x.empty() ? identity : kernel_x, kernel_y.empty() ? identity : kernel_y, border_mode);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Filter2D(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<float>& kernel, int kernel_width, int kernel_height,
+				  const BorderMode<frmt, T>& border_mode, FilterMethod method)
+	{
+		if (kernel_width <= 0 || kernel_height <= 0 || kernel.size() != static_cast<size_t>(kernel_width) * kernel_height)
+		{
+			std::cerr << "Error: Filter2D kernel size does not match its dimensions." << std::endl;
+			return;
+		}
+
+		if (&in == &out)
+		{
+			const Image<frmt, T> copy = in;
+			Filter2D(copy, out, kernel, kernel_width, kernel_height, border_mode, method);
+			return;
+		}
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		if (method == FilterMethod::AUTO)
+			method = detail::PreferFft<frmt, T>(in.width, in.height, kernel_width, kernel_height) ? FilterMethod::FFT : FilterMethod::DIRECT;
+
+		DispatchBorder(border_mode.border_type, [&](auto policy)
+		{
+			if (method == FilterMethod::FFT)
+			{
+				detail::Filter2DFft<frmt, T, policy.value>(in, out, kernel, kernel_width, kernel_height, border_mode.border_pixel);
+				return;
+			}
+
+			if constexpr (std::is_same_v<T, uint8_t>)
+			{
+				std::vector<int16_t> quantized;
+				const int shift = detail::QuantizeKernel2D(kernel, quantized);
+				if (shift >= 0)
+				{
+					detail::Filter2DDirectDispatch<frmt, T, policy.value, int16_t, int32_t>(in, out, quantized, kernel_width, kernel_height, shift, border_mode.border_pixel);
+					return;
+				}
+			}
+
+			detail::Filter2DDirectDispatch<frmt, T, policy.value, float, float>(in, out, kernel, kernel_width, kernel_height, 0, border_mode.border_pixel);
+		});
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void BoxFilter(const Image<frmt, T>& in, Image<frmt, T>& out, int kernel_width, int kernel_height,
+				   const BorderMode<frmt, T>& border_mode, bool normalize)
+	{
+		if (kernel_width <= 0 || kernel_height <= 0)
+		{
+			std::cerr << "Error: BoxFilter kernel dimensions must be positive." << std::endl;
+			return;
+		}
+
+		if (&in == &out)
+		{
+			const Image<frmt, T> copy = in;
+			BoxFilter(copy, out, kernel_width, kernel_height, border_mode, normalize);
+			return;
+		}
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		DispatchBorder(border_mode.border_type, [&](auto policy)
+		{
+			detail::BoxFilterRunning<frmt, T, policy.value>(in, out, kernel_width, kernel_height, normalize, border_mode.border_pixel);
+		});
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void GaussianBlur(const Image<frmt, T>& in, Image<frmt, T>& out, float sigma_x, float sigma_y, const BorderMode<frmt, T>& border_mode)
+	{
+		if (sigma_x < 0.0f || sigma_y < 0.0f)
+		{
+			std::cerr << "Error: GaussianBlur sigma must not be negative." << std::endl;
+			return;
+		}
+
+		if (sigma_y == 0.0f)
+			sigma_y = sigma_x;
+
+		if (&in == &out)
+		{
+			const Image<frmt, T> copy = in;
+			GaussianBlur(copy, out, sigma_x, sigma_y, border_mode);
+			return;
+		}
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		// direct kernels up to a radius of 12, beyond that the recursive filter (same cost for any sigma) is faster
+		const double extent = std::is_floating_point_v<T> ? 4.0 : 3.0;
+		const int radius_x = static_cast<int>(std::ceil(extent * sigma_x));
+		const int radius_y = static_cast<int>(std::ceil(extent * sigma_y));
+
+		if (std::max(radius_x, radius_y) > 12 && std::min(sigma_x, sigma_y) >= 0.5f)
+		{
+			DispatchBorder(border_mode.border_type, [&](auto policy)
+			{
+				detail::RecursiveGaussian<frmt, T, policy.value>(in, out, sigma_x, sigma_y, border_mode.border_pixel);
+			});
+			return;
+		}
+
+		const auto kernel = [](float sigma, int radius)
+		{
+			return sigma > 0.0f ? detail::GaussianKernel(sigma, std::max(1, radius)) : std::vector<float>{ 1.0f };
+		};
+
+		detail::SeparableFilter(in, out, kernel(sigma_x, radius_x), kernel(sigma_y, radius_y), border_mode);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void MedianBlur(const Image<frmt, T>& in, Image<frmt, T>& out, int ksize, const BorderMode<frmt, T>& border_mode)
+	{
+		if (ksize <= 0 || ksize % 2 == 0 || ksize > 255)
+		{
+			std::cerr << "Error: MedianBlur kernel size must be odd and at most 255." << std::endl;
+			return;
+		}
+
+		if (&in == &out)
+		{
+			const Image<frmt, T> copy = in;
+			MedianBlur(copy, out, ksize, border_mode);
+			return;
+		}
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		if (ksize == 1)
+		{
+			for (int y = 0; y < in.height; y++)
+				std::copy_n(in.GetRow(y), in.width, out.GetRow(y));
+			return;
+		}
+
+		DispatchBorder(border_mode.border_type, [&](auto policy)
+		{
+			if (ksize <= 5)
+				detail::MedianNetwork<frmt, T, policy.value>(in, out, ksize, border_mode.border_pixel);
+			else if constexpr (sizeof(T) == 1)
+				detail::MedianHistogram8<frmt, policy.value>(in, out, ksize, border_mode.border_pixel);
+			else
+				detail::MedianHistogram16<frmt, policy.value>(in, out, ksize, border_mode.border_pixel);
+		});
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void BilateralFilter(const Image<frmt, T>& in, Image<frmt, T>& out, int diameter, float sigma_color, float sigma_space,
+						 const BorderMode<frmt, T>& border_mode)
+	{
+		if (!(sigma_color > 0.0f) || !(sigma_space > 0.0f))
+		{
+			std::cerr << "Error: BilateralFilter sigmas must be positive." << std::endl;
+			return;
+		}
+
+		if (&in == &out)
+		{
+			const Image<frmt, T> copy = in;
+			BilateralFilter(copy, out, diameter, sigma_color, sigma_space, border_mode);
+			return;
+		}
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		// taps further than 4 sigma_space weigh less than exp(-8) of the center
+		int radius = diameter > 0 ? diameter / 2 : static_cast<int>(std::lround(1.5f * sigma_space));
+		radius = std::max(1, std::min(radius, static_cast<int>(std::ceil(4.0f * sigma_space))));
+
+		// the lattice filters with the whole Gaussian, it only stands in for windows that hold most of it
+		const bool lattice = radius > detail::bilateral_direct_radius && radius >= 3.0f * sigma_space;
+
+		DispatchBorder(border_mode.border_type, [&](auto policy)
+		{
+			if (lattice)
+				detail::BilateralLattice<frmt, T, policy.value>(in, out, radius, sigma_color, sigma_space, border_mode.border_pixel);
+			else
+				detail::BilateralDirect<frmt, T, policy.value>(in, out, radius, sigma_color, sigma_space, border_mode.border_pixel);
+		});
+	}
+
+	template void SepFilter2D(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, const std::vector<float>&, const std::vector<float>&, const BorderMode<ImageFormat::GRAY, uint8_t>&);
+	template void SepFilter2D(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, const std::vector<float>&, const std::vector<float>&, const BorderMode<ImageFormat::GRAY, int16_t>&);
+	template void SepFilter2D(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, const std::vector<float>&, const std::vector<float>&, const BorderMode<ImageFormat::GRAY, float>&);
+	template void SepFilter2D(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, const std::vector<float>&, const std::vector<float>&, const BorderMode<ImageFormat::RGB, uint8_t>&);
+	template void SepFilter2D(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, const std::vector<float>&, const std::vector<float>&, const BorderMode<ImageFormat::RGB, int16_t>&);
+	template void SepFilter2D(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, const std::vector<float>&, const std::vector<float>&, const BorderMode<ImageFormat::RGB, float>&);
+
+	template void Filter2D(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, const std::vector<float>&, int, int, const BorderMode<ImageFormat::GRAY, uint8_t>&, FilterMethod);
+	template void Filter2D(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, const std::vector<float>&, int, int, const BorderMode<ImageFormat::GRAY, int16_t>&, FilterMethod);
+	template void Filter2D(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, const std::vector<float>&, int, int, const BorderMode<ImageFormat::GRAY, float>&, FilterMethod);
+	template void Filter2D(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, const std::vector<float>&, int, int, const BorderMode<ImageFormat::RGB, uint8_t>&, FilterMethod);
+	template void Filter2D(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, const std::vector<float>&, int, int, const BorderMode<ImageFormat::RGB, int16_t>&, FilterMethod);
+	template void Filter2D(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, const std::vector<float>&, int, int, const BorderMode<ImageFormat::RGB, float>&, FilterMethod);
+
+
+	template void BoxFilter(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, int, int, const BorderMode<ImageFormat::GRAY, uint8_t>&, bool);
+	template void BoxFilter(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, int, int, const BorderMode<ImageFormat::GRAY, int16_t>&, bool);
+	template void BoxFilter(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, int, int, const BorderMode<ImageFormat::GRAY, float>&, bool);
+	template void BoxFilter(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, int, int, const BorderMode<ImageFormat::RGB, uint8_t>&, bool);
+	template void BoxFilter(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, int, int, const BorderMode<ImageFormat::RGB, int16_t>&, bool);
+	template void BoxFilter(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, int, int, const BorderMode<ImageFormat::RGB, float>&, bool);
+
+
+	template void GaussianBlur(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, float, float, const BorderMode<ImageFormat::GRAY, uint8_t>&);
+	template void GaussianBlur(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, float, float, const BorderMode<ImageFormat::GRAY, int16_t>&);
+	template void GaussianBlur(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, float, float, const BorderMode<ImageFormat::GRAY, float>&);
+	template void GaussianBlur(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, float, float, const BorderMode<ImageFormat::RGB, uint8_t>&);
+	template void GaussianBlur(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, float, float, const BorderMode<ImageFormat::RGB, int16_t>&);
+	template void GaussianBlur(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, float, float, const BorderMode<ImageFormat::RGB, float>&);
+
+	template void MedianBlur(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, int, const BorderMode<ImageFormat::GRAY, uint8_t>&);
+	template void MedianBlur(const Image<ImageFormat::GRAY, uint16_t>&, Image<ImageFormat::GRAY, uint16_t>&, int, const BorderMode<ImageFormat::GRAY, uint16_t>&);
+	template void MedianBlur(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, int, const BorderMode<ImageFormat::RGB, uint8_t>&);
+	template void MedianBlur(const Image<ImageFormat::RGB, uint16_t>&, Image<ImageFormat::RGB, uint16_t>&, int, const BorderMode<ImageFormat::RGB, uint16_t>&);
+
+	template void BilateralFilter(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, int, float, float, const BorderMode<ImageFormat::GRAY, uint8_t>&);
+	template void BilateralFilter(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, int, float, float, const BorderMode<ImageFormat::GRAY, float>&);
+	template void BilateralFilter(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, int, float, float, const BorderMode<ImageFormat::RGB, uint8_t>&);
+	template void BilateralFilter(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, int, float, float, const BorderMode<ImageFormat::RGB, float>&);
+}
@@ -0,0 +1,174 @@
+#include "histogram.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+
+namespace qlm
+{
+	template<ImageFormat frmt, pixel_t T>
+	void Histogram<frmt, T>::SetBinning(int num_bins, double min_value, double max_value)
+	{
+		if (num_bins <= 0 || !(max_value > min_value))
+		{
+			std::cerr << "Error: Histogram needs at least one bin and a non-empty range." << std::endl;
+			return;
+		}
+
+		bins = num_bins;
+		range_min = min_value;
+		range_max = max_value;
+		counts.assign(static_cast<size_t>(channels) * bins, 0);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Histogram<frmt, T>::Compute(const Image<frmt, T>& in, const Rect& roi)
+	{
+		Count<false>(in, nullptr, roi);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Histogram<frmt, T>::Compute(const Image<frmt, T>& in, const Image<ImageFormat::GRAY, uint8_t>& mask, const Rect& roi)
+	{
+		if (mask.width != in.width || mask.height != in.height)
+		{
+			std::cerr << "Error: Histogram mask size does not match the image." << std::endl;
+			return;
+		}
+
+		Count<true>(in, &mask, roi);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	template<bool masked>
+	void Histogram<frmt, T>::Count(const Image<frmt, T>& in, const Image<ImageFormat::GRAY, uint8_t>* mask, const Rect& roi)
+	{
+		std::fill(counts.begin(), counts.end(), 0);
+
+		// the region clipped to the image
+		const Rect r = roi.width <= 0 || roi.height <= 0 ? Rect{ 0, 0, in.width, in.height } : roi;
+		const int x0 = std::clamp(r.x, 0, in.width);
+		const int y0 = std::clamp(r.y, 0, in.height);
+		const int x1 = std::clamp(r.x + r.width, x0, in.width);
+		const int y1 = std::clamp(r.y + r.height, y0, in.height);
+		const int width = x1 - x0;
+		if (width == 0 || y1 == y0 || bins == 0)
+			return;
+
+		constexpr int C = PixelChannels<frmt, T>();
+		constexpr int mask_step = static_cast<int>(sizeof(Pixel<ImageFormat::GRAY, uint8_t>));
+
+		// every channel has one extra bin that collects the values out of the range
+		const int channel_bins = bins + 1;
+		const int hist_size = channels * channel_bins;
+
+		// integer pixels look their bin up, floating-point pixels compute it
+		std::vector<int32_t> lut;
+		if constexpr (std::is_integral_v<T>)
+		{
+			lut.resize(static_cast<size_t>(std::numeric_limits<T>::max()) + 1);
+			for (size_t v = 0; v < lut.size(); v++)
+			{
+				const int b = Bin(static_cast<double>(v));
+				lut[v] = b < 0 ? bins : b;
+			}
+		}
+
+		const float offset = static_cast<float>(range_min);
+		const float scale = static_cast<float>(bins / (range_max - range_min));
+		const int num_bins = bins;
+		const auto bin_of = [&](T v) -> int
+		{
+			if constexpr (std::is_integral_v<T>)
+			{
+				return lut[v];
+			}
+			else
+			{
+				const float t = (static_cast<float>(v) - offset) * scale;
+				return t >= 0.0f && t < num_bins ? static_cast<int>(t) : num_bins;
+			}
+		};
+
+		// four sub-histograms take consecutive pixels in turn, unless the bins are too many to stay in cache
+		const int copies = bins <= 4096 ? 4 : 1;
+
+		// 32-bit local counters are flushed before they can overflow
+		const int flush_rows = std::max(1, (1 << 30) / width);
+
+		std::mutex merge_mutex;
+
+		detail::ParallelFor(y0, y1, 16, [&](int band_begin, int band_end)
+		{
+			std::vector<uint32_t> local(static_cast<size_t>(copies) * hist_size, 0);
+			std::vector<uint64_t> band(hist_size, 0);
+
+			const auto flush = [&]
+			{
+				for (int k = 0; k < copies; k++)
+				{
+					uint32_t* h = local.data() + static_cast<size_t>(k) * hist_size;
+					for (int i = 0; i < hist_size; i++)
+						band[i] += h[i];
+				}
+				std::fill(local.begin(), local.end(), 0);
+			};
+
+			for (int y = band_begin; y < band_end; y++)
+			{
+				const T* src = reinterpret_cast<const T*>(in.GetRow(y) + x0);
+				const uint8_t* m = masked ? reinterpret_cast<const uint8_t*>(mask->GetRow(y) + x0) : nullptr;
+
+				const auto count_pixel = [&](int x, uint32_t* h)
+				{
+					if constexpr (masked)
+					{
+						if (m[x * mask_step] == 0)
+							return;
+					}
+
+					for (int c = 0; c < channels; c++)
+						h[c * channel_bins + bin_of(src[x * C + c])]++;
+				};
+
+				int x = 0;
+				if (copies == 4)
+				{
+					uint32_t* h0 = local.data();
+					uint32_t* h1 = h0 + hist_size;
+					uint32_t* h2 = h1 + hist_size;
+					uint32_t* h3 = h2 + hist_size;
+					for (; x + 4 <= width; x += 4)
+					{
+						count_pixel(x, h0);
+						count_pixel(x + 1, h1);
+						count_pixel(x + 2, h2);
+						count_pixel(x + 3, h3);
+					}
+				}
+
+				for (; x < width; x++)
+					count_pixel(x, local.data());
+
+				if ((y - band_begin + 1) % flush_rows == 0)
+					flush();
+			}
+
+			flush();
+
+			const std::lock_guard<std::mutex> lock(merge_mutex);
+			for (int c = 0; c < channels; c++)
+			{
+				for (int b = 0; b < bins; b++)
+					counts[static_cast<size_t>(c) * bins + b] += band[c * channel_bins + b];
+			}
+		});
+	}
+
+	template class Histogram<ImageFormat::GRAY, uint8_t>;
+	template class Histogram<ImageFormat::GRAY, uint16_t>;
+	template class Histogram<ImageFormat::GRAY, float>;
+	template class Histogram<ImageFormat::RGB, uint8_t>;
+	template class Histogram<ImageFormat::RGB, uint16_t>;
+	template class Histogram<ImageFormat::RGB, float>;
+}
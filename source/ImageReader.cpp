@@ -0,0 +1,210 @@
+#include "image_reader.hpp"
+#include "row_decoder.hpp"
+#include "transfer.hpp"
+#include <iostream>
+
+namespace qlm
+{
+	// file samples -> pixel channels
+	template<pixel_t T, typename S>
+	static T ConvertSample(S v, bool is_alpha)
+	{
+		if constexpr (std::is_same_v<S, T>)
+		{
+			return v;
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			if constexpr (std::is_same_v<S, uint8_t>)
+			{
+				static const detail::U8ToFloatTable lut{ TransferFunction::SRGB, 0.0f };
+				return is_alpha ? v / T(255) : lut(v);
+			}
+			else
+			{
+				const float f = v / 65535.0f;
+				return is_alpha ? f : detail::DecodeTransfer(f, TransferFunction::SRGB, 0.0f);
+			}
+		}
+		else if constexpr (std::is_floating_point_v<S>)
+		{
+			static const detail::FloatToU8Table lut{ TransferFunction::SRGB, 0.0f };
+			return is_alpha ? detail::LinearToU8(v) : lut(v);
+		}
+		else
+		{
+			// 16 bits file into an 8 bits image
+			return static_cast<T>(v >> 8);
+		}
+	}
+
+	template<ImageFormat frmt, pixel_t T, typename S>
+	static void ConvertRow(const S* src, int comp, int width, Pixel<frmt, T>* dst)
+	{
+		constexpr T opaque = std::is_floating_point_v<T> ? T(1) : std::numeric_limits<T>::max();
+		const bool has_alpha = comp == 2 || comp == 4;
+
+		for (int x = 0; x < width; x++, src += comp)
+		{
+			const T a = has_alpha ? ConvertSample<T>(src[comp - 1], true) : opaque;
+
+			if constexpr (frmt == ImageFormat::GRAY)
+			{
+				// same as LoadFromFile: gray is the first channel
+				dst[x].Set(ConvertSample<T>(src[0], false), a);
+			}
+			else
+			{
+				const T r = ConvertSample<T>(src[0], false);
+				const T g = comp >= 3 ? ConvertSample<T>(src[1], false) : r;
+				const T b = comp >= 3 ? ConvertSample<T>(src[2], false) : r;
+				dst[x].Set(r, g, b, a);
+			}
+		}
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	ImageReader<frmt, T>::ImageReader() : next_row(0)
+	{
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	ImageReader<frmt, T>::~ImageReader() = default;
+
+	template<ImageFormat frmt, pixel_t T>
+	bool ImageReader<frmt, T>::Open(const std::string& file_name)
+	{
+		decoder = detail::RowDecoder::Open(file_name);
+		next_row = 0;
+		return decoder != nullptr;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void ImageReader<frmt, T>::Close()
+	{
+		decoder.reset();
+		sample_buffer.clear();
+		sample_buffer.shrink_to_fit();
+		next_row = 0;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	int ImageReader<frmt, T>::Width() const
+	{
+		return decoder ? decoder->width : 0;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	int ImageReader<frmt, T>::Height() const
+	{
+		return decoder ? decoder->height : 0;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	int ImageReader<frmt, T>::NumerOfChannels() const
+	{
+		return decoder ? decoder->comp : 0;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	bool ImageReader<frmt, T>::SeekRow(int y)
+	{
+		if (decoder == nullptr || y < 0 || y > decoder->height)
+			return false;
+
+		next_row = y;
+		return true;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	int ImageReader<frmt, T>::ReadRows(Pixel<frmt, T>* rows, int num_rows, int row_stride)
+	{
+		if (decoder == nullptr)
+		{
+			std::cerr << "Error: Open() has not been called." << std::endl;
+			return -1;
+		}
+
+		const int width = decoder->width;
+		const int comp = decoder->comp;
+		num_rows = std::min(num_rows, decoder->height - next_row);
+		row_stride = row_stride == 0 ? width : row_stride;
+
+		if (num_rows <= 0)
+			return 0;
+
+		const size_t row_samples = static_cast<size_t>(width) * comp;
+		sample_buffer.resize(row_samples * num_rows * decoder->SampleSize());
+
+		if (!decoder->ReadRows(next_row, num_rows, sample_buffer.data()))
+		{
+			std::cerr << "Error: failed reading rows " << next_row << " to " << next_row + num_rows - 1 << "." << std::endl;
+			return -1;
+		}
+
+		for (int y = 0; y < num_rows; y++)
+		{
+			Pixel<frmt, T>* dst = rows + static_cast<size_t>(y) * row_stride;
+
+			switch (decoder->sample_type)
+			{
+				case detail::SampleType::U8:
+					ConvertRow(sample_buffer.data() + y * row_samples, comp, width, dst);
+					break;
+				case detail::SampleType::U16:
+					ConvertRow(reinterpret_cast<const uint16_t*>(sample_buffer.data()) + y * row_samples, comp, width, dst);
+					break;
+				case detail::SampleType::F32:
+					ConvertRow(reinterpret_cast<const float*>(sample_buffer.data()) + y * row_samples, comp, width, dst);
+					break;
+			}
+		}
+
+		next_row += num_rows;
+		return num_rows;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	int ImageReader<frmt, T>::ReadRows(Image<frmt, T>& band)
+	{
+		if (band.width != Width())
+		{
+			std::cerr << "Error: band width (" << band.width << ") does not match the image width (" << Width() << ")." << std::endl;
+			return -1;
+		}
+
+		return ReadRows(band.GetData(), band.height, band.stride);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	bool ImageReader<frmt, T>::ForEachBand(int band_rows, const std::function<bool(const Image<frmt, T>&, int)>& callback)
+	{
+		if (decoder == nullptr || band_rows <= 0)
+			return false;
+
+		Image<frmt, T> band(Width(), std::min(band_rows, Height() - next_row));
+
+		while (next_row < Height())
+		{
+			const int first_row = next_row;
+			const int count = std::min(band_rows, Height() - next_row);
+
+			// only the last band can be shorter
+			if (count != band.height)
+				band.create(Width(), count);
+
+			if (ReadRows(band) != count)
+				return false;
+
+			if (!callback(band, first_row))
+				break;
+		}
+
+		return true;
+	}
+
+	template class ImageReader<ImageFormat::GRAY, uint8_t>;
+	template class ImageReader<ImageFormat::RGB, uint8_t>;
+	template class ImageReader<ImageFormat::GRAY, float>;
+	template class ImageReader<ImageFormat::RGB, float>;
+}
@@ -0,0 +1,147 @@
+#include "image_writer.hpp"
+#include "row_encoder.hpp"
+#include "transfer.hpp"
+#include <iostream>
+
+namespace qlm
+{
+	template<ImageFormat frmt, pixel_t T>
+	ImageWriter<frmt, T>::ImageWriter() : width(0), height(0), rows_written(0), alpha(false)
+	{
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	ImageWriter<frmt, T>::~ImageWriter()
+	{
+		if (encoder != nullptr)
+			End();
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	bool ImageWriter<frmt, T>::Begin(const std::string& file_name, int img_width, int img_height, bool img_alpha)
+	{
+		if (encoder != nullptr)
+		{
+			std::cerr << "Error: a file is already being written, call End() first." << std::endl;
+			return false;
+		}
+
+		if (img_width <= 0 || img_height <= 0)
+		{
+			std::cerr << "Error: Invalid image dimensions." << std::endl;
+			return false;
+		}
+
+		width = img_width;
+		height = img_height;
+		alpha = img_alpha;
+		rows_written = 0;
+
+		const int comp = (frmt == ImageFormat::GRAY ? 1 : 3) + (alpha ? 1 : 0);
+		row_buffer.resize(static_cast<size_t>(width) * comp);
+
+		encoder = detail::CreateRowEncoder(file_name, width, height, comp);
+		return encoder != nullptr;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	bool ImageWriter<frmt, T>::WriteRows(const Pixel<frmt, T>* rows, int num_rows, int row_stride)
+	{
+		if (encoder == nullptr)
+		{
+			std::cerr << "Error: Begin() has not been called." << std::endl;
+			return false;
+		}
+
+		if (num_rows < 0)
+		{
+			std::cerr << "Error: the number of rows must not be negative." << std::endl;
+			return false;
+		}
+
+		if (num_rows > height - rows_written)
+		{
+			std::cerr << "Error: writing more rows than the declared height." << std::endl;
+			return false;
+		}
+
+		constexpr int ch = PixelChannels<frmt, T>();
+		const int color = frmt == ImageFormat::GRAY ? 1 : 3;
+		const int comp = color + (alpha ? 1 : 0);
+		row_stride = row_stride == 0 ? width : row_stride;
+
+		for (int y = 0; y < num_rows; y++)
+		{
+			const T* src = reinterpret_cast<const T*>(rows + static_cast<size_t>(y) * row_stride);
+
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				static const detail::FloatToU8Table lut{ TransferFunction::SRGB, 0.0f };
+
+				for (int x = 0; x < width; x++, src += ch)
+				{
+					for (int c = 0; c < color; c++)
+						row_buffer[x * comp + c] = lut(static_cast<float>(src[c]));
+
+					if (alpha)
+						row_buffer[x * comp + color] = detail::LinearToU8(static_cast<float>(src[ch - 1]));
+				}
+			}
+			else
+			{
+				for (int x = 0; x < width; x++, src += ch)
+				{
+					for (int c = 0; c < color; c++)
+						row_buffer[x * comp + c] = static_cast<uint8_t>(src[c]);
+
+					if (alpha)
+						row_buffer[x * comp + color] = static_cast<uint8_t>(src[ch - 1]);
+				}
+			}
+
+			if (!encoder->WriteRow(row_buffer.data()))
+			{
+				std::cerr << "Error: failed writing row " << rows_written << "." << std::endl;
+				return false;
+			}
+			rows_written++;
+		}
+
+		return true;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	bool ImageWriter<frmt, T>::WriteRows(const Image<frmt, T>& band)
+	{
+		if (band.width != width)
+		{
+			std::cerr << "Error: band width (" << band.width << ") does not match the output width (" << width << ")." << std::endl;
+			return false;
+		}
+
+		return WriteRows(band.GetData(), band.height, band.stride);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	bool ImageWriter<frmt, T>::End()
+	{
+		if (encoder == nullptr)
+			return false;
+
+		bool status = encoder->Finish();
+		encoder.reset();
+
+		if (rows_written != height)
+		{
+			std::cerr << "Error: " << rows_written << " rows written out of " << height << "." << std::endl;
+			status = false;
+		}
+
+		return status;
+	}
+
+	template class ImageWriter<ImageFormat::GRAY, uint8_t>;
+	template class ImageWriter<ImageFormat::RGB, uint8_t>;
+	template class ImageWriter<ImageFormat::GRAY, float>;
+	template class ImageWriter<ImageFormat::RGB, float>;
+}
@@ -0,0 +1,100 @@
+#include "integral_image.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+
+namespace qlm
+{
+	template<ImageFormat frmt, pixel_t T>
+	void IntegralImage<frmt, T>::Compute(const Image<frmt, T>& in, bool squared)
+	{
+		width = in.width;
+		height = in.height;
+
+		const int row_size = (width + 1) * channels;
+		const size_t table_size = static_cast<size_t>(row_size) * (height + 1);
+
+		sum.resize(table_size);
+		std::fill_n(sum.begin(), row_size, sum_t(0));
+
+		if (squared)
+		{
+			sq_sum.resize(table_size);
+			std::fill_n(sq_sum.begin(), row_size, sq_sum_t(0));
+		}
+		else
+		{
+			sq_sum.clear();
+		}
+
+		// running sums along every row, rows are independent
+		detail::ParallelFor(0, height, 16, [&](int y0, int y1)
+		{
+			for (int y = y0; y < y1; y++)
+			{
+				const T* src = reinterpret_cast<const T*>(in.GetRow(y));
+				sum_t* dst = sum.data() + static_cast<size_t>(y + 1) * row_size;
+
+				sum_t run[channels] = {};
+				for (int c = 0; c < channels; c++)
+					dst[c] = 0;
+
+				for (int x = 0; x < width; x++)
+				{
+					for (int c = 0; c < channels; c++)
+					{
+						run[c] += static_cast<sum_t>(src[x * channels + c]);
+						dst[(x + 1) * channels + c] = run[c];
+					}
+				}
+
+				if (!squared)
+					continue;
+
+				sq_sum_t* sq_dst = sq_sum.data() + static_cast<size_t>(y + 1) * row_size;
+				sq_sum_t sq_run[channels] = {};
+				for (int c = 0; c < channels; c++)
+					sq_dst[c] = 0;
+
+				for (int x = 0; x < width; x++)
+				{
+					for (int c = 0; c < channels; c++)
+					{
+						const sq_sum_t v = static_cast<sq_sum_t>(src[x * channels + c]);
+						sq_run[c] += v * v;
+						sq_dst[(x + 1) * channels + c] = sq_run[c];
+					}
+				}
+			}
+		});
+
+		// then down every column: each thread takes a strip of the row and walks all the rows
+		detail::ParallelFor(0, row_size, 256, [&](int i0, int i1)
+		{
+			for (int y = 2; y <= height; y++)
+			{
+				sum_t* row = sum.data() + static_cast<size_t>(y) * row_size;
+				const sum_t* prev = row - row_size;
+				for (int i = i0; i < i1; i++)
+					row[i] += prev[i];
+			}
+
+			if (!squared)
+				return;
+
+			for (int y = 2; y <= height; y++)
+			{
+				sq_sum_t* row = sq_sum.data() + static_cast<size_t>(y) * row_size;
+				const sq_sum_t* prev = row - row_size;
+				for (int i = i0; i < i1; i++)
+					row[i] += prev[i];
+			}
+		});
+	}
+
+	template class IntegralImage<ImageFormat::GRAY, uint8_t>;
+	template class IntegralImage<ImageFormat::GRAY, int16_t>;
+	template class IntegralImage<ImageFormat::GRAY, float>;
+	template class IntegralImage<ImageFormat::RGB, uint8_t>;
+	template class IntegralImage<ImageFormat::RGB, int16_t>;
+	template class IntegralImage<ImageFormat::RGB, float>;
+}
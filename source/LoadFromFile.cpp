@@ -1,16 +1,96 @@
 #include "image.hpp"
 #include "stb/stb_image.h"
+#include "transfer.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <vector>
 
 namespace qlm
 {
+	// largest width or height accepted, the bound stb_image uses (STBI_MAX_DIMENSIONS)
+	static constexpr int max_dimension = 1 << 24;
+
+	// Portable Float Map: "PF" (RGB) or "Pf" (gray) header, negative scale for little-endian, rows stored bottom-to-top
+	static bool LoadPFM(const std::string& file_name, std::vector<float>& buffer, int& w, int& h, int& n)
+	{
+		std::ifstream input_file(file_name, std::ios::binary | std::ios::ate);
+		if (!input_file.is_open())
+			return false;
+
+		const std::streamoff file_size = input_file.tellg();
+		input_file.seekg(0);
+
+		std::string magic;
+		float scale;
+		input_file >> magic >> w >> h >> scale;
+		input_file.get(); // single whitespace before the raster
+
+		if (!input_file || (magic != "PF" && magic != "Pf") || w <= 0 || h <= 0 || w > max_dimension || h > max_dimension)
+			return false;
+
+		// the raster must be in the file before it is allocated
+		n = magic == "PF" ? 3 : 1;
+		const uint64_t raster_size = static_cast<uint64_t>(w) * h * n * sizeof(float);
+		if (raster_size > static_cast<uint64_t>(file_size - input_file.tellg()))
+			return false;
+
+		buffer.resize(static_cast<size_t>(w) * h * n);
+
+		const size_t row_size = static_cast<size_t>(w) * n;
+		for (int y = h - 1; y >= 0; y--)
+		{
+			input_file.read(reinterpret_cast<char*>(&buffer[y * row_size]), row_size * sizeof(float));
+		}
+
+		if (!input_file)
+			return false;
+
+		const bool file_little = scale < 0.0f;
+		if (file_little != (std::endian::native == std::endian::little))
+		{
+			for (float& v : buffer)
+			{
+				uint32_t bits;
+				std::memcpy(&bits, &v, sizeof(bits));
+				bits = (bits >> 24) | ((bits >> 8) & 0xFF00) | ((bits << 8) & 0xFF0000) | (bits << 24);
+				std::memcpy(&v, &bits, sizeof(bits));
+			}
+		}
+
+		return true;
+	}
+
 	template<ImageFormat frmt, pixel_t T>
 	bool Image<frmt, T>::LoadFromFile(const std::string& file_name)
 	{
 		int w, h, n; // width, height, number of channels
 		T* img_data{ nullptr }; //  pointer to the data
+		std::vector<float> float_data; // float pixels not allocated by stb
+
+		std::string ext = file_name.substr(file_name.find_last_of('.') + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
 
-		if constexpr (std::is_same_v<T, uint8_t>) // U8
+		if (ext == "pfm")
+		{
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				if (!LoadPFM(file_name, float_data, w, h, n))
+				{
+					std::cerr << "Error loading image file " << file_name << ": invalid PFM file" << std::endl;
+					return false;
+				}
+				img_data = float_data.data();
+			}
+			else
+			{
+				std::cerr << "Error loading image file " << file_name << ": PFM requires a floating-point image" << std::endl;
+				return false;
+			}
+		}
+		else if constexpr (std::is_same_v<T, uint8_t>) // U8
 		{
 			img_data = stbi_load(file_name.c_str(), &w, &h, &n, 0);
 		}
@@ -20,7 +100,18 @@ namespace qlm
 		}
 		else // floating-point
 		{
-			img_data = stbi_loadf(file_name.c_str(), &w, &h, &n, 0);
+			if (stbi_is_hdr(file_name.c_str()))
+			{
+				img_data = stbi_loadf(file_name.c_str(), &w, &h, &n, 0);
+			}
+			else if (uint8_t* bytes = stbi_load(file_name.c_str(), &w, &h, &n, 0); bytes != nullptr)
+			{
+				// 8-bit files are sRGB decoded like ConvertToFloat and SaveToFile, stbi_loadf would apply gamma 2.2
+				float_data.resize(static_cast<size_t>(w) * h * n);
+				detail::DecodedToFloat(bytes, float_data.data(), static_cast<size_t>(w) * h, n, detail::U8ToFloatTable(TransferFunction::SRGB, 2.2f));
+				stbi_image_free(bytes);
+				img_data = float_data.data();
+			}
 		}
 
 		if (img_data == nullptr)
@@ -39,7 +130,8 @@ namespace qlm
 			std::cerr << "Error loading image file " << file_name 
 					<< ": Number of channels (" << n << ") is not compatible with the image format (" 
 					<< (frmt == ImageFormat::GRAY ? "GRAY" : "RGB") << ")." << std::endl;
-			stbi_image_free(img_data);
+			if (float_data.empty())
+				stbi_image_free(img_data);
 			return false;
 		}
 
@@ -47,6 +139,9 @@ namespace qlm
 
 		data = new Pixel<frmt, T>[stride * height];
 
+		// opaque alpha when the file has no alpha channel, float data is normalized to [0, 1]
+		constexpr T opaque = std::is_floating_point_v<T> ? T(1) : std::numeric_limits<T>::max();
+
 		// copy data to image object
 		for (int i = 0, idx = 0; i < width * height * n; i += n, idx++)
 		{
@@ -54,7 +149,7 @@ namespace qlm
 			{
 				// Grayscale image: use the first channel and optional alpha channel
 				const T gray = img_data[i];
-				const T alpha = (n == 2 || n == 4) ? img_data[i + n - 1] : std::numeric_limits<T>::max(); // Use max value if no alpha channel
+				const T alpha = (n == 2 || n == 4) ? img_data[i + n - 1] : opaque; // Use max value if no alpha channel
 
 				data[idx].Set(gray, alpha);
 			}
@@ -64,13 +159,14 @@ namespace qlm
 				const T r = img_data[i];
 				const T g = img_data[i + 1];
 				const T b = img_data[i + 2];
-				const T a = (n == 4) ? img_data[i + 3] : std::numeric_limits<T>::max(); // Use max value if no alpha channel
+				const T a = (n == 4) ? img_data[i + 3] : opaque; // Use max value if no alpha channel
 
 				data[idx].Set(r, g, b, a);
 			}
 		}
 
-		stbi_image_free(img_data);
+		if (float_data.empty())
+			stbi_image_free(img_data);
 		return true;
 	}
 
@@ -78,5 +174,7 @@ namespace qlm
 	template bool Image<ImageFormat::RGB, uint8_t>::LoadFromFile(const std::string&);
 	template bool Image<ImageFormat::GRAY, int16_t>::LoadFromFile(const std::string&);
 	template bool Image<ImageFormat::RGB, int16_t>::LoadFromFile(const std::string&);
+	template bool Image<ImageFormat::GRAY, float>::LoadFromFile(const std::string&);
+	template bool Image<ImageFormat::RGB, float>::LoadFromFile(const std::string&);
 }
 
@@ -0,0 +1,246 @@
+#include "image.hpp"
+#include "image_reader.hpp"
+#include "row_decoder.hpp"
+#include "stb/stb_image.h"
+#include "transfer.hpp"
+#include <iostream>
+#include <vector>
+
+namespace qlm
+{
+	// Area (box) downscaling in one pass over the source rows.
+	// Each source pixel overlaps at most two output pixels per axis, so only the current and the next output
+	// rows are accumulated; the full-resolution image never has to be converted.
+	class AreaDownscaler
+	{
+	private:
+		int src_width, src_height;
+		int dst_width, dst_height;
+		int n; // interleaved channels
+
+		// horizontal split of every source column between output columns ox and ox + 1
+		std::vector<int> col_index;
+		std::vector<float> col_weight0;
+		std::vector<float> col_weight1;
+
+		std::vector<float> hrow;
+		std::vector<float> acc;
+		std::vector<float> acc_next;
+		int src_row{ 0 };
+		int dst_row{ 0 };
+
+	public:
+		AreaDownscaler(int src_width, int src_height, int dst_width, int dst_height, int n)
+			: src_width(src_width), src_height(src_height), dst_width(dst_width), dst_height(dst_height), n(n),
+			  col_index(src_width), col_weight0(src_width), col_weight1(src_width),
+			  hrow((dst_width + 1) * n), acc(dst_width * n), acc_next(dst_width * n)
+		{
+			// integer units: a source column is dst_width wide and an output column src_width wide
+			for (int x = 0; x < src_width; x++)
+			{
+				const int64_t start = static_cast<int64_t>(x) * dst_width;
+				const int64_t end = start + dst_width;
+				const int ox = static_cast<int>(start / src_width);
+				const int64_t boundary = static_cast<int64_t>(ox + 1) * src_width;
+
+				col_index[x] = ox;
+				col_weight0[x] = static_cast<float>(std::min(end, boundary) - start) / src_width;
+				col_weight1[x] = static_cast<float>(std::max<int64_t>(end - boundary, 0)) / src_width;
+			}
+		}
+
+		// Feed the next source row, "emit(row, y)" is called for every completed output row
+		template<typename S, typename Emit>
+		void AddRow(const S* row, Emit&& emit)
+		{
+			std::fill(hrow.begin(), hrow.end(), 0.0f);
+
+			for (int x = 0; x < src_width; x++, row += n)
+			{
+				float* out0 = &hrow[col_index[x] * n];
+				float* out1 = out0 + n;
+				const float w0 = col_weight0[x];
+				const float w1 = col_weight1[x];
+
+				for (int c = 0; c < n; c++)
+				{
+					const float v = static_cast<float>(row[c]);
+					out0[c] += w0 * v;
+					out1[c] += w1 * v;
+				}
+			}
+
+			const int64_t start = static_cast<int64_t>(src_row) * dst_height;
+			const int64_t end = start + dst_height;
+			const int64_t boundary = static_cast<int64_t>(dst_row + 1) * src_height;
+
+			const float w0 = static_cast<float>(std::min(end, boundary) - start) / src_height;
+			for (int i = 0; i < dst_width * n; i++)
+				acc[i] += w0 * hrow[i];
+
+			if (end >= boundary)
+			{
+				const float w1 = static_cast<float>(end - boundary) / src_height;
+				for (int i = 0; i < dst_width * n; i++)
+					acc_next[i] = w1 * hrow[i];
+
+				emit(acc.data(), dst_row);
+				std::swap(acc, acc_next);
+				dst_row++;
+			}
+
+			src_row++;
+		}
+	};
+
+	template<ImageFormat frmt, pixel_t T>
+	bool Image<frmt, T>::LoadScaled(const std::string& file_name, int target_width, int target_height)
+	{
+		if (target_width <= 0 && target_height <= 0)
+		{
+			std::cerr << "Error: at least one target dimension must be positive." << std::endl;
+			return false;
+		}
+
+		constexpr T opaque = std::is_floating_point_v<T> ? T(1) : std::numeric_limits<T>::max();
+
+		// pick the output size once the source size is known, keeping the aspect ratio when a dimension is 0
+		const auto prepare = [&](int src_width, int src_height)
+		{
+			int w = target_width > 0 ? target_width : std::max(1, static_cast<int>(static_cast<int64_t>(src_width) * target_height / src_height));
+			int h = target_height > 0 ? target_height : std::max(1, static_cast<int>(static_cast<int64_t>(src_height) * target_width / src_width));
+
+			// only downscaling is done here
+			create(std::min(w, src_width), std::min(h, src_height));
+		};
+
+		// write one output row from the accumulated channels
+		const auto store = [&](const float* acc, int y, int n)
+		{
+			Pixel<frmt, T>* dst = GetRow(y);
+			const bool has_alpha = n == 2 || n == 4;
+
+			const auto cast = [](float v) -> T
+			{
+				if constexpr (std::is_floating_point_v<T>)
+					return static_cast<T>(v);
+				else
+					return static_cast<T>(std::clamp(std::round(v), static_cast<float>(std::numeric_limits<T>::lowest()), static_cast<float>(std::numeric_limits<T>::max())));
+			};
+
+			for (int x = 0; x < width; x++, acc += n)
+			{
+				const T a = has_alpha ? cast(acc[n - 1]) : opaque;
+
+				if constexpr (frmt == ImageFormat::GRAY)
+					dst[x].Set(cast(acc[0]), a);
+				else
+					dst[x].Set(cast(acc[0]), cast(acc[1]), cast(acc[2]), a);
+			}
+		};
+
+		// row-ordered formats are streamed, only a band of rows is decoded at a time
+		if constexpr (std::is_same_v<T, uint8_t> || std::is_floating_point_v<T>)
+		{
+			ImageReader<frmt, T> reader;
+			if (detail::RowDecoder::IsStreamable(file_name) && reader.Open(file_name))
+			{
+				constexpr int n = PixelChannels<frmt, T>();
+				prepare(reader.Width(), reader.Height());
+				num_of_channels = reader.NumerOfChannels();
+
+				AreaDownscaler scaler(reader.Width(), reader.Height(), width, height, n);
+				return reader.ForEachBand(16, [&](const Image<frmt, T>& band, int)
+				{
+					for (int y = 0; y < band.height; y++)
+					{
+						scaler.AddRow(reinterpret_cast<const T*>(band.GetRow(y)), [&](const float* acc, int oy) { store(acc, oy, n); });
+					}
+					return true;
+				});
+			}
+		}
+
+		// other formats: stb decodes the file, the channels are averaged straight from its buffer
+		int w, h, n;
+		void* img_data{ nullptr };
+
+		// floating-point images only take Radiance files as floats, 8-bit files are sRGB decoded row by row
+		// like the streamed ones (stbi_loadf would apply gamma 2.2)
+		bool hdr{ false };
+
+		if constexpr (std::is_same_v<T, uint8_t>)
+		{
+			img_data = stbi_load(file_name.c_str(), &w, &h, &n, 0);
+		}
+		else if constexpr (std::is_same_v<T, int16_t>)
+		{
+			img_data = stbi_load_16(file_name.c_str(), &w, &h, &n, 0);
+		}
+		else if (stbi_is_hdr(file_name.c_str()))
+		{
+			hdr = true;
+			img_data = stbi_loadf(file_name.c_str(), &w, &h, &n, 0);
+		}
+		else
+		{
+			img_data = stbi_load(file_name.c_str(), &w, &h, &n, 0);
+		}
+
+		if (img_data == nullptr)
+		{
+			std::cerr << "Error loading image file " << file_name << ": " << stbi_failure_reason() << std::endl;
+			return false;
+		}
+
+		if (frmt == ImageFormat::RGB && n < 3)
+		{
+			std::cerr << "Error loading image file " << file_name
+					  << ": Number of channels (" << n << ") is not compatible with the image format (RGB)." << std::endl;
+			stbi_image_free(img_data);
+			return false;
+		}
+
+		prepare(w, h);
+		num_of_channels = n;
+
+		AreaDownscaler scaler(w, h, width, height, n);
+		const detail::U8ToFloatTable srgb(TransferFunction::SRGB, 2.2f);
+		std::vector<float> linear_row;
+
+		for (int y = 0; y < h; y++)
+		{
+			const size_t offset = static_cast<size_t>(y) * w * n;
+			const auto emit = [&](const float* acc, int oy) { store(acc, oy, n); };
+
+			if constexpr (std::is_same_v<T, uint8_t>)
+			{
+				scaler.AddRow(static_cast<const uint8_t*>(img_data) + offset, emit);
+			}
+			else if constexpr (std::is_same_v<T, int16_t>)
+			{
+				scaler.AddRow(static_cast<const uint16_t*>(img_data) + offset, emit);
+			}
+			else if (hdr)
+			{
+				scaler.AddRow(static_cast<const float*>(img_data) + offset, emit);
+			}
+			else
+			{
+				linear_row.resize(static_cast<size_t>(w) * n);
+				detail::DecodedToFloat(static_cast<const uint8_t*>(img_data) + offset, linear_row.data(), w, n, srgb);
+				scaler.AddRow(linear_row.data(), emit);
+			}
+		}
+
+		stbi_image_free(img_data);
+		return true;
+	}
+
+	template bool Image<ImageFormat::GRAY, uint8_t>::LoadScaled(const std::string&, int, int);
+	template bool Image<ImageFormat::RGB, uint8_t>::LoadScaled(const std::string&, int, int);
+	template bool Image<ImageFormat::GRAY, int16_t>::LoadScaled(const std::string&, int, int);
+	template bool Image<ImageFormat::RGB, int16_t>::LoadScaled(const std::string&, int, int);
+	template bool Image<ImageFormat::GRAY, float>::LoadScaled(const std::string&, int, int);
+	template bool Image<ImageFormat::RGB, float>::LoadScaled(const std::string&, int, int);
+}
@@ -0,0 +1,57 @@
+#include "lut.hpp"
+#include "parallel.hpp"
+#include <iostream>
+#include <utility>
+
+namespace qlm
+{
+	template<ImageFormat frmt, pixel_t T>
+	void ApplyLUT(const Image<frmt, T>& in, Image<frmt, T>& out, const LookupTable<frmt, T>& lut)
+	{
+		if (in.width <= 0 || in.height <= 0)
+		{
+			std::cerr << "Error: ApplyLUT input image is empty." << std::endl;
+			return;
+		}
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		constexpr int C = LookupTable<frmt, T>::channels;
+
+		detail::ParallelFor(0, in.height, 16, [&](int y0, int y1)
+		{
+			const T* tables[C];
+			for (int c = 0; c < C; c++)
+				tables[c] = lut.Channel(c);
+
+			const int width = in.width;
+
+			for (int y = y0; y < y1; y++)
+			{
+				const T* src = reinterpret_cast<const T*>(in.GetRow(y));
+				T* dst = reinterpret_cast<T*>(out.GetRow(y));
+
+				// the lookups of a pixel are unrolled and independent; in place is element-wise
+				for (int x = 0; x < width; x++)
+				{
+					const T* s = src + x * C;
+					T* d = dst + x * C;
+					[&]<int... c>(std::integer_sequence<int, c...>)
+					{
+						((d[c] = tables[c][s[c]]), ...);
+					}(std::make_integer_sequence<int, C>{});
+				}
+			}
+		});
+	}
+
+	template void ApplyLUT(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, const LookupTable<ImageFormat::GRAY, uint8_t>&);
+	template void ApplyLUT(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, const LookupTable<ImageFormat::RGB, uint8_t>&);
+	template void ApplyLUT(const Image<ImageFormat::HLS, uint8_t>&, Image<ImageFormat::HLS, uint8_t>&, const LookupTable<ImageFormat::HLS, uint8_t>&);
+	template void ApplyLUT(const Image<ImageFormat::HSV, uint8_t>&, Image<ImageFormat::HSV, uint8_t>&, const LookupTable<ImageFormat::HSV, uint8_t>&);
+	template void ApplyLUT(const Image<ImageFormat::YCrCb, uint8_t>&, Image<ImageFormat::YCrCb, uint8_t>&, const LookupTable<ImageFormat::YCrCb, uint8_t>&);
+	template void ApplyLUT(const Image<ImageFormat::GRAY, uint16_t>&, Image<ImageFormat::GRAY, uint16_t>&, const LookupTable<ImageFormat::GRAY, uint16_t>&);
+	template void ApplyLUT(const Image<ImageFormat::RGB, uint16_t>&, Image<ImageFormat::RGB, uint16_t>&, const LookupTable<ImageFormat::RGB, uint16_t>&);
+	template void ApplyLUT(const Image<ImageFormat::YCrCb, uint16_t>&, Image<ImageFormat::YCrCb, uint16_t>&, const LookupTable<ImageFormat::YCrCb, uint16_t>&);
+}
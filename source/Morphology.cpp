@@ -0,0 +1,563 @@
+#include "morphology.hpp"
+#include "neighborhood.hpp"
+#include "parallel.hpp"
+#include "saturate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace qlm
+{
+	namespace detail
+	{
+		struct MinOp
+		{
+			template<typename T>
+			T operator()(T a, T b) const
+			{
+				return std::min(a, b);
+			}
+		};
+
+		struct MaxOp
+		{
+			template<typename T>
+			T operator()(T a, T b) const
+			{
+				return std::max(a, b);
+			}
+		};
+
+		// columns up to this many rows take the extremum of the rows directly, taller ones use van Herk/Gil-Werman
+		// blocks (three passes whatever the height)
+		constexpr int direct_morph_height = 4;
+
+		// dst[i] = op(src[i], src[i + C], ..., src[i + (length - 1) * C]) for "count" pixels of C scalars, src holds
+		// count + length - 1 pixels. Runs double in length, each from two adjacent runs of half the length, and the
+		// last one covers the rest with two overlapping runs: about log2(length) vectorized passes over the row,
+		// where van Herk/Gil-Werman would need three serial scans along it. a and b are scratch rows like src.
+		template<int C, typename T, typename Op>
+		void RunExtremum(const T* src, int count, int length, T* dst, T* a, T* b, Op op)
+		{
+			const int total = count + length - 1;
+			const T* run = src;
+			int run_length = 1;
+
+			while (2 * run_length < length)
+			{
+				T* doubled = run == a ? b : a;
+				const int n = (total - 2 * run_length + 1) * C;
+				const T* next = run + run_length * C;
+				for (int i = 0; i < n; i++)
+					doubled[i] = op(run[i], next[i]);
+
+				run = doubled;
+				run_length *= 2;
+			}
+
+			const int n = count * C;
+			if (run_length == length)
+			{
+				std::copy_n(run, n, dst);
+				return;
+			}
+
+			const T* rest = run + (length - run_length) * C;
+			for (int i = 0; i < n; i++)
+				dst[i] = op(run[i], rest[i]);
+		}
+
+		// Rectangle kw x kh anchored at (ax, ay). Every thread takes a band of rows in chunks: the extended source
+		// rows of a chunk are reduced vertically first, with whole-row vector operations (van Herk/Gil-Werman
+		// blocks of kh rows for tall rectangles), then every output row is reduced horizontally once.
+		template<ImageFormat frmt, pixel_t T, BorderType border_type, typename Op>
+		void MorphRect(const Image<frmt, T>& in, Image<frmt, T>& out, int kw, int kh, int ax, int ay, const Pixel<frmt, T>& border_pixel, Op op)
+		{
+			constexpr int C = PixelChannels<frmt, T>();
+			const int width = in.width;
+			const int height = in.height;
+			const int ext_width = width + kw - 1;
+
+			ParallelFor(0, height, std::max(32, 2 * kh), [&](int y0, int y1)
+			{
+				const int m = ext_width * C;
+				const int rect_w = kw;
+				const int rect_h = kh;
+				const int chunk = std::min(y1 - y0, std::max(32, 2 * rect_h));
+				const int capacity = chunk + rect_h - 1;
+				const bool van_herk = rect_h > direct_morph_height;
+
+				std::vector<Pixel<frmt, T>> ext(static_cast<size_t>(capacity) * ext_width);
+				std::vector<T> g, h;
+				if (van_herk)
+				{
+					g.resize(static_cast<size_t>(capacity) * m);
+					h.resize(static_cast<size_t>(capacity) * m);
+				}
+
+				std::vector<T> column(m), row_a(m), row_b(m);
+
+				for (int cy0 = y0; cy0 < y1; cy0 += chunk)
+				{
+					const int cy1 = std::min(cy0 + chunk, y1);
+					const int rows = cy1 - cy0 + rect_h - 1;
+
+					for (int j = 0; j < rows; j++)
+						LoadExtendedRow<border_type>(in, cy0 - ay + j, -ax, ext_width, border_pixel, ext.data() + static_cast<size_t>(j) * ext_width);
+
+					const T* e = reinterpret_cast<const T*>(ext.data());
+					const auto ext_row = [&](int j) { return e + static_cast<size_t>(j) * m; };
+
+					if (van_herk)
+					{
+						for (int b = 0; b < rows; b += rect_h)
+						{
+							const int last = std::min(b + rect_h, rows) - 1;
+
+							std::copy_n(ext_row(b), m, g.data() + static_cast<size_t>(b) * m);
+							for (int j = b + 1; j <= last; j++)
+							{
+								const T* s = ext_row(j);
+								const T* prev = g.data() + static_cast<size_t>(j - 1) * m;
+								T* d = g.data() + static_cast<size_t>(j) * m;
+								for (int i = 0; i < m; i++)
+									d[i] = op(prev[i], s[i]);
+							}
+
+							std::copy_n(ext_row(last), m, h.data() + static_cast<size_t>(last) * m);
+							for (int j = last - 1; j >= b; j--)
+							{
+								const T* s = ext_row(j);
+								const T* next = h.data() + static_cast<size_t>(j + 1) * m;
+								T* d = h.data() + static_cast<size_t>(j) * m;
+								for (int i = 0; i < m; i++)
+									d[i] = op(next[i], s[i]);
+							}
+						}
+					}
+
+					for (int y = cy0; y < cy1; y++)
+					{
+						const int j = y - cy0;
+						T* col = column.data();
+
+						if (van_herk)
+						{
+							const T* top = h.data() + static_cast<size_t>(j) * m;
+							const T* bottom = g.data() + static_cast<size_t>(j + rect_h - 1) * m;
+							for (int i = 0; i < m; i++)
+								col[i] = op(top[i], bottom[i]);
+						}
+						else
+						{
+							std::copy_n(ext_row(j), m, col);
+							for (int k = 1; k < rect_h; k++)
+							{
+								const T* s = ext_row(j + k);
+								for (int i = 0; i < m; i++)
+									col[i] = op(col[i], s[i]);
+							}
+						}
+
+						RunExtremum<C>(col, width, rect_w, reinterpret_cast<T*>(out.GetRow(y)), row_a.data(), row_b.data(), op);
+					}
+				}
+			});
+		}
+
+		// Horizontal run of an arbitrary structuring element: row ky, first column dx, index of its length
+		struct MorphRun
+		{
+			int ky;
+			int dx;
+			int length;
+		};
+
+		// One step of the run length plan: the extremum over "length" pixels is the extremum of two overlapping
+		// runs of the shorter length of step "from" (from == -1 means the source row itself, length 1)
+		struct MorphLengthStep
+		{
+			int length;
+			int from;
+		};
+
+		// Arbitrary structuring element. Every source row is reduced over all the run lengths of the element, each
+		// length from two overlapping runs of a shorter one, into a ring of kh rows per length; an output row is
+		// then the extremum of one shifted run row per run of the element.
+		template<ImageFormat frmt, pixel_t T, BorderType border_type, typename Op>
+		void MorphGeneral(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<MorphRun>& runs, const std::vector<MorphLengthStep>& steps,
+						  int kw, int kh, const Pixel<frmt, T>& border_pixel, Op op)
+		{
+			constexpr int C = PixelChannels<frmt, T>();
+			const int width = in.width;
+			const int height = in.height;
+			const int ax = kw / 2;
+			const int ay = kh / 2;
+			const int ext_width = width + kw - 1;
+
+			ParallelFor(0, height, std::max(32, 2 * kh), [&](int y0, int y1)
+			{
+				const int m = ext_width * C;
+				const int n = width * C;
+				const int ring = kh;
+				const int num_steps = static_cast<int>(steps.size());
+
+				std::vector<Pixel<frmt, T>> ext(static_cast<size_t>(ring) * ext_width);
+				std::vector<T> reduced(static_cast<size_t>(num_steps) * ring * m);
+
+				const int first_row = y0 - ay;
+				const auto slot = [&](int sy) { return (sy - first_row) % ring; };
+				const auto source = [&](int step, int s) -> const T*
+				{
+					if (step < 0)
+						return reinterpret_cast<const T*>(ext.data() + static_cast<size_t>(s) * ext_width);
+					return reduced.data() + (static_cast<size_t>(step) * ring + s) * m;
+				};
+
+				const auto reduce_row = [&](int sy)
+				{
+					const int s = slot(sy);
+					LoadExtendedRow<border_type>(in, sy, -ax, ext_width, border_pixel, ext.data() + static_cast<size_t>(s) * ext_width);
+
+					for (int k = 0; k < num_steps; k++)
+					{
+						const MorphLengthStep step = steps[k];
+						const int shorter = step.from < 0 ? 1 : steps[step.from].length;
+						const int count = (ext_width - step.length + 1) * C;
+						const T* a = source(step.from, s);
+						const T* b = a + (step.length - shorter) * C;
+						T* d = reduced.data() + (static_cast<size_t>(k) * ring + s) * m;
+						for (int i = 0; i < count; i++)
+							d[i] = op(a[i], b[i]);
+					}
+				};
+
+				for (int sy = first_row; sy < first_row + kh - 1; sy++)
+					reduce_row(sy);
+
+				for (int y = y0; y < y1; y++)
+				{
+					reduce_row(y - ay + kh - 1);
+
+					T* dst = reinterpret_cast<T*>(out.GetRow(y));
+					for (size_t r = 0; r < runs.size(); r++)
+					{
+						const MorphRun run = runs[r];
+						const T* s = source(run.length, slot(y - ay + run.ky)) + run.dx * C;
+						if (r == 0)
+						{
+							std::copy_n(s, n, dst);
+						}
+						else
+						{
+							for (int i = 0; i < n; i++)
+								dst[i] = op(dst[i], s[i]);
+						}
+					}
+				}
+			});
+		}
+
+		// Runs of the element and the plan computing all their lengths; MorphRun::length becomes the index of
+		// the plan step (-1 for single pixels). Returns false for an element without any set entry.
+		inline bool PlanRuns(const std::vector<uint8_t>& element, int kw, int kh, std::vector<MorphRun>& runs, std::vector<MorphLengthStep>& steps)
+		{
+			runs.clear();
+			steps.clear();
+
+			std::vector<int> lengths;
+			for (int ky = 0; ky < kh; ky++)
+			{
+				for (int x = 0; x < kw;)
+				{
+					if (!element[static_cast<size_t>(ky) * kw + x])
+					{
+						x++;
+						continue;
+					}
+
+					int end = x;
+					while (end < kw && element[static_cast<size_t>(ky) * kw + end])
+						end++;
+
+					runs.push_back({ ky, x, end - x });
+					lengths.push_back(end - x);
+					x = end;
+				}
+			}
+
+			if (runs.empty())
+				return false;
+
+			std::sort(lengths.begin(), lengths.end());
+			lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+
+			// every length comes from the longest computed one that covers at least half of it,
+			// doubling first when the longest computed run is too short
+			const auto index_of = [&](int length)
+			{
+				for (size_t k = 0; k < steps.size(); k++)
+				{
+					if (steps[k].length == length)
+						return static_cast<int>(k);
+				}
+				return -1;
+			};
+
+			int longest = 1, longest_step = -1;
+			for (const int length : lengths)
+			{
+				if (length == 1)
+					continue;
+
+				while (2 * longest < length)
+				{
+					steps.push_back({ 2 * longest, longest_step });
+					longest *= 2;
+					longest_step = static_cast<int>(steps.size()) - 1;
+				}
+
+				if (length != longest)
+				{
+					steps.push_back({ length, longest_step });
+					longest = length;
+					longest_step = static_cast<int>(steps.size()) - 1;
+				}
+			}
+
+			for (MorphRun& run : runs)
+				run.length = run.length == 1 ? -1 : index_of(run.length);
+
+			return true;
+		}
+
+		template<ImageFormat frmt, pixel_t T, typename Op>
+		void Morph(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<uint8_t>& element, int kw, int kh,
+				   int iterations, const BorderMode<frmt, T>& border_mode, Op op)
+		{
+			if (kw <= 0 || kh <= 0 || element.size() != static_cast<size_t>(kw) * kh)
+			{
+				std::cerr << "Error: Morphology structuring element must have element_width x element_height entries." << std::endl;
+				return;
+			}
+
+			if (iterations < 0)
+			{
+				std::cerr << "Error: Morphology iterations must not be negative." << std::endl;
+				return;
+			}
+
+			if (&in == &out)
+			{
+				const Image<frmt, T> copy = in;
+				Morph(copy, out, element, kw, kh, iterations, border_mode, op);
+				return;
+			}
+
+			if (out.width != in.width || out.height != in.height)
+				out.create(in.width, in.height);
+
+			if (iterations == 0)
+			{
+				for (int y = 0; y < in.height; y++)
+					std::copy_n(in.GetRow(y), in.width, out.GetRow(y));
+				return;
+			}
+
+			const bool rect = std::all_of(element.begin(), element.end(), [](uint8_t v) { return v != 0; });
+
+			// with replicated borders n passes of a rectangle are one pass of a rectangle n times as large,
+			// less one pixel each time; other borders bring outside pixels in at every pass
+			if (rect && (iterations == 1 || border_mode.border_type == BorderType::BORDER_REPLICATE))
+			{
+				const int w = (kw - 1) * iterations + 1;
+				const int h = (kh - 1) * iterations + 1;
+				DispatchBorder(border_mode.border_type, [&](auto policy)
+				{
+					MorphRect<frmt, T, policy.value>(in, out, w, h, (kw / 2) * iterations, (kh / 2) * iterations, border_mode.border_pixel, op);
+				});
+				return;
+			}
+
+			std::vector<MorphRun> runs;
+			std::vector<MorphLengthStep> steps;
+			if (!rect && !PlanRuns(element, kw, kh, runs, steps))
+			{
+				std::cerr << "Error: Morphology structuring element is empty." << std::endl;
+				return;
+			}
+
+			// iterations alternate between the output and one intermediate image, allocated once
+			Image<frmt, T> temp;
+			if (iterations > 1)
+				temp.create(in.width, in.height);
+
+			DispatchBorder(border_mode.border_type, [&](auto policy)
+			{
+				const Image<frmt, T>* src = &in;
+				for (int i = 0; i < iterations; i++)
+				{
+					// the last pass writes the output
+					Image<frmt, T>* dst = (iterations - 1 - i) % 2 == 0 ? &out : &temp;
+					if (rect)
+						MorphRect<frmt, T, policy.value>(*src, *dst, kw, kh, kw / 2, kh / 2, border_mode.border_pixel, op);
+					else
+						MorphGeneral<frmt, T, policy.value>(*src, *dst, runs, steps, kw, kh, border_mode.border_pixel, op);
+					src = dst;
+				}
+			});
+		}
+
+		// out = a - b on the color channels with saturation, alpha comes from "alpha"
+		template<ImageFormat frmt, pixel_t T>
+		void MorphDifference(const Image<frmt, T>& a, const Image<frmt, T>& b, const Image<frmt, T>& alpha, Image<frmt, T>& out)
+		{
+			constexpr int C = PixelChannels<frmt, T>();
+			using diff_t = std::conditional_t<std::is_floating_point_v<T>, T, int32_t>;
+
+			ParallelFor(0, a.height, 32, [&](int y0, int y1)
+			{
+				const int width = a.width;
+				for (int y = y0; y < y1; y++)
+				{
+					const T* pa = reinterpret_cast<const T*>(a.GetRow(y));
+					const T* pb = reinterpret_cast<const T*>(b.GetRow(y));
+					const T* pl = reinterpret_cast<const T*>(alpha.GetRow(y));
+					T* d = reinterpret_cast<T*>(out.GetRow(y));
+					for (int x = 0; x < width; x++)
+					{
+						for (int c = 0; c < C - 1; c++)
+							d[x * C + c] = SaturateCast<T>(static_cast<diff_t>(pa[x * C + c]) - static_cast<diff_t>(pb[x * C + c]));
+						d[x * C + C - 1] = pl[x * C + C - 1];
+					}
+				}
+			});
+		}
+	}
+
+	std::vector<uint8_t> StructuringElement(MorphShape shape, int width, int height)
+	{
+		if (width <= 0 || height <= 0)
+		{
+			std::cerr << "Error: StructuringElement size must be positive." << std::endl;
+			return {};
+		}
+
+		std::vector<uint8_t> element(static_cast<size_t>(width) * height, 0);
+		const int cx = width / 2;
+		const int cy = height / 2;
+
+		for (int y = 0; y < height; y++)
+		{
+			int x0 = 0, x1 = 0;
+			if (shape == MorphShape::RECT || (shape == MorphShape::CROSS && y == cy))
+			{
+				x1 = width;
+			}
+			else if (shape == MorphShape::CROSS)
+			{
+				x0 = cx;
+				x1 = cx + 1;
+			}
+			else
+			{
+				// half width of the ellipse on this row, the rows of a one row high ellipse are full
+				const int dy = y - cy;
+				const double ry = cy;
+				const int dx = cy > 0 ? static_cast<int>(std::lround(cx * std::sqrt(std::max(0.0, (ry * ry - dy * dy) / (ry * ry))))) : cx;
+				x0 = std::max(cx - dx, 0);
+				x1 = std::min(cx + dx + 1, width);
+			}
+
+			std::fill(element.begin() + static_cast<size_t>(y) * width + x0, element.begin() + static_cast<size_t>(y) * width + x1, 1);
+		}
+
+		return element;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Erode(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<uint8_t>& element, int element_width, int element_height,
+			   int iterations, const BorderMode<frmt, T>& border_mode)
+	{
+		detail::Morph(in, out, element, element_width, element_height, iterations, border_mode, detail::MinOp{});
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Dilate(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<uint8_t>& element, int element_width, int element_height,
+				int iterations, const BorderMode<frmt, T>& border_mode)
+	{
+		detail::Morph(in, out, element, element_width, element_height, iterations, border_mode, detail::MaxOp{});
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void MorphologyEx(const Image<frmt, T>& in, Image<frmt, T>& out, MorphOperation operation, const std::vector<uint8_t>& element,
+					  int element_width, int element_height, int iterations, const BorderMode<frmt, T>& border_mode)
+	{
+		if (&in == &out && operation != MorphOperation::ERODE && operation != MorphOperation::DILATE)
+		{
+			const Image<frmt, T> copy = in;
+			MorphologyEx(copy, out, operation, element, element_width, element_height, iterations, border_mode);
+			return;
+		}
+
+		Image<frmt, T> temp;
+
+		switch (operation)
+		{
+			case MorphOperation::ERODE:
+				Erode(in, out, element, element_width, element_height, iterations, border_mode);
+				break;
+			case MorphOperation::DILATE:
+				Dilate(in, out, element, element_width, element_height, iterations, border_mode);
+				break;
+			case MorphOperation::OPEN:
+				Erode(in, temp, element, element_width, element_height, iterations, border_mode);
+				Dilate(temp, out, element, element_width, element_height, iterations, border_mode);
+				break;
+			case MorphOperation::CLOSE:
+				Dilate(in, temp, element, element_width, element_height, iterations, border_mode);
+				Erode(temp, out, element, element_width, element_height, iterations, border_mode);
+				break;
+			case MorphOperation::GRADIENT:
+				Dilate(in, temp, element, element_width, element_height, iterations, border_mode);
+				Erode(in, out, element, element_width, element_height, iterations, border_mode);
+				if (out.width == in.width && out.height == in.height)
+					detail::MorphDifference(temp, out, in, out);
+				break;
+			case MorphOperation::TOPHAT:
+				Erode(in, temp, element, element_width, element_height, iterations, border_mode);
+				Dilate(temp, out, element, element_width, element_height, iterations, border_mode);
+				if (out.width == in.width && out.height == in.height)
+					detail::MorphDifference(in, out, in, out);
+				break;
+			case MorphOperation::BLACKHAT:
+				Dilate(in, temp, element, element_width, element_height, iterations, border_mode);
+				Erode(temp, out, element, element_width, element_height, iterations, border_mode);
+				if (out.width == in.width && out.height == in.height)
+					detail::MorphDifference(out, in, in, out);
+				break;
+		}
+	}
+
+	template void Erode(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::GRAY, uint8_t>&);
+	template void Erode(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::GRAY, int16_t>&);
+	template void Erode(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::GRAY, float>&);
+	template void Erode(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::RGB, uint8_t>&);
+	template void Erode(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::RGB, int16_t>&);
+	template void Erode(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::RGB, float>&);
+
+	template void Dilate(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::GRAY, uint8_t>&);
+	template void Dilate(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::GRAY, int16_t>&);
+	template void Dilate(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::GRAY, float>&);
+	template void Dilate(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::RGB, uint8_t>&);
+	template void Dilate(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::RGB, int16_t>&);
+	template void Dilate(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::RGB, float>&);
+
+	template void MorphologyEx(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, MorphOperation, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::GRAY, uint8_t>&);
+	template void MorphologyEx(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, MorphOperation, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::GRAY, int16_t>&);
+	template void MorphologyEx(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, MorphOperation, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::GRAY, float>&);
+	template void MorphologyEx(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, MorphOperation, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::RGB, uint8_t>&);
+	template void MorphologyEx(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, MorphOperation, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::RGB, int16_t>&);
+	template void MorphologyEx(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, MorphOperation, const std::vector<uint8_t>&, int, int, int, const BorderMode<ImageFormat::RGB, float>&);
+}
@@ -0,0 +1,104 @@
+#include "padded_image.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace qlm
+{
+	template<ImageFormat frmt, pixel_t T>
+	void PaddedImage<frmt, T>::Pad(const Image<frmt, T>& in, int border_size, const BorderMode<frmt, T>& border_mode)
+	{
+		border = std::max(border_size, 0);
+		width = in.width;
+		height = in.height;
+
+		const int padded_width = width + 2 * border;
+		const int padded_height = height + 2 * border;
+
+		if (storage.width != padded_width || storage.height != padded_height)
+			storage.create(padded_width, padded_height);
+
+		for (int y = 0; y < height; y++)
+			std::copy_n(in.GetRow(y), width, Row(y));
+
+		UpdateBorder(border_mode);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void PaddedImage<frmt, T>::UpdateBorder(const BorderMode<frmt, T>& border_mode)
+	{
+		if (border == 0 || width == 0 || height == 0)
+			return;
+
+		if (border_mode.border_type == BorderType::BORDER_CONSTANT)
+		{
+			const int padded_width = width + 2 * border;
+
+			for (int y = -border; y < 0; y++)
+				std::fill_n(Row(y) - border, padded_width, border_mode.border_pixel);
+
+			for (int y = 0; y < height; y++)
+			{
+				Pixel<frmt, T>* row = Row(y);
+				std::fill_n(row - border, border, border_mode.border_pixel);
+				std::fill_n(row + width, border, border_mode.border_pixel);
+			}
+
+			for (int y = height; y < height + border; y++)
+				std::fill_n(Row(y) - border, padded_width, border_mode.border_pixel);
+
+			return;
+		}
+
+		DispatchBorder(border_mode.border_type, [this](auto policy) { FillBorder<policy.value>(); });
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	template<BorderType border_type>
+	void PaddedImage<frmt, T>::FillBorder()
+	{
+		const int padded_width = width + 2 * border;
+
+		// left and right columns of the interior rows, the source columns are computed once
+		std::vector<int> left(border), right(border);
+		for (int i = 0; i < border; i++)
+		{
+			left[i] = BorderIndex<border_type>(i - border, width);
+			right[i] = BorderIndex<border_type>(width + i, width);
+		}
+
+		for (int y = 0; y < height; y++)
+		{
+			Pixel<frmt, T>* row = Row(y);
+			for (int i = 0; i < border; i++)
+			{
+				row[i - border] = row[left[i]];
+				row[width + i] = row[right[i]];
+			}
+		}
+
+		// top and bottom rows are copies of complete padded rows
+		for (int y = -border; y < 0; y++)
+			std::copy_n(Row(BorderIndex<border_type>(y, height)) - border, padded_width, Row(y) - border);
+
+		for (int y = height; y < height + border; y++)
+			std::copy_n(Row(BorderIndex<border_type>(y, height)) - border, padded_width, Row(y) - border);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void PaddedImage<frmt, T>::CopyInterior(Image<frmt, T>& out) const
+	{
+		if (out.width != width || out.height != height)
+			out.create(width, height);
+
+		for (int y = 0; y < height; y++)
+			std::copy_n(Row(y), width, out.GetRow(y));
+	}
+
+	template class PaddedImage<ImageFormat::GRAY, uint8_t>;
+	template class PaddedImage<ImageFormat::GRAY, int16_t>;
+	template class PaddedImage<ImageFormat::GRAY, int32_t>;
+	template class PaddedImage<ImageFormat::GRAY, float>;
+	template class PaddedImage<ImageFormat::RGB, uint8_t>;
+	template class PaddedImage<ImageFormat::RGB, int16_t>;
+	template class PaddedImage<ImageFormat::RGB, float>;
+}
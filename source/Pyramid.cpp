@@ -0,0 +1,323 @@
+#include "pyramid.hpp"
+#include "parallel.hpp"
+#include "saturate.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace qlm
+{
+	namespace detail
+	{
+		// Sums of the binomial kernels are kept in 32-bit integers for integer pixels
+		template<pixel_t T>
+		using pyramid_acc_t = std::conditional_t<std::is_floating_point_v<T>, T, int32_t>;
+
+		// Fused 5-tap binomial blur [1 4 6 4 1] / 16 and 2x decimation. The five source rows of an output row
+		// are summed over the whole width, then the horizontal kernel is only evaluated at the kept columns.
+		template<ImageFormat frmt, pixel_t T, BorderType border_type>
+		void PyramidDown(const Pixel<frmt, T>* src, int sw, int sh, Pixel<frmt, T>* dst, int dw, int dh, const Pixel<frmt, T>& border_pixel)
+		{
+			using acc_t = pyramid_acc_t<T>;
+			constexpr int C = PixelChannels<frmt, T>();
+
+			ParallelFor(0, dh, 16, [&](int y0, int y1)
+			{
+				const int n = sw * C;
+				const std::vector<Pixel<frmt, T>> constant_row(sw, border_pixel);
+				const T* border_scalars = reinterpret_cast<const T*>(&border_pixel);
+
+				// vertical sums with two extended columns on each side
+				std::vector<acc_t> sums((sw + 4) * C);
+				acc_t* v = sums.data() + 2 * C;
+
+				for (int y = y0; y < y1; y++)
+				{
+					const T* r[5];
+					for (int k = 0; k < 5; k++)
+					{
+						const int sy = BorderIndex<border_type>(2 * y - 2 + k, sh);
+						r[k] = reinterpret_cast<const T*>(sy < 0 ? constant_row.data() : src + static_cast<size_t>(sy) * sw);
+					}
+
+					for (int i = 0; i < n; i++)
+					{
+						v[i] = static_cast<acc_t>(r[0][i]) + static_cast<acc_t>(r[4][i]) + 4 * (static_cast<acc_t>(r[1][i]) + static_cast<acc_t>(r[3][i])) +
+							   6 * static_cast<acc_t>(r[2][i]);
+					}
+
+					for (int x : { -2, -1, sw, sw + 1 })
+					{
+						const int sx = BorderIndex<border_type>(x, sw);
+						for (int c = 0; c < C; c++)
+							v[x * C + c] = sx < 0 ? 16 * static_cast<acc_t>(border_scalars[c]) : v[sx * C + c];
+					}
+
+					T* out = reinterpret_cast<T*>(dst + static_cast<size_t>(y) * dw);
+					for (int x = 0; x < dw; x++)
+					{
+						const acc_t* s = v + 2 * x * C;
+						for (int c = 0; c < C; c++)
+						{
+							const acc_t sum = s[c - 2 * C] + s[c + 2 * C] + 4 * (s[c - C] + s[c + C]) + 6 * s[c];
+							if constexpr (std::is_floating_point_v<acc_t>)
+								out[x * C + c] = static_cast<T>(sum * acc_t(1.0 / 256.0));
+							else
+								out[x * C + c] = SaturateCast<T>((sum + 128) >> 8);
+						}
+					}
+				}
+			});
+		}
+
+		// 2x expansion to dw x dh (2 * sw - 1 <= dw <= 2 * sw, same for the height): zeros inserted between the
+		// pixels and the binomial kernel scaled by 4, evaluated as the even (1 6 1) / 8 and odd (4 4) / 8 phases.
+		// func(y, row) receives the dw * channels expanded values of every output row, rounded for integers.
+		template<ImageFormat frmt, pixel_t T, BorderType border_type, typename Func>
+		void PyramidUp(const Pixel<frmt, T>* src, int sw, int sh, int dw, int dh, const Pixel<frmt, T>& border_pixel, Func&& func)
+		{
+			using acc_t = pyramid_acc_t<T>;
+			constexpr int C = PixelChannels<frmt, T>();
+
+			ParallelFor(0, dh, 16, [&](int y0, int y1)
+			{
+				const int n = sw * C;
+				const std::vector<Pixel<frmt, T>> constant_row(sw, border_pixel);
+				const T* border_scalars = reinterpret_cast<const T*>(&border_pixel);
+
+				std::vector<acc_t> sums((sw + 2) * C);
+				acc_t* v = sums.data() + C;
+				std::vector<acc_t> row(static_cast<size_t>(dw) * C);
+
+				const auto source_row = [&](int sy)
+				{
+					sy = BorderIndex<border_type>(sy, sh);
+					return reinterpret_cast<const T*>(sy < 0 ? constant_row.data() : src + static_cast<size_t>(sy) * sw);
+				};
+
+				for (int y = y0; y < y1; y++)
+				{
+					const int i = y / 2;
+					if (y % 2 == 0)
+					{
+						const T* r0 = source_row(i - 1);
+						const T* r1 = source_row(i);
+						const T* r2 = source_row(i + 1);
+						for (int k = 0; k < n; k++)
+							v[k] = static_cast<acc_t>(r0[k]) + static_cast<acc_t>(r2[k]) + 6 * static_cast<acc_t>(r1[k]);
+					}
+					else
+					{
+						const T* r0 = source_row(i);
+						const T* r1 = source_row(i + 1);
+						for (int k = 0; k < n; k++)
+							v[k] = 4 * (static_cast<acc_t>(r0[k]) + static_cast<acc_t>(r1[k]));
+					}
+
+					for (int x : { -1, sw })
+					{
+						const int sx = BorderIndex<border_type>(x, sw);
+						for (int c = 0; c < C; c++)
+							v[x * C + c] = sx < 0 ? 8 * static_cast<acc_t>(border_scalars[c]) : v[sx * C + c];
+					}
+
+					// even and odd output columns of every source column
+					const auto scale = [](acc_t sum)
+					{
+						if constexpr (std::is_floating_point_v<acc_t>)
+							return sum * acc_t(1.0 / 64.0);
+						else
+							return (sum + 32) >> 6;
+					};
+
+					const int pairs = dw / 2;
+					for (int x = 0; x < pairs; x++)
+					{
+						const acc_t* s = v + x * C;
+						acc_t* d = row.data() + 2 * x * C;
+						for (int c = 0; c < C; c++)
+						{
+							d[c] = scale(s[c - C] + s[c + C] + 6 * s[c]);
+							d[c + C] = scale(4 * (s[c] + s[c + C]));
+						}
+					}
+
+					if (dw % 2 != 0)
+					{
+						const acc_t* s = v + pairs * C;
+						for (int c = 0; c < C; c++)
+							row[2 * pairs * C + c] = scale(s[c - C] + s[c + C] + 6 * s[c]);
+					}
+
+					func(y, row.data());
+				}
+			});
+		}
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Pyramid<frmt, T>::Create(const Image<frmt, T>& in, int num_levels, const BorderMode<frmt, T>& border_mode)
+	{
+		if (in.width <= 0 || in.height <= 0)
+		{
+			std::cerr << "Error: Pyramid input image is empty." << std::endl;
+			return;
+		}
+
+		border = border_mode;
+
+		// level sizes and offsets, down to 1x1 at most
+		widths.assign(1, in.width);
+		heights.assign(1, in.height);
+		while ((num_levels <= 0 || static_cast<int>(widths.size()) < num_levels) && (widths.back() > 1 || heights.back() > 1))
+		{
+			widths.push_back((widths.back() + 1) / 2);
+			heights.push_back((heights.back() + 1) / 2);
+		}
+
+		levels = static_cast<int>(widths.size());
+		offsets.resize(levels + 1);
+		offsets[0] = 0;
+		for (int level = 0; level < levels; level++)
+			offsets[level + 1] = offsets[level] + static_cast<size_t>(widths[level]) * heights[level];
+
+		gaussian.resize(offsets[levels]);
+		laplacian.clear();
+		laplacian_built.assign(levels, false);
+
+		for (int y = 0; y < in.height; y++)
+			std::copy_n(in.GetRow(y), in.width, Row(0, y));
+
+		built = 1;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Pyramid<frmt, T>::BuildLevel(int level)
+	{
+		level = std::min(level, levels - 1);
+
+		DispatchBorder(border.border_type, [&](auto policy)
+		{
+			for (; built <= level; built++)
+			{
+				detail::PyramidDown<frmt, T, policy.value>(Row(built - 1, 0), widths[built - 1], heights[built - 1], Row(built, 0), widths[built],
+														   heights[built], border.border_pixel);
+			}
+		});
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Pyramid<frmt, T>::BuildLaplacianLevel(int level)
+	{
+		if (level < 0 || level >= levels || laplacian_built[level])
+			return;
+
+		if (laplacian.empty())
+			laplacian.resize(offsets[levels]);
+
+		constexpr int C = PixelChannels<frmt, T>();
+		const int n = widths[level] * C;
+
+		// the last level is the Gaussian level itself
+		if (level == levels - 1)
+		{
+			BuildLevel(level);
+			for (int y = 0; y < heights[level]; y++)
+			{
+				const T* g = reinterpret_cast<const T*>(Row(level, y));
+				lap_t* l = reinterpret_cast<lap_t*>(LaplacianRow(level, y));
+				for (int i = 0; i < n; i++)
+					l[i] = static_cast<lap_t>(g[i]);
+			}
+
+			laplacian_built[level] = true;
+			return;
+		}
+
+		BuildLevel(level + 1);
+
+		DispatchBorder(border.border_type, [&](auto policy)
+		{
+			detail::PyramidUp<frmt, T, policy.value>(Row(level + 1, 0), widths[level + 1], heights[level + 1], widths[level], heights[level],
+													 border.border_pixel, [&](int y, const detail::pyramid_acc_t<T>* up)
+			{
+				const T* g = reinterpret_cast<const T*>(Row(level, y));
+				lap_t* l = reinterpret_cast<lap_t*>(LaplacianRow(level, y));
+				for (int i = 0; i < n; i++)
+					l[i] = static_cast<lap_t>(static_cast<lap_t>(g[i]) - static_cast<lap_t>(up[i]));
+			});
+		});
+
+		laplacian_built[level] = true;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Pyramid<frmt, T>::Collapse(Image<frmt, T>& out) const
+	{
+		if (levels == 0 || std::find(laplacian_built.begin(), laplacian_built.end(), false) != laplacian_built.end())
+		{
+			std::cerr << "Error: Pyramid Collapse requires all the Laplacian levels." << std::endl;
+			return;
+		}
+
+		constexpr int C = PixelChannels<frmt, T>();
+
+		// current reconstructed level, starting from the last one
+		int level = levels - 1;
+		std::vector<Pixel<frmt, T>> current(static_cast<size_t>(widths[level]) * heights[level]);
+		{
+			const lap_t* l = reinterpret_cast<const lap_t*>(LaplacianRow(level, 0));
+			T* dst = reinterpret_cast<T*>(current.data());
+			for (size_t i = 0; i < current.size() * C; i++)
+				dst[i] = detail::SaturateCast<T>(l[i]);
+		}
+
+		for (level = levels - 2; level >= 0; level--)
+		{
+			std::vector<Pixel<frmt, T>> next(static_cast<size_t>(widths[level]) * heights[level]);
+			const int n = widths[level] * C;
+
+			DispatchBorder(border.border_type, [&](auto policy)
+			{
+				detail::PyramidUp<frmt, T, policy.value>(current.data(), widths[level + 1], heights[level + 1], widths[level], heights[level],
+														 border.border_pixel, [&](int y, const detail::pyramid_acc_t<T>* up)
+				{
+					const lap_t* l = reinterpret_cast<const lap_t*>(LaplacianRow(level, y));
+					T* dst = reinterpret_cast<T*>(next.data() + static_cast<size_t>(y) * widths[level]);
+					for (int i = 0; i < n; i++)
+						dst[i] = detail::SaturateCast<T>(static_cast<detail::pyramid_acc_t<T>>(l[i]) + up[i]);
+				});
+			});
+
+			current = std::move(next);
+		}
+
+		if (out.width != widths[0] || out.height != heights[0])
+			out.create(widths[0], heights[0]);
+
+		for (int y = 0; y < heights[0]; y++)
+			std::copy_n(current.data() + static_cast<size_t>(y) * widths[0], widths[0], out.GetRow(y));
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Pyramid<frmt, T>::CopyLevel(int level, Image<frmt, T>& out) const
+	{
+		if (level < 0 || level >= built)
+		{
+			std::cerr << "Error: Pyramid level " << level << " is not built." << std::endl;
+			return;
+		}
+
+		if (out.width != widths[level] || out.height != heights[level])
+			out.create(widths[level], heights[level]);
+
+		for (int y = 0; y < heights[level]; y++)
+			std::copy_n(Row(level, y), widths[level], out.GetRow(y));
+	}
+
+	template class Pyramid<ImageFormat::GRAY, uint8_t>;
+	template class Pyramid<ImageFormat::GRAY, int16_t>;
+	template class Pyramid<ImageFormat::GRAY, float>;
+	template class Pyramid<ImageFormat::RGB, uint8_t>;
+	template class Pyramid<ImageFormat::RGB, int16_t>;
+	template class Pyramid<ImageFormat::RGB, float>;
+}
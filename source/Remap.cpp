@@ -0,0 +1,231 @@
+#include "geometry.hpp"
+#include "parallel.hpp"
+#include "warp.hpp"
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace qlm
+{
+	namespace detail
+	{
+		// Row segments converted at once from floating-point maps
+		constexpr int remap_chunk = 256;
+
+		inline int16_t ClampCoordinate16(int v)
+		{
+			return static_cast<int16_t>(std::clamp(v, int(std::numeric_limits<int16_t>::min()), int(std::numeric_limits<int16_t>::max())));
+		}
+
+		template<BorderType border_type, ImageFormat frmt, pixel_t T>
+		void RemapRows(const Image<frmt, T>& in, Image<frmt, T>& out, const float* map_x, const float* map_y, Interpolation interpolation,
+					   const Pixel<frmt, T>& border_pixel)
+		{
+			const int width = out.width;
+			const bool nearest = interpolation == Interpolation::NEAREST;
+
+			ParallelFor(0, out.height, 16, [&](int y0, int y1)
+			{
+				std::vector<int> sx(remap_chunk), sy(remap_chunk);
+				std::vector<uint16_t> frac(remap_chunk);
+
+				for (int y = y0; y < y1; y++)
+				{
+					const float* mx = map_x + static_cast<size_t>(y) * width;
+					const float* my = map_y + static_cast<size_t>(y) * width;
+					Pixel<frmt, T>* dst = out.GetRow(y);
+
+					// floating-point pixels sample the float maps directly
+					if constexpr (std::is_floating_point_v<T>)
+					{
+						if (!nearest)
+						{
+							RemapBilinearFloat<border_type>(in, mx, my, width, border_pixel, dst);
+							continue;
+						}
+					}
+
+					for (int x0 = 0; x0 < width; x0 += remap_chunk)
+					{
+						const int count = std::min(remap_chunk, width - x0);
+						if (nearest)
+						{
+							for (int i = 0; i < count; i++)
+							{
+								sx[i] = ClampCoordinate(mx[x0 + i] + 0.5);
+								sy[i] = ClampCoordinate(my[x0 + i] + 0.5);
+							}
+
+							RemapNearest<border_type>(in, sx.data(), sy.data(), count, border_pixel, dst + x0);
+						}
+						else
+						{
+							for (int i = 0; i < count; i++)
+							{
+								const int iu = ClampCoordinate(mx[x0 + i] * remap_frac_size + 0.5);
+								const int iv = ClampCoordinate(my[x0 + i] * remap_frac_size + 0.5);
+								sx[i] = iu >> remap_frac_bits;
+								sy[i] = iv >> remap_frac_bits;
+								frac[i] = static_cast<uint16_t>((iv & (remap_frac_size - 1)) * remap_frac_size + (iu & (remap_frac_size - 1)));
+							}
+
+							RemapBilinearFixed<border_type>(in, sx.data(), sy.data(), frac.data(), count, border_pixel, dst + x0);
+						}
+					}
+				}
+			});
+		}
+
+		template<BorderType border_type, ImageFormat frmt, pixel_t T>
+		void RemapCompact(const Image<frmt, T>& in, Image<frmt, T>& out, const RemapMap& map, const Pixel<frmt, T>& border_pixel)
+		{
+			const bool nearest = map.GetInterpolation() == Interpolation::NEAREST;
+
+			ParallelFor(0, out.height, 16, [&](int y0, int y1)
+			{
+				for (int y = y0; y < y1; y++)
+				{
+					if (nearest)
+						RemapNearest<border_type>(in, map.RowX(y), map.RowY(y), out.width, border_pixel, out.GetRow(y));
+					else
+						RemapBilinearFixed<border_type>(in, map.RowX(y), map.RowY(y), map.RowFraction(y), out.width, border_pixel, out.GetRow(y));
+				}
+			});
+		}
+	}
+
+	bool RemapMap::Build(const std::vector<float>& x, const std::vector<float>& y, int map_width, int map_height, Interpolation map_interpolation)
+	{
+		const size_t size = static_cast<size_t>(std::max(map_width, 0)) * std::max(map_height, 0);
+		if (map_width <= 0 || map_height <= 0 || x.size() != size || y.size() != size)
+		{
+			std::cerr << "Error: RemapMap maps do not match their dimensions." << std::endl;
+			return false;
+		}
+
+		if (map_interpolation != Interpolation::NEAREST && map_interpolation != Interpolation::BILINEAR)
+		{
+			std::cerr << "Error: RemapMap supports NEAREST and BILINEAR interpolation only." << std::endl;
+			return false;
+		}
+
+		width = map_width;
+		height = map_height;
+		interpolation = map_interpolation;
+		map_x.resize(size);
+		map_y.resize(size);
+
+		const bool nearest = interpolation == Interpolation::NEAREST;
+		if (nearest)
+			fraction.clear();
+		else
+			fraction.resize(size);
+
+		detail::ParallelFor(0, height, 64, [&](int y0, int y1)
+		{
+			for (size_t i = static_cast<size_t>(y0) * width; i < static_cast<size_t>(y1) * width; i++)
+			{
+				if (nearest)
+				{
+					map_x[i] = detail::ClampCoordinate16(detail::ClampCoordinate(x[i] + 0.5));
+					map_y[i] = detail::ClampCoordinate16(detail::ClampCoordinate(y[i] + 0.5));
+					continue;
+				}
+
+				const int iu = detail::ClampCoordinate(x[i] * detail::remap_frac_size + 0.5);
+				const int iv = detail::ClampCoordinate(y[i] * detail::remap_frac_size + 0.5);
+				constexpr int mask = detail::remap_frac_size - 1;
+				map_x[i] = detail::ClampCoordinate16(iu >> detail::remap_frac_bits);
+				map_y[i] = detail::ClampCoordinate16(iv >> detail::remap_frac_bits);
+				fraction[i] = static_cast<uint16_t>((iv & mask) * detail::remap_frac_size + (iu & mask));
+			}
+		});
+
+		return true;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Remap(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<float>& map_x, const std::vector<float>& map_y, int map_width,
+			   int map_height, Interpolation interpolation, const BorderMode<frmt, T>& border_mode)
+	{
+		const size_t size = static_cast<size_t>(std::max(map_width, 0)) * std::max(map_height, 0);
+		if (map_width <= 0 || map_height <= 0 || map_x.size() != size || map_y.size() != size)
+		{
+			std::cerr << "Error: Remap maps do not match their dimensions." << std::endl;
+			return;
+		}
+
+		if (interpolation != Interpolation::NEAREST && interpolation != Interpolation::BILINEAR)
+		{
+			std::cerr << "Error: Remap supports NEAREST and BILINEAR interpolation only." << std::endl;
+			return;
+		}
+
+		if (in.width <= 0 || in.height <= 0)
+		{
+			std::cerr << "Error: Remap input image is empty." << std::endl;
+			return;
+		}
+
+		// the rows gather from anywhere in the source, so the output cannot be the input
+		if (&in == &out)
+		{
+			const Image<frmt, T> copy = in;
+			Remap(copy, out, map_x, map_y, map_width, map_height, interpolation, border_mode);
+			return;
+		}
+
+		if (out.width != map_width || out.height != map_height)
+			out.create(map_width, map_height);
+
+		DispatchBorder(border_mode.border_type, [&](auto policy)
+		{
+			detail::RemapRows<policy.value>(in, out, map_x.data(), map_y.data(), interpolation, border_mode.border_pixel);
+		});
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Remap(const Image<frmt, T>& in, Image<frmt, T>& out, const RemapMap& map, const BorderMode<frmt, T>& border_mode)
+	{
+		if (map.Width() <= 0 || map.Height() <= 0)
+		{
+			std::cerr << "Error: Remap map is empty." << std::endl;
+			return;
+		}
+
+		if (in.width <= 0 || in.height <= 0)
+		{
+			std::cerr << "Error: Remap input image is empty." << std::endl;
+			return;
+		}
+
+		if (&in == &out)
+		{
+			const Image<frmt, T> copy = in;
+			Remap(copy, out, map, border_mode);
+			return;
+		}
+
+		if (out.width != map.Width() || out.height != map.Height())
+			out.create(map.Width(), map.Height());
+
+		DispatchBorder(border_mode.border_type, [&](auto policy)
+		{
+			detail::RemapCompact<policy.value>(in, out, map, border_mode.border_pixel);
+		});
+	}
+
+	template void Remap(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, const std::vector<float>&, const std::vector<float>&, int, int, Interpolation, const BorderMode<ImageFormat::GRAY, uint8_t>&);
+	template void Remap(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, const std::vector<float>&, const std::vector<float>&, int, int, Interpolation, const BorderMode<ImageFormat::GRAY, int16_t>&);
+	template void Remap(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, const std::vector<float>&, const std::vector<float>&, int, int, Interpolation, const BorderMode<ImageFormat::GRAY, float>&);
+	template void Remap(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, const std::vector<float>&, const std::vector<float>&, int, int, Interpolation, const BorderMode<ImageFormat::RGB, uint8_t>&);
+	template void Remap(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, const std::vector<float>&, const std::vector<float>&, int, int, Interpolation, const BorderMode<ImageFormat::RGB, int16_t>&);
+	template void Remap(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, const std::vector<float>&, const std::vector<float>&, int, int, Interpolation, const BorderMode<ImageFormat::RGB, float>&);
+
+	template void Remap(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, const RemapMap&, const BorderMode<ImageFormat::GRAY, uint8_t>&);
+	template void Remap(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, const RemapMap&, const BorderMode<ImageFormat::GRAY, int16_t>&);
+	template void Remap(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, const RemapMap&, const BorderMode<ImageFormat::GRAY, float>&);
+	template void Remap(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, const RemapMap&, const BorderMode<ImageFormat::RGB, uint8_t>&);
+	template void Remap(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, const RemapMap&, const BorderMode<ImageFormat::RGB, int16_t>&);
+	template void Remap(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, const RemapMap&, const BorderMode<ImageFormat::RGB, float>&);
+}
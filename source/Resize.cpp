@@ -0,0 +1,45 @@
+#include "geometry.hpp"
+#include "resample.hpp"
+#include <iostream>
+
+namespace qlm
+{
+	template<ImageFormat frmt, pixel_t T>
+	void Resize(const Image<frmt, T>& in, Image<frmt, T>& out, int width, int height, Interpolation interpolation)
+	{
+		if (width <= 0 || height <= 0)
+		{
+			std::cerr << "Error: Resize size must be positive." << std::endl;
+			return;
+		}
+
+		if (in.width <= 0 || in.height <= 0)
+		{
+			std::cerr << "Error: Resize input image is empty." << std::endl;
+			return;
+		}
+
+		// the bands read source rows while other bands write, so the output cannot be the input
+		if (&in == &out)
+		{
+			const Image<frmt, T> copy = in;
+			Resize(copy, out, width, height, interpolation);
+			return;
+		}
+
+		if (out.width != width || out.height != height)
+			out.create(width, height);
+
+		if (interpolation == Interpolation::NEAREST)
+			detail::ResampleNearest(in, out);
+		else
+			detail::ResampleSeparable(in, out, interpolation);
+	}
+
+	template void Resize(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, int, int, Interpolation);
+	template void Resize(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, int, int, Interpolation);
+	template void Resize(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, int, int, Interpolation);
+	template void Resize(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, int, int, Interpolation);
+	template void Resize(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, int, int, Interpolation);
+	template void Resize(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, int, int, Interpolation);
+}
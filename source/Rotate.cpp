@@ -0,0 +1,272 @@
+#include "geometry.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+
+namespace qlm
+{
+	namespace detail
+	{
+		// Tile side in pixels: the source rows and destination rows of a tile stay in L1 for every pixel size
+		constexpr int transpose_tile = 32;
+
+		// out(x, y) = in(sy, sx) with sy = x (height - 1 - x when flip_rows) and sx = y (width - 1 - y when flip_cols),
+		// which covers the transpose and both quarter turns. Tiles of transpose_tile rows are spread over threads.
+		template<bool flip_rows, bool flip_cols, ImageFormat frmt, pixel_t T>
+		void TransposeTiles(const Image<frmt, T>& in, Image<frmt, T>& out)
+		{
+			const int in_width = in.width;
+			const int in_height = in.height;
+			const int tiles = (in_width + transpose_tile - 1) / transpose_tile;
+
+			ParallelFor(0, tiles, 1, [&](int t0, int t1)
+			{
+				const Pixel<frmt, T>* rows[transpose_tile];
+
+				for (int y0 = t0 * transpose_tile; y0 < std::min(t1 * transpose_tile, in_width); y0 += transpose_tile)
+				{
+					const int y1 = std::min(y0 + transpose_tile, in_width);
+
+					for (int x0 = 0; x0 < in_height; x0 += transpose_tile)
+					{
+						const int count = std::min(transpose_tile, in_height - x0);
+						for (int i = 0; i < count; i++)
+							rows[i] = in.GetRow(flip_rows ? in_height - 1 - (x0 + i) : x0 + i);
+
+						for (int y = y0; y < y1; y++)
+						{
+							const int sx = flip_cols ? in_width - 1 - y : y;
+							Pixel<frmt, T>* dst = out.GetRow(y) + x0;
+							for (int i = 0; i < count; i++)
+								dst[i] = rows[i][sx];
+						}
+					}
+				}
+			});
+		}
+
+		// In-place transpose of a square image: tile (i, j) is swapped with tile (j, i), the diagonal tiles
+		// with themselves. Each thread owns whole tile rows, so no pair is touched twice.
+		template<ImageFormat frmt, pixel_t T>
+		void TransposeSquareInPlace(Image<frmt, T>& img)
+		{
+			const int n = img.width;
+			const int tiles = (n + transpose_tile - 1) / transpose_tile;
+
+			ParallelFor(0, tiles, 1, [&](int t0, int t1)
+			{
+				for (int ti = t0; ti < t1; ti++)
+				{
+					const int y0 = ti * transpose_tile;
+					const int y1 = std::min(y0 + transpose_tile, n);
+
+					for (int x0 = y0; x0 < n; x0 += transpose_tile)
+					{
+						const int x1 = std::min(x0 + transpose_tile, n);
+						for (int y = y0; y < y1; y++)
+						{
+							Pixel<frmt, T>* row = img.GetRow(y);
+							for (int x = std::max(x0, y + 1); x < x1; x++)
+								std::swap(row[x], img.GetRow(x)[y]);
+						}
+					}
+				}
+			});
+		}
+
+		template<ImageFormat frmt, pixel_t T>
+		void FlipHorizontalInPlace(Image<frmt, T>& img)
+		{
+			ParallelFor(0, img.height, 64, [&](int y0, int y1)
+			{
+				for (int y = y0; y < y1; y++)
+					std::reverse(img.GetRow(y), img.GetRow(y) + img.width);
+			});
+		}
+
+		template<ImageFormat frmt, pixel_t T>
+		void FlipVerticalInPlace(Image<frmt, T>& img)
+		{
+			ParallelFor(0, img.height / 2, 64, [&](int y0, int y1)
+			{
+				for (int y = y0; y < y1; y++)
+					std::swap_ranges(img.GetRow(y), img.GetRow(y) + img.width, img.GetRow(img.height - 1 - y));
+			});
+		}
+
+		// Rotation by a quarter turn; square images are turned in place as a transpose plus a flip
+		template<bool clockwise, ImageFormat frmt, pixel_t T>
+		void QuarterTurn(const Image<frmt, T>& in, Image<frmt, T>& out)
+		{
+			if (&in == &out)
+			{
+				if (in.width == in.height)
+				{
+					TransposeSquareInPlace(out);
+					if constexpr (clockwise)
+						FlipHorizontalInPlace(out);
+					else
+						FlipVerticalInPlace(out);
+					return;
+				}
+
+				const Image<frmt, T> copy = in;
+				QuarterTurn<clockwise>(copy, out);
+				return;
+			}
+
+			if (out.width != in.height || out.height != in.width)
+				out.create(in.height, in.width);
+
+			TransposeTiles<clockwise, !clockwise>(in, out);
+		}
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Transpose(const Image<frmt, T>& in, Image<frmt, T>& out)
+	{
+		if (&in == &out)
+		{
+			if (in.width == in.height)
+			{
+				detail::TransposeSquareInPlace(out);
+				return;
+			}
+
+			const Image<frmt, T> copy = in;
+			Transpose(copy, out);
+			return;
+		}
+
+		if (out.width != in.height || out.height != in.width)
+			out.create(in.height, in.width);
+
+		detail::TransposeTiles<false, false>(in, out);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Rotate90(const Image<frmt, T>& in, Image<frmt, T>& out)
+	{
+		detail::QuarterTurn<true>(in, out);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Rotate270(const Image<frmt, T>& in, Image<frmt, T>& out)
+	{
+		detail::QuarterTurn<false>(in, out);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void Rotate180(const Image<frmt, T>& in, Image<frmt, T>& out)
+	{
+		const int width = in.width;
+		const int height = in.height;
+
+		if (&in == &out)
+		{
+			// rows y and height - 1 - y swap reversed, the middle row of an odd height is reversed alone
+			detail::ParallelFor(0, (height + 1) / 2, 64, [&](int y0, int y1)
+			{
+				for (int y = y0; y < y1; y++)
+				{
+					Pixel<frmt, T>* top = out.GetRow(y);
+					Pixel<frmt, T>* bottom = out.GetRow(height - 1 - y);
+
+					if (top == bottom)
+						std::reverse(top, top + width);
+					else
+						std::swap_ranges(top, top + width, std::reverse_iterator<Pixel<frmt, T>*>(bottom + width));
+				}
+			});
+			return;
+		}
+
+		if (out.width != width || out.height != height)
+			out.create(width, height);
+
+		detail::ParallelFor(0, height, 64, [&](int y0, int y1)
+		{
+			for (int y = y0; y < y1; y++)
+				std::reverse_copy(in.GetRow(height - 1 - y), in.GetRow(height - 1 - y) + width, out.GetRow(y));
+		});
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void FlipHorizontal(const Image<frmt, T>& in, Image<frmt, T>& out)
+	{
+		if (&in == &out)
+		{
+			detail::FlipHorizontalInPlace(out);
+			return;
+		}
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		detail::ParallelFor(0, in.height, 64, [&](int y0, int y1)
+		{
+			for (int y = y0; y < y1; y++)
+				std::reverse_copy(in.GetRow(y), in.GetRow(y) + in.width, out.GetRow(y));
+		});
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void FlipVertical(const Image<frmt, T>& in, Image<frmt, T>& out)
+	{
+		if (&in == &out)
+		{
+			detail::FlipVerticalInPlace(out);
+			return;
+		}
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		detail::ParallelFor(0, in.height, 64, [&](int y0, int y1)
+		{
+			for (int y = y0; y < y1; y++)
+				std::copy_n(in.GetRow(in.height - 1 - y), in.width, out.GetRow(y));
+		});
+	}
+
+	template void Transpose(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&);
+	template void Transpose(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&);
+	template void Transpose(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&);
+	template void Transpose(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&);
+	template void Transpose(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&);
+	template void Transpose(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&);
+
+	template void Rotate90(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&);
+	template void Rotate90(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&);
+	template void Rotate90(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&);
+	template void Rotate90(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&);
+	template void Rotate90(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&);
+	template void Rotate90(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&);
+
+	template void Rotate180(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&);
+	template void Rotate180(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&);
+	template void Rotate180(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&);
+	template void Rotate180(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&);
+	template void Rotate180(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&);
+	template void Rotate180(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&);
+
+	template void Rotate270(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&);
+	template void Rotate270(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&);
+	template void Rotate270(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&);
+	template void Rotate270(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&);
+	template void Rotate270(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&);
+	template void Rotate270(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&);
+
+	template void FlipHorizontal(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&);
+	template void FlipHorizontal(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&);
+	template void FlipHorizontal(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&);
+	template void FlipHorizontal(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&);
+	template void FlipHorizontal(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&);
+	template void FlipHorizontal(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&);
+
+	template void FlipVertical(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&);
+	template void FlipVertical(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&);
+	template void FlipVertical(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&);
+	template void FlipVertical(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&);
+	template void FlipVertical(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&);
+	template void FlipVertical(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&);
+}
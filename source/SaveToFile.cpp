@@ -1,14 +1,94 @@
 #include "image.hpp"
 #include "stb/stb_image_write.h"
+#include "jpeg_encoder.hpp"
+#include "png_encoder.hpp"
+#include "transfer.hpp"
+#include <algorithm>
+#include <bit>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 namespace qlm
 {
+	template<ImageFormat frmt, pixel_t T>
+	bool Image<frmt, T>::SaveHDR(const std::string& file_name, bool alpha) const
+	{
+		// Radiance writer takes 1 to 4 float components, alpha is dropped by the RGBE encoding but accepted
+		const int comp = (frmt == ImageFormat::GRAY) ? 1 : 3;
+		const int final_comp = alpha ? comp + 1 : comp;
+		constexpr int ch = PixelChannels<frmt, T>();
+
+		std::vector<float> img_data(static_cast<size_t>(width) * height * final_comp);
+
+		for (int y = 0; y < height; y++)
+		{
+			const T* src = reinterpret_cast<const T*>(GetRow(y));
+			float* dst = &img_data[static_cast<size_t>(y) * width * final_comp];
+
+			for (int x = 0; x < width; x++, src += ch, dst += final_comp)
+			{
+				for (int c = 0; c < comp; c++)
+					dst[c] = static_cast<float>(src[c]);
+
+				if (alpha)
+					dst[comp] = static_cast<float>(src[ch - 1]);
+			}
+		}
+
+		return stbi_write_hdr(file_name.c_str(), width, height, final_comp, img_data.data()) != 0;
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	bool Image<frmt, T>::SavePFM(const std::string& file_name) const
+	{
+		// PFM has no alpha channel, rows are stored bottom-to-top
+		const int comp = (frmt == ImageFormat::GRAY) ? 1 : 3;
+		constexpr int ch = PixelChannels<frmt, T>();
+
+		std::ofstream output_file(file_name, std::ios::binary);
+		if (!output_file.is_open())
+			return false;
+
+		const float scale = std::endian::native == std::endian::little ? -1.0f : 1.0f;
+		output_file << (comp == 3 ? "PF" : "Pf") << "\n" << width << " " << height << "\n" << scale << "\n";
+
+		std::vector<float> row(static_cast<size_t>(width) * comp);
+		for (int y = height - 1; y >= 0; y--)
+		{
+			const T* src = reinterpret_cast<const T*>(GetRow(y));
+
+			for (int x = 0; x < width; x++)
+			{
+				for (int c = 0; c < comp; c++)
+					row[x * comp + c] = static_cast<float>(src[x * ch + c]);
+			}
+
+			output_file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(float));
+		}
+
+		return static_cast<bool>(output_file);
+	}
+
 	template<ImageFormat frmt, pixel_t T>
 	bool Image<frmt, T>::SaveToFile(const std::string& file_name, bool alpha, int quality)
 	{
-		// I think stb_write supports only U8 !
+		SaveOptions options;
+		options.alpha = alpha;
+		options.quality = quality;
+
+		// stb's global PNG settings still apply here.
+		// stb's level sizes its hash buckets (16 entries at the default 8), about the effort of deflate level 5
+		options.png_level = std::clamp(stbi_write_png_compression_level - 3, 1, 9);
+		options.png_filter = stbi_write_force_png_filter;
+
+		return SaveToFile(file_name, options);
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	bool Image<frmt, T>::SaveToFile(const std::string& file_name, const SaveOptions& options)
+	{
+		const bool alpha = options.alpha;
 
 		// Check if the data is valid
         if (data == nullptr || width <= 0 || height <= 0)
@@ -24,39 +104,82 @@ namespace qlm
         const int comp = (frmt == ImageFormat::GRAY) ? 1 : 3;
         const int final_comp = alpha ? comp + 1 : comp;
 
-		T* img_data = new T[width * height * final_comp];
+		// Determine the file extension
+		std::string ext = file_name.substr(file_name.find_last_of('.') + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+
+		// floating-point formats keep the samples as they are
+		if (ext == "hdr" || ext == "pfm")
+		{
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				return ext == "hdr" ? SaveHDR(file_name, alpha) : SavePFM(file_name);
+			}
+			else
+			{
+				std::cerr << "Error: '" << ext << "' output requires a floating-point image." << std::endl;
+				return false;
+			}
+		}
+
+		// stb_write supports only U8, floating-point images are sRGB encoded on the fly
+		using out_t = std::conditional_t<std::is_floating_point_v<T>, uint8_t, T>;
+
+		out_t* img_data = new out_t[width * height * final_comp];
 
 		// copy pixel data to the output buffer
-		for (int y = 0; y < height; y++)
+		if constexpr (std::is_floating_point_v<T>)
 		{
-			for (int x = 0; x < width; x++)
+			constexpr int ch = PixelChannels<frmt, T>();
+			const detail::FloatToU8Table lut{ TransferFunction::SRGB, 0.0f };
+			std::vector<uint8_t> row(width * ch);
+
+			for (int y = 0; y < height; y++)
 			{
-				const Pixel<frmt, T> pix = GetPixel(x, y);
-				const int idx = (y * width + x) * final_comp;
+				detail::RowToU8(reinterpret_cast<const float*>(GetRow(y)), row.data(), width, ch, lut);
 
-				if constexpr (frmt == ImageFormat::GRAY)
+				out_t* out_row = img_data + y * width * final_comp;
+				for (int x = 0; x < width; x++)
 				{
-					img_data[idx] = pix.v;
+					for (int c = 0; c < comp; c++)
+						out_row[x * final_comp + c] = row[x * ch + c];
 
 					if (alpha)
-						img_data[idx + 1] = pix.a;
+						out_row[x * final_comp + comp] = row[x * ch + ch - 1];
 				}
-				else
+			}
+		}
+		else
+		{
+			for (int y = 0; y < height; y++)
+			{
+				const Pixel<frmt, T>* row = GetRow(y);
+
+				for (int x = 0; x < width; x++)
 				{
-					img_data[idx] = pix.r;
-					img_data[idx + 1] = pix.g;
-					img_data[idx + 2] = pix.b;
-					
-					if (alpha)
-						img_data[idx + 3] = pix.a;
+					const Pixel<frmt, T>& pix = row[x];
+					const int idx = (y * width + x) * final_comp;
+
+					if constexpr (frmt == ImageFormat::GRAY)
+					{
+						img_data[idx] = pix.v;
+
+						if (alpha)
+							img_data[idx + 1] = pix.a;
+					}
+					else
+					{
+						img_data[idx] = pix.r;
+						img_data[idx + 1] = pix.g;
+						img_data[idx + 2] = pix.b;
+
+						if (alpha)
+							img_data[idx + 3] = pix.a;
+					}
 				}
 			}
 		}
 
-		// Determine the file extension
-		std::string ext = file_name.substr(file_name.find_last_of('.') + 1);
-		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
-
 		if (ext == "bmp")
 		{
 			stb_status = stbi_write_bmp(file_name.c_str(), width, height, final_comp, reinterpret_cast<void*>(img_data));
@@ -68,10 +191,10 @@ namespace qlm
 			if (output_file.is_open())
 			{
 				// Write the PGM header
-				output_file << "P5\n" << width << " " << height << "\n" << std::numeric_limits<T>::max() << "\n";
+				output_file << "P5\n" << width << " " << height << "\n" << +std::numeric_limits<out_t>::max() << "\n";
 
 				// Write the image data
-				output_file.write(reinterpret_cast<char*>(img_data), width * height * sizeof(T));
+				output_file.write(reinterpret_cast<char*>(img_data), width * height * sizeof(out_t));
 
 				// Close the file
 				output_file.close();
@@ -82,12 +205,64 @@ namespace qlm
 		}
 		else if (ext == "png")
 		{
-			int stride_in_bytes = final_comp * width * sizeof(T);
-			stb_status = stbi_write_png(file_name.c_str(), width, height, final_comp, reinterpret_cast<void*>(img_data), stride_in_bytes);
+			if constexpr (sizeof(out_t) == 1)
+			{
+				// row blocks are compressed in parallel
+				// stored rows gain nothing from filtering, fast mode uses Sub to turn flat areas into runs
+				int filter = options.png_filter;
+				if (filter < 0 && options.png_level <= 0)
+					filter = 0;
+				else if (filter < 0 && options.png_fast)
+					filter = 1;
+				const detail::DeflateStrategy strategy = options.png_fast ? detail::DeflateStrategy::RLE : detail::DeflateStrategy::DEFAULT;
+
+				std::ofstream output_file(file_name, std::ios::binary);
+				if (output_file.is_open())
+				{
+					stb_status = detail::WritePng(output_file, reinterpret_cast<const uint8_t*>(img_data), width, height, final_comp,
+												  options.png_level, filter, strategy);
+				}
+			}
+			else
+			{
+				int stride_in_bytes = final_comp * width * sizeof(out_t);
+				stb_status = stbi_write_png(file_name.c_str(), width, height, final_comp, reinterpret_cast<void*>(img_data), stride_in_bytes);
+			}
 		}
 		else if (ext == "jpg" || ext == "jpeg")
 		{
-			stb_status = stbi_write_jpg(file_name.c_str(), width, height, final_comp, reinterpret_cast<void*>(img_data), quality);
+			if constexpr (sizeof(out_t) == 1)
+			{
+				// strips of MCU rows are encoded in parallel, separated by restart markers
+				std::ofstream output_file(file_name, std::ios::binary);
+				if (output_file.is_open())
+				{
+					// luma sampling factors, 0 lets the encoder choose from the quality
+					int h_sampling = 0, v_sampling = 0;
+					switch (options.chroma_subsampling)
+					{
+						case ChromaSubsampling::SUBSAMPLING_444:
+							h_sampling = v_sampling = 1;
+							break;
+						case ChromaSubsampling::SUBSAMPLING_422:
+							h_sampling = 2;
+							v_sampling = 1;
+							break;
+						case ChromaSubsampling::SUBSAMPLING_420:
+							h_sampling = v_sampling = 2;
+							break;
+						default:
+							break;
+					}
+
+					stb_status = detail::WriteJpeg(output_file, reinterpret_cast<const uint8_t*>(img_data), width, height, final_comp,
+												   options.quality, h_sampling, v_sampling);
+				}
+			}
+			else
+			{
+				stb_status = stbi_write_jpg(file_name.c_str(), width, height, final_comp, reinterpret_cast<void*>(img_data), options.quality);
+			}
 		}
 		else
 		{
@@ -103,4 +278,13 @@ namespace qlm
 	template bool Image<ImageFormat::RGB, uint8_t>::SaveToFile(const std::string&, bool, int);
 	template bool Image<ImageFormat::GRAY, int16_t>::SaveToFile(const std::string&, bool, int);
 	template bool Image<ImageFormat::RGB, int16_t>::SaveToFile(const std::string&, bool, int);
+	template bool Image<ImageFormat::GRAY, float>::SaveToFile(const std::string&, bool, int);
+	template bool Image<ImageFormat::RGB, float>::SaveToFile(const std::string&, bool, int);
+
+	template bool Image<ImageFormat::GRAY, uint8_t>::SaveToFile(const std::string&, const SaveOptions&);
+	template bool Image<ImageFormat::RGB, uint8_t>::SaveToFile(const std::string&, const SaveOptions&);
+	template bool Image<ImageFormat::GRAY, int16_t>::SaveToFile(const std::string&, const SaveOptions&);
+	template bool Image<ImageFormat::RGB, int16_t>::SaveToFile(const std::string&, const SaveOptions&);
+	template bool Image<ImageFormat::GRAY, float>::SaveToFile(const std::string&, const SaveOptions&);
+	template bool Image<ImageFormat::RGB, float>::SaveToFile(const std::string&, const SaveOptions&);
 }
\ No newline at end of file
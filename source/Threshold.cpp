@@ -0,0 +1,431 @@
+#include "threshold.hpp"
+#include "filter.hpp"
+#include "gaussian.hpp"
+#include "histogram.hpp"
+#include "integral_image.hpp"
+#include "parallel.hpp"
+#include "saturate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace qlm
+{
+	namespace detail
+	{
+		// c ? a : b without a branch, thresholds of noisy images are unpredictable
+		template<pixel_t T>
+		inline T Select(bool c, T a, T b)
+		{
+			if constexpr (std::is_integral_v<T>)
+				return static_cast<T>(b ^ ((a ^ b) & static_cast<T>(-static_cast<int>(c))));
+			else
+				return c ? a : b;
+		}
+
+		// Replace the gray value of every pixel by op(v) and copy alpha. Rows are split over the threads and
+		// the select in "op" is branch-free, so the loop vectorizes.
+		template<pixel_t T, typename Op>
+		void ThresholdRows(const Image<ImageFormat::GRAY, T>& in, Image<ImageFormat::GRAY, T>& out, Op op)
+		{
+			ParallelFor(0, in.height, 32, [&](int y0, int y1)
+			{
+				const Op f = op;
+				const int width = in.width;
+				for (int y = y0; y < y1; y++)
+				{
+					const T* src = reinterpret_cast<const T*>(in.GetRow(y));
+					T* dst = reinterpret_cast<T*>(out.GetRow(y));
+					for (int x = 0; x < width; x++)
+					{
+						const T v = src[2 * x];
+						const T a = src[2 * x + 1];
+						dst[2 * x] = f(v);
+						dst[2 * x + 1] = a;
+					}
+				}
+			});
+		}
+
+		// Gray histogram with its binning: bin i holds the values around lo + i * step. 8-bit images get one
+		// bin per value; floating-point images 256 bins centered from their minimum to their maximum.
+		template<pixel_t T>
+		std::vector<uint64_t> GrayHistogram(const Image<ImageFormat::GRAY, T>& in, double& lo, double& step)
+		{
+			if constexpr (std::is_integral_v<T>)
+			{
+				Histogram<ImageFormat::GRAY, T> hist;
+				hist.Compute(in);
+				lo = 0.0;
+				step = 1.0;
+				return std::vector<uint64_t>(hist.Channel(0), hist.Channel(0) + hist.Bins());
+			}
+			else
+			{
+				float min_value = std::numeric_limits<float>::max();
+				float max_value = std::numeric_limits<float>::lowest();
+				std::mutex merge_mutex;
+
+				ParallelFor(0, in.height, 32, [&](int y0, int y1)
+				{
+					const int width = in.width;
+					float band_min = std::numeric_limits<float>::max();
+					float band_max = std::numeric_limits<float>::lowest();
+					for (int y = y0; y < y1; y++)
+					{
+						const T* src = reinterpret_cast<const T*>(in.GetRow(y));
+						for (int x = 0; x < width; x++)
+						{
+							band_min = std::min(band_min, src[2 * x]);
+							band_max = std::max(band_max, src[2 * x]);
+						}
+					}
+
+					std::lock_guard<std::mutex> lock(merge_mutex);
+					min_value = std::min(min_value, band_min);
+					max_value = std::max(max_value, band_max);
+				});
+
+				lo = min_value;
+				step = max_value > min_value ? (static_cast<double>(max_value) - min_value) / 255.0 : 0.0;
+				if (step == 0.0)
+					return {};
+
+				Histogram<ImageFormat::GRAY, T> hist(256, lo - 0.5 * step, static_cast<double>(max_value) + 0.5 * step);
+				hist.Compute(in);
+				return std::vector<uint64_t>(hist.Channel(0), hist.Channel(0) + hist.Bins());
+			}
+		}
+
+		// Value separating bin t from bin t + 1: t itself for 8-bit images, the bin edge for floating-point images
+		template<pixel_t T>
+		double BinThreshold(int t, double lo, double step)
+		{
+			if constexpr (std::is_integral_v<T>)
+				return lo + t * step;
+			else
+				return lo + (t + 0.5) * step;
+		}
+	}
+
+	template<pixel_t T>
+	void Threshold(const Image<ImageFormat::GRAY, T>& in, Image<ImageFormat::GRAY, T>& out, double thresh, double max_value, ThresholdType type)
+	{
+		if (in.width <= 0 || in.height <= 0)
+		{
+			std::cerr << "Error: Threshold input image is empty." << std::endl;
+			return;
+		}
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		const T high = detail::SaturateCast<T>(max_value);
+
+		if constexpr (std::is_integral_v<T>)
+		{
+			// every value passes below the range and none above it, the comparison then stays in T
+			const double t = std::floor(thresh);
+			const bool all = t < static_cast<double>(std::numeric_limits<T>::lowest());
+			const bool none = t >= static_cast<double>(std::numeric_limits<T>::max());
+			if (all || none)
+			{
+				const T low = detail::SaturateCast<T>(t);
+				switch (type)
+				{
+					case ThresholdType::BINARY:
+						detail::ThresholdRows(in, out, [=](T) { return all ? high : T(0); });
+						break;
+					case ThresholdType::BINARY_INV:
+						detail::ThresholdRows(in, out, [=](T) { return all ? T(0) : high; });
+						break;
+					case ThresholdType::TRUNC:
+						detail::ThresholdRows(in, out, [=](T v) { return all ? low : v; });
+						break;
+					case ThresholdType::TOZERO:
+						detail::ThresholdRows(in, out, [=](T v) { return all ? v : T(0); });
+						break;
+					case ThresholdType::TOZERO_INV:
+						detail::ThresholdRows(in, out, [=](T v) { return all ? T(0) : v; });
+						break;
+				}
+				return;
+			}
+		}
+
+		const T t = static_cast<T>(std::is_integral_v<T> ? std::floor(thresh) : thresh);
+
+		switch (type)
+		{
+			case ThresholdType::BINARY:
+				detail::ThresholdRows(in, out, [=](T v) { return detail::Select(v > t, high, T(0)); });
+				break;
+			case ThresholdType::BINARY_INV:
+				detail::ThresholdRows(in, out, [=](T v) { return detail::Select(v > t, T(0), high); });
+				break;
+			case ThresholdType::TRUNC:
+				detail::ThresholdRows(in, out, [=](T v) { return detail::Select(v > t, t, v); });
+				break;
+			case ThresholdType::TOZERO:
+				detail::ThresholdRows(in, out, [=](T v) { return detail::Select(v > t, v, T(0)); });
+				break;
+			case ThresholdType::TOZERO_INV:
+				detail::ThresholdRows(in, out, [=](T v) { return detail::Select(v > t, T(0), v); });
+				break;
+		}
+	}
+
+	template<pixel_t T>
+	double OtsuThreshold(const Image<ImageFormat::GRAY, T>& in)
+	{
+		double lo = 0.0, step = 0.0;
+		const std::vector<uint64_t> hist = detail::GrayHistogram(in, lo, step);
+		if (hist.empty())
+			return lo;
+
+		const int bins = static_cast<int>(hist.size());
+
+		double total = 0.0, total_sum = 0.0;
+		for (int i = 0; i < bins; i++)
+		{
+			total += static_cast<double>(hist[i]);
+			total_sum += static_cast<double>(i) * static_cast<double>(hist[i]);
+		}
+
+		// between-class variance w0 w1 (m0 - m1)^2 of every split, from running counts and sums
+		double count = 0.0, sum = 0.0, best = -1.0;
+		int best_bin = 0;
+		for (int i = 0; i < bins; i++)
+		{
+			count += static_cast<double>(hist[i]);
+			sum += static_cast<double>(i) * static_cast<double>(hist[i]);
+			if (count == 0.0 || count == total)
+				continue;
+
+			const double m0 = sum / count;
+			const double m1 = (total_sum - sum) / (total - count);
+			const double variance = count * (total - count) * (m0 - m1) * (m0 - m1);
+			if (variance > best)
+			{
+				best = variance;
+				best_bin = i;
+			}
+		}
+
+		return detail::BinThreshold<T>(best_bin, lo, step);
+	}
+
+	template<pixel_t T>
+	double TriangleThreshold(const Image<ImageFormat::GRAY, T>& in)
+	{
+		double lo = 0.0, step = 0.0;
+		std::vector<uint64_t> hist = detail::GrayHistogram(in, lo, step);
+		if (hist.empty())
+			return lo;
+
+		const int bins = static_cast<int>(hist.size());
+
+		// the occupied range widened by one empty bin on each side, and the highest bin
+		int left = 0, right = bins - 1;
+		while (left < bins - 1 && hist[left] == 0)
+			left++;
+		while (right > 0 && hist[right] == 0)
+			right--;
+		left = std::max(left - 1, 0);
+		right = std::min(right + 1, bins - 1);
+
+		const int peak = static_cast<int>(std::max_element(hist.begin(), hist.end()) - hist.begin());
+
+		// the line is always drawn toward the left end, the histogram is mirrored when the long tail is on the right
+		const bool flipped = peak - left < right - peak;
+		if (flipped)
+			std::reverse(hist.begin(), hist.end());
+
+		const int start = flipped ? bins - 1 - right : left;
+		const int top = flipped ? bins - 1 - peak : peak;
+
+		// distance to the line from (start, 0) to (top, hist[top]), up to a constant factor
+		const double a = static_cast<double>(hist[top]);
+		const double b = static_cast<double>(start - top);
+		double farthest = 0.0;
+		int t = start;
+		for (int i = start + 1; i <= top; i++)
+		{
+			const double distance = a * i + b * static_cast<double>(hist[i]);
+			if (distance > farthest)
+			{
+				farthest = distance;
+				t = i;
+			}
+		}
+
+		t = std::max(t - 1, 0);
+		if (flipped)
+			t = bins - 1 - t;
+
+		return detail::BinThreshold<T>(t, lo, step);
+	}
+
+	template<pixel_t T>
+	void AdaptiveThreshold(const Image<ImageFormat::GRAY, T>& in, Image<ImageFormat::GRAY, T>& out, double max_value,
+						   AdaptiveMethod method, ThresholdType type, int block_size, double c)
+	{
+		if (in.width <= 0 || in.height <= 0)
+		{
+			std::cerr << "Error: AdaptiveThreshold input image is empty." << std::endl;
+			return;
+		}
+
+		if (block_size < 3 || block_size % 2 == 0)
+		{
+			std::cerr << "Error: AdaptiveThreshold block size must be odd and at least 3." << std::endl;
+			return;
+		}
+
+		if (type != ThresholdType::BINARY && type != ThresholdType::BINARY_INV)
+		{
+			std::cerr << "Error: AdaptiveThreshold supports BINARY and BINARY_INV only." << std::endl;
+			return;
+		}
+
+		// float is exact for 8-bit block sums below 2^24, doubles keep the floating-point integral sums
+		using mean_t = std::conditional_t<std::is_integral_v<T>, float, double>;
+
+		const T high = detail::SaturateCast<T>(max_value);
+		const T on = type == ThresholdType::BINARY ? high : T(0);
+		const T off = type == ThresholdType::BINARY ? T(0) : high;
+		const mean_t offset = static_cast<mean_t>(c);
+		const int r = block_size / 2;
+
+		if (method == AdaptiveMethod::GAUSSIAN)
+		{
+			// Gaussian of block_size taps with the sigma OpenCV derives from the block size
+			const double sigma = 0.3 * ((block_size - 1) * 0.5 - 1.0) + 0.8;
+			const std::vector<float> kernel = detail::GaussianKernel(sigma, r);
+
+			Image<ImageFormat::GRAY, T> local;
+			SepFilter2D(in, local, kernel, kernel, BorderMode<ImageFormat::GRAY, T>{ BorderType::BORDER_REPLICATE });
+
+			if (out.width != in.width || out.height != in.height)
+				out.create(in.width, in.height);
+
+			detail::ParallelFor(0, in.height, 32, [&](int y0, int y1)
+			{
+				const T on_value = on;
+				const T off_value = off;
+				const mean_t c_value = offset;
+				const int width = in.width;
+				for (int y = y0; y < y1; y++)
+				{
+					const T* src = reinterpret_cast<const T*>(in.GetRow(y));
+					const T* mean = reinterpret_cast<const T*>(local.GetRow(y));
+					T* dst = reinterpret_cast<T*>(out.GetRow(y));
+					for (int x = 0; x < width; x++)
+					{
+						const mean_t v = static_cast<mean_t>(src[2 * x]);
+						const mean_t m = static_cast<mean_t>(mean[2 * x]);
+						const T a = src[2 * x + 1];
+						dst[2 * x] = detail::Select(v > m - c_value, on_value, off_value);
+						dst[2 * x + 1] = a;
+					}
+				}
+			});
+			return;
+		}
+
+		const IntegralImage<ImageFormat::GRAY, T> integral(in);
+		using sum_t = typename IntegralImage<ImageFormat::GRAY, T>::sum_t;
+		constexpr int C = IntegralImage<ImageFormat::GRAY, T>::channels;
+
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		// the box is clipped to the image; inside [x_begin, x_end) it spans block_size full columns
+		const int width = in.width;
+		const int height = in.height;
+		const int x_begin = std::min(r, width);
+		const int x_end = std::max(x_begin, width - r);
+
+		detail::ParallelFor(0, height, 32, [&](int y0, int y1)
+		{
+			const T on_value = on;
+			const T off_value = off;
+			const mean_t c_value = offset;
+
+			for (int y = y0; y < y1; y++)
+			{
+				const int top = std::max(y - r, 0);
+				const int bottom = std::min(y + r + 1, height);
+				const sum_t* t = integral.SumRow(top);
+				const sum_t* b = integral.SumRow(bottom);
+				const mean_t rows = static_cast<mean_t>(bottom - top);
+
+				const T* src = reinterpret_cast<const T*>(in.GetRow(y));
+				T* dst = reinterpret_cast<T*>(out.GetRow(y));
+
+				// box sums wrap around in unsigned integral images, the difference fits a signed 32-bit value
+				const auto box_sum = [&](int x0, int x1) -> mean_t
+				{
+					const sum_t s = b[x1 * C] - b[x0 * C] - t[x1 * C] + t[x0 * C];
+					if constexpr (std::is_integral_v<sum_t>)
+						return static_cast<mean_t>(static_cast<int32_t>(s));
+					else
+						return static_cast<mean_t>(s);
+				};
+
+				const auto edge = [&](int x)
+				{
+					const int x0 = std::max(x - r, 0);
+					const int x1 = std::min(x + r + 1, width);
+					const mean_t mean = box_sum(x0, x1) / (rows * static_cast<mean_t>(x1 - x0));
+					const T a = src[2 * x + 1];
+					dst[2 * x] = detail::Select(static_cast<mean_t>(src[2 * x]) > mean - c_value, on_value, off_value);
+					dst[2 * x + 1] = a;
+				};
+
+				for (int x = 0; x < x_begin; x++)
+					edge(x);
+
+				// the interior compares v * area against the box sum, the columns are offsets from x
+				const mean_t area = rows * static_cast<mean_t>(block_size);
+				const mean_t bias = c_value * area;
+				const sum_t* tl = t - r * C;
+				const sum_t* tr = t + (r + 1) * C;
+				const sum_t* bl = b - r * C;
+				const sum_t* br = b + (r + 1) * C;
+				const int end = x_end;
+				for (int x = x_begin; x < end; x++)
+				{
+					const sum_t s = br[x * C] - bl[x * C] - tr[x * C] + tl[x * C];
+					mean_t sum;
+					if constexpr (std::is_integral_v<sum_t>)
+						sum = static_cast<mean_t>(static_cast<int32_t>(s));
+					else
+						sum = static_cast<mean_t>(s);
+
+					const T a = src[2 * x + 1];
+					dst[2 * x] = detail::Select(static_cast<mean_t>(src[2 * x]) * area > sum - bias, on_value, off_value);
+					dst[2 * x + 1] = a;
+				}
+
+				for (int x = x_end; x < width; x++)
+					edge(x);
+			}
+		});
+	}
+
+	template void Threshold(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, double, double, ThresholdType);
+	template void Threshold(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, double, double, ThresholdType);
+
+	template double OtsuThreshold(const Image<ImageFormat::GRAY, uint8_t>&);
+	template double OtsuThreshold(const Image<ImageFormat::GRAY, float>&);
+
+	template double TriangleThreshold(const Image<ImageFormat::GRAY, uint8_t>&);
+	template double TriangleThreshold(const Image<ImageFormat::GRAY, float>&);
+
+	template void AdaptiveThreshold(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, double, AdaptiveMethod, ThresholdType, int, double);
+	template void AdaptiveThreshold(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, double, AdaptiveMethod, ThresholdType, int, double);
+}
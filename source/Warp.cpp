@@ -0,0 +1,257 @@
+#include "geometry.hpp"
+#include "parallel.hpp"
+#include "warp.hpp"
+#include <iostream>
+#include <vector>
+
+namespace qlm
+{
+	namespace detail
+	{
+		// Output tiles: rows of a tile map to a compact source region even for rotations
+		constexpr int warp_tile_width = 256;
+		constexpr int warp_tile_height = 32;
+
+		// Affine coordinates of integer pixels are stepped in fixed-point with warp_ab_bits fractional bits;
+		// every term is clamped so the sums stay in 32 bits
+		constexpr int warp_ab_bits = 10;
+		constexpr double warp_ab_limit = 1 << 29;
+
+		inline int FixedTerm(double v)
+		{
+			return static_cast<int>(std::lround(std::clamp(v * (1 << warp_ab_bits), -warp_ab_limit, warp_ab_limit)));
+		}
+
+		// Inverse of a row-major 3x3 matrix, false when it is singular
+		inline bool InvertMatrix(const std::array<double, 9>& m, std::array<double, 9>& inv)
+		{
+			const double c00 = m[4] * m[8] - m[5] * m[7];
+			const double c01 = m[5] * m[6] - m[3] * m[8];
+			const double c02 = m[3] * m[7] - m[4] * m[6];
+			const double det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+
+			if (std::abs(det) < 1e-12)
+				return false;
+
+			const double s = 1.0 / det;
+			inv = { c00 * s, (m[2] * m[7] - m[1] * m[8]) * s, (m[1] * m[5] - m[2] * m[4]) * s,
+					c01 * s, (m[0] * m[8] - m[2] * m[6]) * s, (m[2] * m[3] - m[0] * m[5]) * s,
+					c02 * s, (m[1] * m[6] - m[0] * m[7]) * s, (m[0] * m[4] - m[1] * m[3]) * s };
+			return true;
+		}
+
+		// Warp with the inverse map "m" (output -> source). Every thread takes bands of tile rows; inside a tile,
+		// each row segment gets its source coordinates from the per-column tables plus one per-row term,
+		// then the pixels are gathered.
+		template<BorderType border_type, bool perspective, ImageFormat frmt, pixel_t T>
+		void WarpTiles(const Image<frmt, T>& in, Image<frmt, T>& out, const std::array<double, 9>& m, Interpolation interpolation,
+					   const Pixel<frmt, T>& border_pixel)
+		{
+			constexpr bool fixed = !std::is_floating_point_v<T>;
+			const bool nearest = interpolation == Interpolation::NEAREST;
+			const int width = out.width;
+			const int height = out.height;
+
+			// per-column terms of the coordinates
+			std::vector<double> cu(width), cv(width), cw(width);
+			std::vector<int> fu(width), fv(width);
+			for (int x = 0; x < width; x++)
+			{
+				cu[x] = m[0] * x;
+				cv[x] = m[3] * x;
+				cw[x] = m[6] * x;
+				fu[x] = FixedTerm(cu[x]);
+				fv[x] = FixedTerm(cv[x]);
+			}
+
+			const int tiles_y = (height + warp_tile_height - 1) / warp_tile_height;
+
+			ParallelFor(0, tiles_y, 1, [&](int t0, int t1)
+			{
+				std::vector<int> sx(warp_tile_width), sy(warp_tile_width);
+				std::vector<uint16_t> frac(warp_tile_width);
+				std::vector<float> u(warp_tile_width), v(warp_tile_width);
+
+				// source coordinates of the "count" pixels of row y from column x0
+				const auto coordinates = [&](int y, int x0, int count)
+				{
+					const double ru = m[1] * y + m[2];
+					const double rv = m[4] * y + m[5];
+
+					if constexpr (perspective)
+					{
+						const double rw = m[7] * y + m[8];
+						// integer pixels keep remap_frac_bits, nearest rounds to the closest pixel
+						const double scale = fixed && !nearest ? remap_frac_size : 1.0;
+						for (int i = 0; i < count; i++)
+						{
+							const double w = cw[x0 + i] + rw;
+							const double s = w != 0.0 ? scale / w : 0.0;
+							const double pu = w != 0.0 ? (cu[x0 + i] + ru) * s : -remap_coordinate_limit;
+							const double pv = w != 0.0 ? (cv[x0 + i] + rv) * s : -remap_coordinate_limit;
+
+							if (fixed || nearest)
+							{
+								const int iu = ClampCoordinate(pu + 0.5);
+								const int iv = ClampCoordinate(pv + 0.5);
+								sx[i] = nearest ? iu : iu >> remap_frac_bits;
+								sy[i] = nearest ? iv : iv >> remap_frac_bits;
+								frac[i] = static_cast<uint16_t>((iv & (remap_frac_size - 1)) * remap_frac_size + (iu & (remap_frac_size - 1)));
+							}
+							else
+							{
+								u[i] = static_cast<float>(pu);
+								v[i] = static_cast<float>(pv);
+							}
+						}
+					}
+					else if (fixed)
+					{
+						// integer stepping: one add per coordinate and pixel, then a shift
+						const int shift = nearest ? warp_ab_bits : warp_ab_bits - remap_frac_bits;
+						const int bu = FixedTerm(ru) + (1 << (shift - 1));
+						const int bv = FixedTerm(rv) + (1 << (shift - 1));
+						const int* tu = fu.data() + x0;
+						const int* tv = fv.data() + x0;
+
+						if (nearest)
+						{
+							for (int i = 0; i < count; i++)
+							{
+								sx[i] = (bu + tu[i]) >> shift;
+								sy[i] = (bv + tv[i]) >> shift;
+							}
+						}
+						else
+						{
+							for (int i = 0; i < count; i++)
+							{
+								const int iu = (bu + tu[i]) >> shift;
+								const int iv = (bv + tv[i]) >> shift;
+								sx[i] = iu >> remap_frac_bits;
+								sy[i] = iv >> remap_frac_bits;
+								frac[i] = static_cast<uint16_t>((iv & (remap_frac_size - 1)) * remap_frac_size + (iu & (remap_frac_size - 1)));
+							}
+						}
+					}
+					else if (nearest)
+					{
+						for (int i = 0; i < count; i++)
+						{
+							sx[i] = ClampCoordinate(cu[x0 + i] + ru + 0.5);
+							sy[i] = ClampCoordinate(cv[x0 + i] + rv + 0.5);
+						}
+					}
+					else
+					{
+						for (int i = 0; i < count; i++)
+						{
+							u[i] = static_cast<float>(cu[x0 + i] + ru);
+							v[i] = static_cast<float>(cv[x0 + i] + rv);
+						}
+					}
+				};
+
+				for (int t = t0; t < t1; t++)
+				{
+					const int y0 = t * warp_tile_height;
+					const int y1 = std::min(y0 + warp_tile_height, height);
+
+					for (int x0 = 0; x0 < width; x0 += warp_tile_width)
+					{
+						const int count = std::min(warp_tile_width, width - x0);
+						for (int y = y0; y < y1; y++)
+						{
+							coordinates(y, x0, count);
+
+							Pixel<frmt, T>* dst = out.GetRow(y) + x0;
+							if (nearest)
+								RemapNearest<border_type>(in, sx.data(), sy.data(), count, border_pixel, dst);
+							else if constexpr (fixed)
+								RemapBilinearFixed<border_type>(in, sx.data(), sy.data(), frac.data(), count, border_pixel, dst);
+							else
+								RemapBilinearFloat<border_type>(in, u.data(), v.data(), count, border_pixel, dst);
+						}
+					}
+				}
+			});
+		}
+
+		template<ImageFormat frmt, pixel_t T>
+		void Warp(const Image<frmt, T>& in, Image<frmt, T>& out, std::array<double, 9> m, bool perspective, int width, int height,
+				  Interpolation interpolation, const BorderMode<frmt, T>& border_mode, bool inverse_map, const char* name)
+		{
+			if (width <= 0 || height <= 0)
+			{
+				std::cerr << "Error: " << name << " size must be positive." << std::endl;
+				return;
+			}
+
+			if (in.width <= 0 || in.height <= 0)
+			{
+				std::cerr << "Error: " << name << " input image is empty." << std::endl;
+				return;
+			}
+
+			if (interpolation != Interpolation::NEAREST && interpolation != Interpolation::BILINEAR)
+			{
+				std::cerr << "Error: " << name << " supports NEAREST and BILINEAR interpolation only." << std::endl;
+				return;
+			}
+
+			if (!inverse_map && !InvertMatrix(m, m))
+			{
+				std::cerr << "Error: " << name << " matrix is singular." << std::endl;
+				return;
+			}
+
+			// the tiles read the whole source while others write, so the output cannot be the input
+			if (&in == &out)
+			{
+				const Image<frmt, T> copy = in;
+				Warp(copy, out, m, perspective, width, height, interpolation, border_mode, true, name);
+				return;
+			}
+
+			if (out.width != width || out.height != height)
+				out.create(width, height);
+
+			DispatchBorder(border_mode.border_type, [&](auto policy)
+			{
+				if (perspective)
+					WarpTiles<policy.value, true>(in, out, m, interpolation, border_mode.border_pixel);
+				else
+					WarpTiles<policy.value, false>(in, out, m, interpolation, border_mode.border_pixel);
+			});
+		}
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void WarpAffine(const Image<frmt, T>& in, Image<frmt, T>& out, const std::array<double, 6>& matrix, int width, int height,
+					Interpolation interpolation, const BorderMode<frmt, T>& border_mode, bool inverse_map)
+	{
+		const std::array<double, 9> m{ matrix[0], matrix[1], matrix[2], matrix[3], matrix[4], matrix[5], 0.0, 0.0, 1.0 };
+		detail::Warp(in, out, m, false, width, height, interpolation, border_mode, inverse_map, "WarpAffine");
+	}
+
+	template<ImageFormat frmt, pixel_t T>
+	void WarpPerspective(const Image<frmt, T>& in, Image<frmt, T>& out, const std::array<double, 9>& matrix, int width, int height,
+						 Interpolation interpolation, const BorderMode<frmt, T>& border_mode, bool inverse_map)
+	{
+		detail::Warp(in, out, matrix, true, width, height, interpolation, border_mode, inverse_map, "WarpPerspective");
+	}
+
+	template void WarpAffine(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, const std::array<double, 6>&, int, int, Interpolation, const BorderMode<ImageFormat::GRAY, uint8_t>&, bool);
+	template void WarpAffine(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, const std::array<double, 6>&, int, int, Interpolation, const BorderMode<ImageFormat::GRAY, int16_t>&, bool);
+	template void WarpAffine(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, const std::array<double, 6>&, int, int, Interpolation, const BorderMode<ImageFormat::GRAY, float>&, bool);
+	template void WarpAffine(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, const std::array<double, 6>&, int, int, Interpolation, const BorderMode<ImageFormat::RGB, uint8_t>&, bool);
+	template void WarpAffine(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, const std::array<double, 6>&, int, int, Interpolation, const BorderMode<ImageFormat::RGB, int16_t>&, bool);
+	template void WarpAffine(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, const std::array<double, 6>&, int, int, Interpolation, const BorderMode<ImageFormat::RGB, float>&, bool);
+
+	template void WarpPerspective(const Image<ImageFormat::GRAY, uint8_t>&, Image<ImageFormat::GRAY, uint8_t>&, const std::array<double, 9>&, int, int, Interpolation, const BorderMode<ImageFormat::GRAY, uint8_t>&, bool);
+	template void WarpPerspective(const Image<ImageFormat::GRAY, int16_t>&, Image<ImageFormat::GRAY, int16_t>&, const std::array<double, 9>&, int, int, Interpolation, const BorderMode<ImageFormat::GRAY, int16_t>&, bool);
+	template void WarpPerspective(const Image<ImageFormat::GRAY, float>&, Image<ImageFormat::GRAY, float>&, const std::array<double, 9>&, int, int, Interpolation, const BorderMode<ImageFormat::GRAY, float>&, bool);
+	template void WarpPerspective(const Image<ImageFormat::RGB, uint8_t>&, Image<ImageFormat::RGB, uint8_t>&, const std::array<double, 9>&, int, int, Interpolation, const BorderMode<ImageFormat::RGB, uint8_t>&, bool);
+	template void WarpPerspective(const Image<ImageFormat::RGB, int16_t>&, Image<ImageFormat::RGB, int16_t>&, const std::array<double, 9>&, int, int, Interpolation, const BorderMode<ImageFormat::RGB, int16_t>&, bool);
+	template void WarpPerspective(const Image<ImageFormat::RGB, float>&, Image<ImageFormat::RGB, float>&, const std::array<double, 9>&, int, int, Interpolation, const BorderMode<ImageFormat::RGB, float>&, bool);
+}
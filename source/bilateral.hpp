@@ -0,0 +1,536 @@
+#pragma once
+
+#include "image.hpp"
+#include "neighborhood.hpp"
+#include "parallel.hpp"
+#include "saturate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace qlm::detail
+{
+	// Largest radius always filtered directly. Beyond it, windows of at least 3 sigma_space go through the
+	// permutohedral lattice: it is faster from here on, but its error does not shrink with the radius, so it
+	// only takes windows where direct filtering has become several times slower.
+	inline constexpr int bilateral_direct_radius = 16;
+
+	// Range weight exp(-|p - q|^2 / (2 sigma^2)) of the color channels, looked up from the squared distance.
+	// 8-bit pixels index the table with the integer squared distance itself; floating-point pixels interpolate
+	// exp(-t) tabulated in steps of 1/64 (relative error below 3e-5). Both tables stop at t = 16, past which
+	// the weight is 0. The keys come from a pass that vectorizes, the lookups (gathers) from a second one.
+	template<pixel_t T>
+	class RangeTable
+	{
+		static constexpr bool integer = std::is_same_v<T, uint8_t>;
+		static constexpr int bins_per_unit = 64;
+
+		std::vector<float> table;
+		float scale = 0.0f;
+		int last = 0;
+
+	public:
+		using key_t = std::conditional_t<integer, int, float>;
+
+		RangeTable(float sigma, int colors)
+		{
+			const double inv = 1.0 / (2.0 * static_cast<double>(sigma) * sigma);
+			if constexpr (integer)
+			{
+				last = static_cast<int>(std::min(colors * 255.0 * 255.0 + 1.0, std::ceil(16.0 / inv)));
+				table.assign(last + 1, 0.0f);
+				for (int d2 = 0; d2 < last; d2++)
+					table[d2] = static_cast<float>(std::exp(-d2 * inv));
+			}
+			else
+			{
+				// the interpolation reads one bin ahead of the last one
+				last = 16 * bins_per_unit;
+				table.assign(last + 2, 0.0f);
+				for (int i = 0; i < last; i++)
+					table[i] = static_cast<float>(std::exp(-static_cast<double>(i) / bins_per_unit));
+				scale = static_cast<float>(inv * bins_per_unit);
+			}
+		}
+
+		// squared distance of the first "colors" channels of p and q, clamped to the table
+		template<int colors>
+		key_t Key(const T* p, const T* q) const
+		{
+			const key_t d2 = [&]<int... c>(std::integer_sequence<int, c...>)
+			{
+				return (((static_cast<key_t>(p[c]) - static_cast<key_t>(q[c])) * (static_cast<key_t>(p[c]) - static_cast<key_t>(q[c]))) + ...);
+			}(std::make_integer_sequence<int, colors>{});
+
+			if constexpr (integer)
+				return std::min(d2, last);
+			else
+				return std::min(d2 * scale, static_cast<float>(last));
+		}
+
+		float Weight(key_t key) const
+		{
+			if constexpr (integer)
+			{
+				return table[key];
+			}
+			else
+			{
+				const int i = static_cast<int>(key);
+				const float f = key - static_cast<float>(i);
+				return table[i] + f * (table[i + 1] - table[i]);
+			}
+		}
+	};
+
+	// Bilateral filter over the taps of a disk of the given radius. Every thread takes a band of rows and keeps
+	// the extended source rows of the window in a ring; each tap is added across the whole row at once, so
+	// the accumulation vectorizes and only the range table lookups are gathers. Alpha is averaged with the
+	// weights of the color channels.
+	template<ImageFormat frmt, pixel_t T, BorderType border_type>
+	void BilateralDirect(const Image<frmt, T>& in, Image<frmt, T>& out, int radius, float sigma_color, float sigma_space,
+						 const Pixel<frmt, T>& border_pixel)
+	{
+		constexpr int C = PixelChannels<frmt, T>();
+		constexpr int colors = C - 1;
+		const int width = in.width;
+		const int height = in.height;
+		const int ext_width = width + 2 * radius;
+
+		struct Tap
+		{
+			int dx;
+			int dy;
+			float weight;
+		};
+
+		std::vector<Tap> taps;
+		const double inv_space = 1.0 / (2.0 * static_cast<double>(sigma_space) * sigma_space);
+		for (int dy = -radius; dy <= radius; dy++)
+		{
+			for (int dx = -radius; dx <= radius; dx++)
+			{
+				const int d2 = dx * dx + dy * dy;
+				if (d2 <= radius * radius)
+					taps.push_back({ dx, dy, static_cast<float>(std::exp(-d2 * inv_space)) });
+			}
+		}
+
+		const RangeTable<T> range(sigma_color, colors);
+
+		ParallelFor(0, height, 8, [&](int y0, int y1)
+		{
+			const int n = width;
+			const int r = radius;
+			const int size = 2 * r + 1;
+			constexpr int block = 256;
+
+			std::vector<Pixel<frmt, T>> ring(static_cast<size_t>(size) * ext_width);
+			std::vector<float> sums(static_cast<size_t>(block) * C);
+			std::vector<float> weights(block);
+			std::vector<float> tap_weights(block);
+			std::vector<typename RangeTable<T>::key_t> keys(block);
+
+			const int first_row = y0 - r;
+			const auto slot = [&](int sy) { return reinterpret_cast<const T*>(ring.data() + static_cast<size_t>((sy - first_row) % size) * ext_width); };
+			const auto load = [&](int sy)
+			{
+				Pixel<frmt, T>* dst = ring.data() + static_cast<size_t>((sy - first_row) % size) * ext_width;
+				LoadExtendedRow<border_type>(in, sy, -r, ext_width, border_pixel, dst);
+			};
+
+			for (int sy = first_row; sy < first_row + size - 1; sy++)
+				load(sy);
+
+			float* sum = sums.data();
+			float* weight = weights.data();
+			float* tap_weight = tap_weights.data();
+			auto* key = keys.data();
+
+			for (int y = y0; y < y1; y++)
+			{
+				load(y + r);
+				T* dst = reinterpret_cast<T*>(out.GetRow(y));
+
+				// blocks of the row keep the sums in L1 while all the taps go over them
+				for (int x0 = 0; x0 < n; x0 += block)
+				{
+					const int count = std::min(block, n - x0);
+					std::fill_n(sum, static_cast<size_t>(count) * C, 0.0f);
+					std::fill_n(weight, count, 0.0f);
+
+					// only the table lookups do not vectorize, they get a loop of their own
+					const T* center = slot(y) + (r + x0) * C;
+					for (const Tap& tap : taps)
+					{
+						const T* src = slot(y + tap.dy) + (r + x0 + tap.dx) * C;
+						const float spatial = tap.weight;
+						for (int x = 0; x < count; x++)
+							key[x] = range.template Key<colors>(src + x * C, center + x * C);
+						for (int x = 0; x < count; x++)
+							tap_weight[x] = spatial * range.Weight(key[x]);
+
+						for (int x = 0; x < count; x++)
+						{
+							const float w = tap_weight[x];
+							[&]<int... c>(std::integer_sequence<int, c...>)
+							{
+								((sum[x * C + c] += w * static_cast<float>(src[x * C + c])), ...);
+							}(std::make_integer_sequence<int, C>{});
+							weight[x] += w;
+						}
+					}
+
+					// the center tap weighs 1, the sum of the weights is never 0
+					T* row = dst + x0 * C;
+					for (int x = 0; x < count; x++)
+					{
+						const float inv = 1.0f / weight[x];
+						[&]<int... c>(std::integer_sequence<int, c...>)
+						{
+							((row[x * C + c] = SaturateCast<T>(sum[x * C + c] * inv)), ...);
+						}(std::make_integer_sequence<int, C>{});
+					}
+				}
+			}
+		});
+	}
+
+	// Permutohedral lattice (Adams, Baek and Davis, 2010): Gaussian filtering of V values per point in a
+	// D-dimensional feature space with unit standard deviation. Points are splatted onto the D + 1 vertices
+	// of their enclosing simplex with barycentric weights, the vertices are blurred with a [1 2 1] / 4 kernel
+	// along each of the D + 1 lattice directions, and the points are sliced back with the same weights.
+	// Only the vertices that receive a point exist; they are kept in an open addressing hash table.
+	template<int D, int V>
+	class PermutohedralLattice
+	{
+		// vertices of the simplex enclosing a point and their barycentric weights
+		struct Simplex
+		{
+			int keys[D + 1][D];
+			float weights[D + 1];
+		};
+
+		float scale[D];
+		int canonical[D + 1][D + 1];
+
+		std::vector<int> keys;      // D coordinates per vertex, the last one is minus their sum
+		std::vector<float> values;  // V per vertex
+		std::vector<int> table;     // vertex index, -1 for an empty slot
+		size_t mask = 0;
+
+	public:
+		explicit PermutohedralLattice(int expected_vertices)
+		{
+			const double inv_std_dev = std::sqrt(2.0 / 3.0) * (D + 1);
+			for (int i = 0; i < D; i++)
+				scale[i] = static_cast<float>(inv_std_dev / std::sqrt((i + 1.0) * (i + 2.0)));
+
+			for (int i = 0; i <= D; i++)
+			{
+				for (int j = 0; j <= D; j++)
+					canonical[i][j] = j <= D - i ? i : i - (D + 1);
+			}
+
+			size_t capacity = 1024;
+			while (capacity < 2 * static_cast<size_t>(expected_vertices))
+				capacity *= 2;
+			table.assign(capacity, -1);
+			mask = capacity - 1;
+		}
+
+		int Vertices() const
+		{
+			return static_cast<int>(keys.size() / D);
+		}
+
+		// Add value (V floats) at position (D floats)
+		void Splat(const float* position, const float* value)
+		{
+			Simplex simplex;
+			Embed(position, simplex);
+			for (int k = 0; k <= D; k++)
+			{
+				const int vertex = Insert(simplex.keys[k]);
+				float* v = values.data() + static_cast<size_t>(vertex) * V;
+				for (int i = 0; i < V; i++)
+					v[i] += simplex.weights[k] * value[i];
+			}
+		}
+
+		void Blur()
+		{
+			const int count = Vertices();
+			std::vector<float> blurred(values.size());
+
+			for (int direction = 0; direction <= D; direction++)
+			{
+				ParallelFor(0, count, 1024, [&](int first, int last)
+				{
+					int forward[D], backward[D];
+					for (int vertex = first; vertex < last; vertex++)
+					{
+						// one step along the direction: -D on that coordinate, +1 on all the others
+						const int* key = keys.data() + static_cast<size_t>(vertex) * D;
+						for (int i = 0; i < D; i++)
+						{
+							forward[i] = key[i] + 1;
+							backward[i] = key[i] - 1;
+						}
+						if (direction < D)
+						{
+							forward[direction] = key[direction] - D;
+							backward[direction] = key[direction] + D;
+						}
+
+						const int next = Find(forward);
+						const int previous = Find(backward);
+						const float* v = values.data() + static_cast<size_t>(vertex) * V;
+						float* dst = blurred.data() + static_cast<size_t>(vertex) * V;
+						for (int i = 0; i < V; i++)
+						{
+							float s = 0.5f * v[i];
+							if (next >= 0)
+								s += 0.25f * values[static_cast<size_t>(next) * V + i];
+							if (previous >= 0)
+								s += 0.25f * values[static_cast<size_t>(previous) * V + i];
+							dst[i] = s;
+						}
+					}
+				});
+				values.swap(blurred);
+			}
+		}
+
+		// Interpolated V values at a splatted position
+		void Slice(const float* position, float* value) const
+		{
+			Simplex simplex;
+			Embed(position, simplex);
+			std::fill_n(value, V, 0.0f);
+			for (int k = 0; k <= D; k++)
+			{
+				const float* v = values.data() + static_cast<size_t>(Find(simplex.keys[k])) * V;
+				for (int i = 0; i < V; i++)
+					value[i] += simplex.weights[k] * v[i];
+			}
+		}
+
+	private:
+		// Vertices of the simplex holding the position elevated onto the hyperplane x0 + ... + xD = 0
+		void Embed(const float* position, Simplex& simplex) const
+		{
+			float elevated[D + 1];
+			float sum = 0.0f;
+			for (int i = D; i > 0; i--)
+			{
+				const float cf = position[i - 1] * scale[i - 1];
+				elevated[i] = sum - static_cast<float>(i) * cf;
+				sum += cf;
+			}
+			elevated[0] = sum;
+
+			// nearest point of the lattice scaled by D + 1, whose coordinates sum to (D + 1) * shift
+			int greedy[D + 1];
+			int shift = 0;
+			for (int i = 0; i <= D; i++)
+			{
+				const float v = elevated[i] / (D + 1);
+				const float up = std::ceil(v) * (D + 1);
+				const float down = std::floor(v) * (D + 1);
+				greedy[i] = static_cast<int>(up - elevated[i] < elevated[i] - down ? up : down);
+				shift += greedy[i];
+			}
+			shift /= D + 1;
+
+			int rank[D + 1] = {};
+			for (int i = 0; i < D; i++)
+			{
+				for (int j = i + 1; j <= D; j++)
+				{
+					if (elevated[i] - greedy[i] < elevated[j] - greedy[j])
+						rank[i]++;
+					else
+						rank[j]++;
+				}
+			}
+
+			// bring the point back onto the hyperplane by moving the coordinates furthest from it
+			if (shift > 0)
+			{
+				for (int i = 0; i <= D; i++)
+				{
+					if (rank[i] >= D + 1 - shift)
+					{
+						greedy[i] -= D + 1;
+						rank[i] += shift - (D + 1);
+					}
+					else
+					{
+						rank[i] += shift;
+					}
+				}
+			}
+			else if (shift < 0)
+			{
+				for (int i = 0; i <= D; i++)
+				{
+					if (rank[i] < -shift)
+					{
+						greedy[i] += D + 1;
+						rank[i] += D + 1 + shift;
+					}
+					else
+					{
+						rank[i] += shift;
+					}
+				}
+			}
+
+			float barycentric[D + 2] = {};
+			for (int i = 0; i <= D; i++)
+			{
+				const float delta = (elevated[i] - static_cast<float>(greedy[i])) / (D + 1);
+				barycentric[D - rank[i]] += delta;
+				barycentric[D + 1 - rank[i]] -= delta;
+			}
+			barycentric[0] += 1.0f + barycentric[D + 1];
+
+			for (int k = 0; k <= D; k++)
+			{
+				for (int i = 0; i < D; i++)
+					simplex.keys[k][i] = greedy[i] + canonical[k][rank[i]];
+				simplex.weights[k] = barycentric[k];
+			}
+		}
+
+		size_t Slot(const int* key) const
+		{
+			size_t h = 0;
+			for (int i = 0; i < D; i++)
+			{
+				h += static_cast<size_t>(static_cast<unsigned>(key[i]));
+				h *= 2531011;
+			}
+			return (h ^ (h >> 29)) & mask;
+		}
+
+		int Find(const int* key) const
+		{
+			for (size_t s = Slot(key);; s = (s + 1) & mask)
+			{
+				const int vertex = table[s];
+				if (vertex < 0 || std::equal(key, key + D, keys.data() + static_cast<size_t>(vertex) * D))
+					return vertex;
+			}
+		}
+
+		int Insert(const int* key)
+		{
+			size_t s = Slot(key);
+			for (;; s = (s + 1) & mask)
+			{
+				const int vertex = table[s];
+				if (vertex < 0)
+					break;
+				if (std::equal(key, key + D, keys.data() + static_cast<size_t>(vertex) * D))
+					return vertex;
+			}
+
+			const int vertex = Vertices();
+			keys.insert(keys.end(), key, key + D);
+			values.resize(values.size() + V, 0.0f);
+			table[s] = vertex;
+
+			// keep the table at most half full
+			if (2 * keys.size() / D > table.size())
+			{
+				table.assign(2 * table.size(), -1);
+				mask = table.size() - 1;
+				for (int v = 0; v <= vertex; v++)
+				{
+					size_t t = Slot(keys.data() + static_cast<size_t>(v) * D);
+					while (table[t] >= 0)
+						t = (t + 1) & mask;
+					table[t] = v;
+				}
+			}
+			return vertex;
+		}
+	};
+
+	// Bilateral filter through a permutohedral lattice over (x / sigma_space, y / sigma_space, color / sigma_color):
+	// the cost per pixel does not depend on the sigmas. The image is extended by "radius" with the border type
+	// and every extended pixel is splatted, so the window is the square of that radius rather than the disk;
+	// with a radius of at least 3 sigma_space the corners hold about 1% of the spatial weight. Splatting fills
+	// the hash table and runs on one thread, blurring and slicing are split over all threads.
+	template<ImageFormat frmt, pixel_t T, BorderType border_type>
+	void BilateralLattice(const Image<frmt, T>& in, Image<frmt, T>& out, int radius, float sigma_color, float sigma_space,
+						  const Pixel<frmt, T>& border_pixel)
+	{
+		constexpr int C = PixelChannels<frmt, T>();
+		constexpr int colors = C - 1;
+		constexpr int D = 2 + colors;
+		constexpr int V = C + 1;
+		const int width = in.width;
+		const int height = in.height;
+		const int ext_width = width + 2 * radius;
+
+		const float inv_space = 1.0f / sigma_space;
+		const float inv_color = 1.0f / sigma_color;
+		const auto features = [&](const T* p, int x, int y, float* position)
+		{
+			position[0] = static_cast<float>(x) * inv_space;
+			position[1] = static_cast<float>(y) * inv_space;
+			for (int c = 0; c < colors; c++)
+				position[2 + c] = static_cast<float>(p[c]) * inv_color;
+		};
+
+		// a first guess of the vertex count, the table grows as needed
+		const double pixels = static_cast<double>(ext_width) * (height + 2 * radius);
+		PermutohedralLattice<D, V> lattice(static_cast<int>(pixels / std::max(1.0f, sigma_space * sigma_space)));
+
+		std::vector<Pixel<frmt, T>> ext(ext_width);
+		for (int y = -radius; y < height + radius; y++)
+		{
+			LoadExtendedRow<border_type>(in, y, -radius, ext_width, border_pixel, ext.data());
+			const T* src = reinterpret_cast<const T*>(ext.data());
+			for (int i = 0; i < ext_width; i++)
+			{
+				float position[D];
+				float value[V];
+				features(src + i * C, i - radius, y, position);
+				for (int c = 0; c < C; c++)
+					value[c] = static_cast<float>(src[i * C + c]);
+				value[C] = 1.0f;
+				lattice.Splat(position, value);
+			}
+		}
+
+		lattice.Blur();
+
+		ParallelFor(0, height, 16, [&](int y0, int y1)
+		{
+			for (int y = y0; y < y1; y++)
+			{
+				const T* src = reinterpret_cast<const T*>(in.GetRow(y));
+				T* dst = reinterpret_cast<T*>(out.GetRow(y));
+				for (int x = 0; x < width; x++)
+				{
+					float position[D];
+					float value[V];
+					features(src + x * C, x, y, position);
+					lattice.Slice(position, value);
+
+					// the pixel's own splat keeps the weight positive
+					const float inv = 1.0f / value[C];
+					for (int c = 0; c < C; c++)
+						dst[x * C + c] = SaturateCast<T>(value[c] * inv);
+				}
+			}
+		});
+	}
+}
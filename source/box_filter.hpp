@@ -0,0 +1,85 @@
+#pragma once
+
+#include "image.hpp"
+#include "integral_image.hpp"
+#include "neighborhood.hpp"
+#include "parallel.hpp"
+#include "saturate.hpp"
+#include <vector>
+
+namespace qlm::detail
+{
+	// Box sums (or means when "normalize" is set) over kw x kh windows centered on (kw / 2, kh / 2).
+	// Every thread takes a band of rows and keeps running column sums over the window: a new row is added
+	// and the row leaving the window subtracted, then a running sum along the row gives every box sum.
+	// The cost per pixel does not depend on the window size. Sums use the integral_t accumulators, whose
+	// unsigned wrap-around cancels in the differences.
+	template<ImageFormat frmt, pixel_t T, BorderType border_type>
+	void BoxFilterRunning(const Image<frmt, T>& in, Image<frmt, T>& out, int kw, int kh, bool normalize, const Pixel<frmt, T>& border_pixel)
+	{
+		using sum_t = integral_t<T>;
+		using scale_t = std::conditional_t<(sizeof(sum_t) <= 4), float, double>;
+
+		constexpr int C = PixelChannels<frmt, T>();
+		const int width = in.width;
+		const int height = in.height;
+		const int ax = kw / 2;
+		const int ay = kh / 2;
+		const int ext_width = width + kw - 1;
+		const scale_t scale = normalize ? scale_t(1) / (scale_t(kw) * scale_t(kh)) : scale_t(1);
+
+		ParallelFor(0, height, std::max(32, 2 * kh), [&](int y0, int y1)
+		{
+			const int n = ext_width * C;
+			const int out_n = width * C;
+
+			std::vector<Pixel<frmt, T>> entering(ext_width), leaving(ext_width);
+			std::vector<sum_t> column(n, sum_t(0));
+			std::vector<sum_t> box(out_n);
+
+			for (int sy = y0 - ay; sy < y0 - ay + kh; sy++)
+			{
+				LoadExtendedRow<border_type>(in, sy, -ax, ext_width, border_pixel, entering.data());
+				const T* s = reinterpret_cast<const T*>(entering.data());
+				for (int i = 0; i < n; i++)
+					column[i] += static_cast<sum_t>(s[i]);
+			}
+
+			for (int y = y0; y < y1; y++)
+			{
+				if (y > y0)
+				{
+					LoadExtendedRow<border_type>(in, y - ay + kh - 1, -ax, ext_width, border_pixel, entering.data());
+					LoadExtendedRow<border_type>(in, y - ay - 1, -ax, ext_width, border_pixel, leaving.data());
+					const T* add = reinterpret_cast<const T*>(entering.data());
+					const T* sub = reinterpret_cast<const T*>(leaving.data());
+					for (int i = 0; i < n; i++)
+						column[i] += static_cast<sum_t>(add[i]) - static_cast<sum_t>(sub[i]);
+				}
+
+				sum_t run[C] = {};
+				for (int k = 0; k < kw; k++)
+				{
+					for (int c = 0; c < C; c++)
+						run[c] += column[k * C + c];
+				}
+
+				for (int c = 0; c < C; c++)
+					box[c] = run[c];
+
+				for (int x = 1; x < width; x++)
+				{
+					for (int c = 0; c < C; c++)
+					{
+						run[c] += column[(x + kw - 1) * C + c] - column[(x - 1) * C + c];
+						box[x * C + c] = run[c];
+					}
+				}
+
+				T* dst = reinterpret_cast<T*>(out.GetRow(y));
+				for (int i = 0; i < out_n; i++)
+					dst[i] = SaturateCast<T>(static_cast<scale_t>(box[i]) * scale);
+			}
+		});
+	}
+}
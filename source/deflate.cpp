@@ -0,0 +1,835 @@
+#include "deflate.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <queue>
+
+namespace qlm::detail
+{
+	// -------------------------------------------------------------------------------------------------------------
+	// checksums
+	// -------------------------------------------------------------------------------------------------------------
+	// slicing-by-8 tables: crc_table[k][n] is the CRC of byte n followed by k zero bytes
+	static const std::array<std::array<uint32_t, 256>, 8> crc_table = []()
+	{
+		std::array<std::array<uint32_t, 256>, 8> table{};
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[0][n] = c;
+		}
+		for (int k = 1; k < 8; k++)
+		{
+			for (uint32_t n = 0; n < 256; n++)
+				table[k][n] = table[0][table[k - 1][n] & 0xFF] ^ (table[k - 1][n] >> 8);
+		}
+		return table;
+	}();
+
+	uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size)
+	{
+		crc = ~crc;
+
+		// eight bytes per step, the loads are little-endian
+		for (; size >= 8; size -= 8, data += 8)
+		{
+			const uint32_t lo = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24));
+			const uint32_t hi = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<uint32_t>(data[7]) << 24);
+
+			crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF] ^ crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24] ^
+				  crc_table[3][hi & 0xFF] ^ crc_table[2][(hi >> 8) & 0xFF] ^ crc_table[1][(hi >> 16) & 0xFF] ^ crc_table[0][hi >> 24];
+		}
+
+		for (size_t i = 0; i < size; i++)
+			crc = crc_table[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t size)
+	{
+		constexpr uint32_t mod = 65521;
+		// largest n such that 255n(n+1)/2 + (n+1)(mod-1) fits in 32 bits
+		constexpr size_t nmax = 5552;
+
+		uint32_t s1 = adler & 0xFFFF;
+		uint32_t s2 = adler >> 16;
+
+		while (size > 0)
+		{
+			const size_t n = std::min(size, nmax);
+			for (size_t i = 0; i < n; i++)
+			{
+				s1 += data[i];
+				s2 += s1;
+			}
+			s1 %= mod;
+			s2 %= mod;
+			data += n;
+			size -= n;
+		}
+
+		return (s2 << 16) | s1;
+	}
+
+	uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2)
+	{
+		constexpr uint32_t mod = 65521;
+
+		const uint32_t rem = static_cast<uint32_t>(size2 % mod);
+		uint32_t s1 = adler1 & 0xFFFF;
+		uint32_t s2 = static_cast<uint32_t>((static_cast<uint64_t>(rem) * s1) % mod);
+
+		s1 += (adler2 & 0xFFFF) + mod - 1;
+		s2 += (adler1 >> 16) + (adler2 >> 16) + mod - rem;
+
+		if (s1 >= mod)
+			s1 -= mod;
+		if (s1 >= mod)
+			s1 -= mod;
+		if (s2 >= 2 * mod)
+			s2 -= 2 * mod;
+		if (s2 >= mod)
+			s2 -= mod;
+
+		return (s2 << 16) | s1;
+	}
+
+	// -------------------------------------------------------------------------------------------------------------
+	// deflate tables
+	// -------------------------------------------------------------------------------------------------------------
+	static constexpr int num_lit_len = 286;
+	static constexpr int num_dist = 30;
+	static constexpr int num_code_len = 19;
+
+	static constexpr uint16_t len_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static constexpr uint8_t len_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static constexpr uint16_t dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static constexpr uint8_t dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	static constexpr uint8_t code_len_order[num_code_len] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// index in len_base of a match length (3 .. 258)
+	static int LengthIndex(int len)
+	{
+		if (len == 258)
+			return 28;
+
+		const int l = len - 3;
+		if (l < 8)
+			return l;
+
+		const int log = std::bit_width(static_cast<unsigned>(l)) - 1;
+		return 4 * (log - 1) + ((l >> (log - 2)) & 3);
+	}
+
+	// index in dist_base of a match distance (1 .. 32768)
+	static int DistIndex(int dist)
+	{
+		const int d = dist - 1;
+		if (d < 4)
+			return d;
+
+		const int log = std::bit_width(static_cast<unsigned>(d)) - 1;
+		return 2 * log + ((d >> (log - 1)) & 1);
+	}
+
+	static uint32_t ReverseBits(uint32_t code, int len)
+	{
+		uint32_t res = 0;
+		for (int i = 0; i < len; i++, code >>= 1)
+			res = (res << 1) | (code & 1);
+		return res;
+	}
+
+	// Huffman code lengths limited to max_bits, every tree gets at least two codes so it is always complete
+	static void BuildLengths(std::vector<uint32_t> freq, int max_bits, std::vector<uint8_t>& lengths)
+	{
+		const int n = static_cast<int>(freq.size());
+		lengths.assign(n, 0);
+
+		int used = static_cast<int>(std::count_if(freq.begin(), freq.end(), [](uint32_t f) { return f != 0; }));
+		for (int i = 0; used < 2 && i < n; i++)
+		{
+			if (freq[i] == 0)
+			{
+				freq[i] = 1;
+				used++;
+			}
+		}
+
+		// plain Huffman tree
+		struct Node
+		{
+			uint64_t weight;
+			int index;
+		};
+		const auto cmp = [](const Node& a, const Node& b) { return a.weight > b.weight; };
+		std::priority_queue<Node, std::vector<Node>, decltype(cmp)> queue(cmp);
+
+		std::vector<int> parent(2 * n, -1);
+		int next_node = n;
+		for (int i = 0; i < n; i++)
+		{
+			if (freq[i] != 0)
+				queue.push({ freq[i], i });
+		}
+		while (queue.size() > 1)
+		{
+			const Node a = queue.top(); queue.pop();
+			const Node b = queue.top(); queue.pop();
+			parent[a.index] = next_node;
+			parent[b.index] = next_node;
+			queue.push({ a.weight + b.weight, next_node++ });
+		}
+
+		std::vector<int> depth(next_node, 0);
+		for (int i = next_node - 2; i >= 0; i--)
+		{
+			if (parent[i] >= 0)
+				depth[i] = depth[parent[i]] + 1;
+		}
+
+		// limit the lengths, then repair the Kraft inequality
+		std::vector<int> bl_count(max_bits + 1, 0);
+		for (int i = 0; i < n; i++)
+		{
+			if (freq[i] != 0)
+				bl_count[std::min(depth[i], max_bits)]++;
+		}
+
+		uint32_t total = 0;
+		for (int i = 1; i <= max_bits; i++)
+			total += static_cast<uint32_t>(bl_count[i]) << (max_bits - i);
+
+		while (total > (1u << max_bits))
+		{
+			bl_count[max_bits]--;
+			for (int i = max_bits - 1; i > 0; i--)
+			{
+				if (bl_count[i] != 0)
+				{
+					bl_count[i]--;
+					bl_count[i + 1] += 2;
+					break;
+				}
+			}
+			total--;
+		}
+
+		// most frequent symbols get the shortest codes
+		std::vector<int> order;
+		for (int i = 0; i < n; i++)
+		{
+			if (freq[i] != 0)
+				order.push_back(i);
+		}
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return freq[a] > freq[b]; });
+
+		int k = 0;
+		for (int len = 1; len <= max_bits; len++)
+		{
+			for (int c = 0; c < bl_count[len]; c++)
+				lengths[order[k++]] = static_cast<uint8_t>(len);
+		}
+	}
+
+	static void BuildCodes(const std::vector<uint8_t>& lengths, std::vector<uint16_t>& codes)
+	{
+		int bl_count[16]{};
+		for (uint8_t len : lengths)
+			bl_count[len]++;
+		bl_count[0] = 0;
+
+		uint32_t next_code[16]{};
+		uint32_t code = 0;
+		for (int bits = 1; bits < 16; bits++)
+		{
+			code = (code + bl_count[bits - 1]) << 1;
+			next_code[bits] = code;
+		}
+
+		codes.assign(lengths.size(), 0);
+		for (size_t i = 0; i < lengths.size(); i++)
+		{
+			if (lengths[i] != 0)
+				codes[i] = static_cast<uint16_t>(ReverseBits(next_code[lengths[i]]++, lengths[i]));
+		}
+	}
+
+	// run-length encoding of the code lengths with symbols 16, 17 and 18
+	struct CodeLengthSymbol
+	{
+		uint8_t symbol;
+		uint8_t extra;
+	};
+
+	static void RunLengthLengths(const std::vector<uint8_t>& lengths, std::vector<CodeLengthSymbol>& out)
+	{
+		const size_t n = lengths.size();
+		size_t i = 0;
+		while (i < n)
+		{
+			const uint8_t v = lengths[i];
+			size_t run = 1;
+			while (i + run < n && lengths[i + run] == v)
+				run++;
+			i += run;
+
+			if (v == 0)
+			{
+				while (run >= 11)
+				{
+					const size_t r = std::min<size_t>(run, 138);
+					out.push_back({ 18, static_cast<uint8_t>(r - 11) });
+					run -= r;
+				}
+				if (run >= 3)
+				{
+					out.push_back({ 17, static_cast<uint8_t>(run - 3) });
+					run = 0;
+				}
+			}
+			else
+			{
+				out.push_back({ v, 0 });
+				run--;
+				while (run >= 3)
+				{
+					const size_t r = std::min<size_t>(run, 6);
+					out.push_back({ 16, static_cast<uint8_t>(r - 3) });
+					run -= r;
+				}
+			}
+
+			for (; run > 0; run--)
+				out.push_back({ v, 0 });
+		}
+	}
+
+	static const std::vector<uint8_t>& FixedLitLengths()
+	{
+		static const std::vector<uint8_t> lengths = []()
+		{
+			std::vector<uint8_t> l(288);
+			std::fill(l.begin(), l.begin() + 144, 8);
+			std::fill(l.begin() + 144, l.begin() + 256, 9);
+			std::fill(l.begin() + 256, l.begin() + 280, 7);
+			std::fill(l.begin() + 280, l.end(), 8);
+			return l;
+		}();
+		return lengths;
+	}
+
+	// -------------------------------------------------------------------------------------------------------------
+	// Deflater
+	// -------------------------------------------------------------------------------------------------------------
+	Deflater::Deflater(int level, Sink sink, DeflateStrategy strategy) : sink(std::move(sink)), level(std::clamp(level, 0, 9)),
+		strategy(strategy), window(2 * window_size + sizeof(uint64_t))
+	{
+		// the hash chains are only needed for LZ77 searches
+		if (this->level > 0 && strategy == DeflateStrategy::DEFAULT)
+		{
+			head.assign(hash_size, -1);
+			prev.assign(window_size, -1);
+		}
+
+		// same trade-offs as zlib
+		struct Config
+		{
+			int good, lazy, nice, chain;
+		};
+		static constexpr Config config[10] = {
+			{ 0, 0, 0, 0 },
+			{ 4, 4, 8, 4 },
+			{ 4, 5, 16, 8 },
+			{ 4, 6, 32, 32 },
+			{ 4, 4, 16, 16 },
+			{ 8, 16, 32, 32 },
+			{ 8, 16, 128, 128 },
+			{ 8, 32, 128, 256 },
+			{ 32, 128, 258, 1024 },
+			{ 32, 258, 258, 4096 },
+		};
+
+		good_length = config[this->level].good;
+		max_lazy = config[this->level].lazy;
+		nice_length = config[this->level].nice;
+		max_chain = config[this->level].chain;
+		lazy = this->level >= 4;
+
+		symbols.reserve(max_symbols);
+	}
+
+	void Deflater::PutBits(uint32_t bits, int count)
+	{
+		bit_buf |= static_cast<uint64_t>(bits) << bit_count;
+		bit_count += count;
+
+		// whole 32-bit words are moved to the output, the rest waits in the bit buffer
+		if (bit_count >= 32)
+		{
+			const size_t n = out.size();
+			out.resize(n + 4);
+			for (int i = 0; i < 4; i++)
+				out[n + i] = static_cast<uint8_t>(bit_buf >> (8 * i));
+			bit_buf >>= 32;
+			bit_count -= 32;
+		}
+	}
+
+	void Deflater::DrainBits()
+	{
+		while (bit_count >= 8)
+		{
+			out.push_back(static_cast<uint8_t>(bit_buf));
+			bit_buf >>= 8;
+			bit_count -= 8;
+		}
+	}
+
+	void Deflater::AlignToByte()
+	{
+		if (bit_count % 8 != 0)
+			PutBits(0, 8 - bit_count % 8);
+		DrainBits();
+	}
+
+	void Deflater::FlushOutput(bool force)
+	{
+		if (force)
+			DrainBits();
+
+		if (!out.empty() && (force || out.size() >= sink_threshold))
+		{
+			sink(out.data(), out.size());
+			out.clear();
+		}
+	}
+
+	void Deflater::Slide()
+	{
+		// the pending block refers to bytes that are about to move
+		EmitBlock(false);
+
+		std::memmove(window.data(), window.data() + window_size, window_size);
+		window_end -= window_size;
+		pos -= window_size;
+		next_insert -= window_size;
+		block_start -= window_size;
+		symbols_end -= window_size;
+		dict_start -= window_size;
+
+		const auto shift = [](int32_t& v) { v = v >= window_size ? v - window_size : -1; };
+		std::for_each(head.begin(), head.end(), shift);
+		std::for_each(prev.begin(), prev.end(), shift);
+	}
+
+	void Deflater::ResetDictionary()
+	{
+		std::fill(head.begin(), head.end(), -1);
+		std::fill(prev.begin(), prev.end(), -1);
+		next_insert = pos;
+		dict_start = pos;
+	}
+
+	void Deflater::InsertUpTo(int p)
+	{
+		const int last = std::min(p, window_end - min_match);
+		for (; next_insert <= last; next_insert++)
+		{
+			const uint8_t* s = &window[next_insert];
+			const uint32_t v = s[0] | (s[1] << 8) | (s[2] << 16);
+			const int h = static_cast<int>((v * 2654435761u) >> (32 - hash_bits));
+			prev[next_insert & window_mask] = head[h];
+			head[h] = next_insert;
+		}
+		next_insert = std::max(next_insert, p + 1);
+	}
+
+	int Deflater::FindMatch(int p, int chain, int& match_dist) const
+	{
+		const int max_len = std::min(max_match, window_end - p);
+		if (max_len < min_match || chain == 0)
+			return 0;
+
+		const uint8_t* s = &window[p];
+		int best_len = min_match - 1;
+		int cand = prev[p & window_mask];
+
+		while (cand >= 0 && p - cand <= max_dist && chain-- > 0)
+		{
+			const uint8_t* c = &window[cand];
+			if (c[best_len] == s[best_len] && c[0] == s[0] && c[1] == s[1])
+			{
+				// compare 8 bytes at a time, the window is padded so the loads stay in bounds
+				int len = 2;
+				while (len + 8 <= max_len)
+				{
+					uint64_t a, b;
+					std::memcpy(&a, c + len, 8);
+					std::memcpy(&b, s + len, 8);
+					if (a != b)
+					{
+						len += std::endian::native == std::endian::little ? std::countr_zero(a ^ b) / 8 : std::countl_zero(a ^ b) / 8;
+						break;
+					}
+					len += 8;
+				}
+				while (len < max_len && c[len] == s[len])
+					len++;
+
+				if (len > best_len)
+				{
+					best_len = len;
+					match_dist = p - cand;
+					if (len >= nice_length || len == max_len)
+						break;
+				}
+			}
+
+			const int next = prev[cand & window_mask];
+			if (next >= cand)
+				break;
+			cand = next;
+		}
+
+		return best_len >= min_match ? best_len : 0;
+	}
+
+	void Deflater::Compress(bool flush)
+	{
+		const int limit = flush ? window_end : window_end - min_lookahead;
+
+		if (level == 0)
+		{
+			pos = std::max(pos, limit);
+			symbols_end = pos;
+		}
+		else if (strategy == DeflateStrategy::RLE)
+		{
+			while (pos < limit)
+			{
+				int len = 0;
+				if (pos > dict_start)
+				{
+					const int max_len = std::min(max_match, window_end - pos);
+					const uint8_t c = window[pos - 1];
+					while (len < max_len && window[pos + len] == c)
+						len++;
+				}
+
+				if (len >= min_match)
+				{
+					symbols.push_back({ static_cast<uint16_t>(len), 1 });
+					pos += len;
+				}
+				else
+				{
+					symbols.push_back({ window[pos], 0 });
+					pos++;
+				}
+				symbols_end = pos;
+
+				if (symbols.size() >= max_symbols)
+					EmitBlock(false);
+			}
+		}
+		else if (!lazy)
+		{
+			// greedy: take the first match found
+			while (pos < limit)
+			{
+				int dist = 0;
+				InsertUpTo(pos);
+				const int len = FindMatch(pos, max_chain, dist);
+
+				if (len == 0)
+				{
+					symbols.push_back({ window[pos], 0 });
+					pos++;
+				}
+				else
+				{
+					symbols.push_back({ static_cast<uint16_t>(len), static_cast<uint16_t>(dist) });
+
+					// only the bytes of short matches are indexed
+					if (len <= max_lazy)
+						InsertUpTo(pos + len - 1);
+					else
+						next_insert = pos + len;
+					pos += len;
+				}
+				symbols_end = pos;
+
+				if (symbols.size() >= max_symbols)
+					EmitBlock(false);
+			}
+		}
+		else
+		{
+			// lazy: a match is emitted only if the next position does not start a longer one
+			while (pos < limit)
+			{
+				int dist = 0;
+				int len = 0;
+				InsertUpTo(pos);
+
+				if (prev_length < max_lazy)
+					len = FindMatch(pos, prev_length >= good_length ? max_chain >> 2 : max_chain, dist);
+
+				if (prev_length >= min_match && len <= prev_length)
+				{
+					const int start = pos - 1;
+					symbols.push_back({ static_cast<uint16_t>(prev_length), static_cast<uint16_t>(prev_dist) });
+					InsertUpTo(start + prev_length - 1);
+					pos = start + prev_length;
+					symbols_end = pos;
+					match_available = false;
+					prev_length = 0;
+				}
+				else
+				{
+					if (match_available)
+					{
+						symbols.push_back({ window[pos - 1], 0 });
+						symbols_end = pos;
+					}
+					match_available = true;
+					prev_length = len;
+					prev_dist = dist;
+					pos++;
+				}
+
+				if (symbols.size() >= max_symbols)
+					EmitBlock(false);
+			}
+
+			if (flush && match_available)
+			{
+				symbols.push_back({ window[pos - 1], 0 });
+				symbols_end = pos;
+				match_available = false;
+				prev_length = 0;
+			}
+		}
+	}
+
+	void Deflater::EmitStored(bool final)
+	{
+		int start = block_start;
+		const int end = symbols_end;
+
+		do
+		{
+			const int len = std::min(end - start, 65535);
+			const bool last = start + len == end;
+
+			PutBits((final && last) ? 1 : 0, 1);
+			PutBits(0, 2);
+			AlignToByte();
+			PutBits(len, 16);
+			PutBits(~len & 0xFFFF, 16);
+			out.insert(out.end(), window.begin() + start, window.begin() + start + len);
+
+			start += len;
+		} while (start < end);
+	}
+
+	void Deflater::EmitBlock(bool final)
+	{
+		if (symbols.empty() && symbols_end == block_start && !final)
+			return;
+
+		// stored blocks need no trees
+		if (level == 0 && symbols_end > block_start)
+		{
+			EmitStored(final);
+			block_start = symbols_end;
+			FlushOutput(false);
+			return;
+		}
+
+		// frequencies
+		std::vector<uint32_t> lit_freq(num_lit_len, 0);
+		std::vector<uint32_t> dist_freq(num_dist, 0);
+		uint64_t extra_bits = 0;
+
+		for (const Symbol& sym : symbols)
+		{
+			if (sym.dist == 0)
+			{
+				lit_freq[sym.lit_len]++;
+			}
+			else
+			{
+				const int li = LengthIndex(sym.lit_len);
+				const int di = DistIndex(sym.dist);
+				lit_freq[257 + li]++;
+				dist_freq[di]++;
+				extra_bits += len_extra[li] + dist_extra[di];
+			}
+		}
+		lit_freq[256] = 1;
+
+		// dynamic trees
+		std::vector<uint8_t> lit_len, dist_len;
+		BuildLengths(lit_freq, 15, lit_len);
+		BuildLengths(dist_freq, 15, dist_len);
+
+		int hlit = num_lit_len;
+		while (hlit > 257 && lit_len[hlit - 1] == 0)
+			hlit--;
+		int hdist = num_dist;
+		while (hdist > 1 && dist_len[hdist - 1] == 0)
+			hdist--;
+
+		std::vector<uint8_t> all_len(lit_len.begin(), lit_len.begin() + hlit);
+		all_len.insert(all_len.end(), dist_len.begin(), dist_len.begin() + hdist);
+
+		std::vector<CodeLengthSymbol> cl_symbols;
+		RunLengthLengths(all_len, cl_symbols);
+
+		std::vector<uint32_t> cl_freq(num_code_len, 0);
+		for (const CodeLengthSymbol& s : cl_symbols)
+			cl_freq[s.symbol]++;
+
+		std::vector<uint8_t> cl_len;
+		BuildLengths(cl_freq, 7, cl_len);
+
+		int hclen = num_code_len;
+		while (hclen > 4 && cl_len[code_len_order[hclen - 1]] == 0)
+			hclen--;
+
+		// sizes in bits of the three block types
+		const std::vector<uint8_t>& fixed_lit = FixedLitLengths();
+		uint64_t dynamic_bits = 3 + 14 + 3 * hclen + extra_bits;
+		uint64_t fixed_bits = 3 + extra_bits;
+
+		for (const CodeLengthSymbol& s : cl_symbols)
+			dynamic_bits += cl_len[s.symbol] + (s.symbol == 16 ? 2 : s.symbol == 17 ? 3 : s.symbol == 18 ? 7 : 0);
+		for (int i = 0; i < num_lit_len; i++)
+		{
+			dynamic_bits += static_cast<uint64_t>(lit_freq[i]) * lit_len[i];
+			fixed_bits += static_cast<uint64_t>(lit_freq[i]) * fixed_lit[i];
+		}
+		for (int i = 0; i < num_dist; i++)
+		{
+			dynamic_bits += static_cast<uint64_t>(dist_freq[i]) * dist_len[i];
+			fixed_bits += static_cast<uint64_t>(dist_freq[i]) * 5;
+		}
+
+		const uint64_t raw_bytes = symbols_end - block_start;
+		const uint64_t stored_bits = raw_bytes * 8 + ((raw_bytes + 65534) / 65535) * 40 + 8;
+
+		if (raw_bytes > 0 && (level == 0 || stored_bits <= std::min(dynamic_bits, fixed_bits)))
+		{
+			EmitStored(final);
+		}
+		else
+		{
+			std::vector<uint8_t> dist_lengths = dist_len;
+			const bool dynamic = dynamic_bits < fixed_bits;
+
+			if (dynamic)
+			{
+				PutBits(final ? 1 : 0, 1);
+				PutBits(2, 2);
+				PutBits(hlit - 257, 5);
+				PutBits(hdist - 1, 5);
+				PutBits(hclen - 4, 4);
+				for (int i = 0; i < hclen; i++)
+					PutBits(cl_len[code_len_order[i]], 3);
+
+				std::vector<uint16_t> cl_codes;
+				BuildCodes(cl_len, cl_codes);
+				for (const CodeLengthSymbol& s : cl_symbols)
+				{
+					PutBits(cl_codes[s.symbol], cl_len[s.symbol]);
+					if (s.symbol == 16)
+						PutBits(s.extra, 2);
+					else if (s.symbol == 17)
+						PutBits(s.extra, 3);
+					else if (s.symbol == 18)
+						PutBits(s.extra, 7);
+				}
+			}
+			else
+			{
+				PutBits(final ? 1 : 0, 1);
+				PutBits(1, 2);
+				lit_len = fixed_lit;
+				dist_lengths.assign(num_dist, 5);
+			}
+
+			std::vector<uint16_t> lit_codes, dist_codes;
+			BuildCodes(lit_len, lit_codes);
+			BuildCodes(dist_lengths, dist_codes);
+
+			for (const Symbol& sym : symbols)
+			{
+				if (sym.dist == 0)
+				{
+					PutBits(lit_codes[sym.lit_len], lit_len[sym.lit_len]);
+				}
+				else
+				{
+					const int li = LengthIndex(sym.lit_len);
+					const int di = DistIndex(sym.dist);
+					PutBits(lit_codes[257 + li], lit_len[257 + li]);
+					PutBits(sym.lit_len - len_base[li], len_extra[li]);
+					PutBits(dist_codes[di], dist_lengths[di]);
+					PutBits(sym.dist - dist_base[di], dist_extra[di]);
+				}
+			}
+			PutBits(lit_codes[256], lit_len[256]);
+		}
+
+		symbols.clear();
+		block_start = symbols_end;
+		FlushOutput(false);
+	}
+
+	void Deflater::Write(const uint8_t* data, size_t size)
+	{
+		while (size > 0)
+		{
+			if (window_end == 2 * window_size)
+				Slide();
+
+			const size_t n = std::min(size, static_cast<size_t>(2 * window_size - window_end));
+			std::memcpy(&window[window_end], data, n);
+			window_end += static_cast<int>(n);
+			data += n;
+			size -= n;
+
+			Compress(false);
+		}
+	}
+
+	void Deflater::Flush(bool full)
+	{
+		Compress(true);
+		EmitBlock(false);
+
+		// empty stored block
+		PutBits(0, 3);
+		AlignToByte();
+		PutBits(0x0000, 16);
+		PutBits(0xFFFF, 16);
+
+		if (full)
+			ResetDictionary();
+
+		FlushOutput(true);
+	}
+
+	void Deflater::Finish()
+	{
+		Compress(true);
+		EmitBlock(true);
+		AlignToByte();
+		FlushOutput(true);
+	}
+}
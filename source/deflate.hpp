@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace qlm::detail
+{
+	// Checksums used by zlib and PNG
+	uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size);
+
+	uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t size);
+
+	// Adler-32 of the concatenation of two buffers from their checksums and the length of the second one
+	uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2);
+
+	enum class DeflateStrategy
+	{
+		DEFAULT, // LZ77 with hash chains, effort set by the level
+		RLE,     // only runs of the previous byte (distance 1), no hashing; much faster, good on filtered images
+	};
+
+	// Streaming deflate (RFC 1951) compressor.
+	// Input can be pushed in any amount, compressed bytes are handed to the sink as they are produced.
+	// Memory usage is constant: a 64K sliding window plus the hash chains and the pending block.
+	class Deflater
+	{
+	public:
+		using Sink = std::function<void(const uint8_t*, size_t)>;
+
+	private:
+		static constexpr int window_size = 1 << 15;
+		static constexpr int window_mask = window_size - 1;
+		static constexpr int hash_bits = 15;
+		static constexpr int hash_size = 1 << hash_bits;
+		static constexpr int min_match = 3;
+		static constexpr int max_match = 258;
+		static constexpr int min_lookahead = max_match + min_match + 1;
+		static constexpr int max_dist = window_size - min_lookahead;
+		static constexpr size_t max_symbols = 1 << 14;
+		static constexpr size_t sink_threshold = 1 << 16;
+
+		struct Symbol
+		{
+			uint16_t lit_len; // literal byte or match length
+			uint16_t dist;    // 0 for literals
+		};
+
+		Sink sink;
+		int level;
+		DeflateStrategy strategy;
+		int max_chain;
+		int nice_length;
+		int good_length; // shorten the search when the pending match is already this long
+		int max_lazy;    // lazy levels: no second search above this length, fast levels: max length whose bytes are indexed
+		bool lazy;
+
+		std::vector<uint8_t> window;
+		std::vector<int32_t> head;
+		std::vector<int32_t> prev;
+		int window_end{ 0 };  // number of valid bytes in the window
+		int pos{ 0 };         // next byte to encode
+		int next_insert{ 0 }; // next position to insert in the hash chains
+		int block_start{ 0 }; // first byte of the pending block
+		int symbols_end{ 0 }; // end of the bytes covered by the pending symbols
+		int dict_start{ 0 };  // matches cannot reach before this position
+
+		// lazy matching state: a match (or literal) found at pos - 1 and not emitted yet
+		bool match_available{ false };
+		int prev_length{ 0 };
+		int prev_dist{ 0 };
+
+		std::vector<Symbol> symbols;
+
+		std::vector<uint8_t> out;
+		uint64_t bit_buf{ 0 };
+		int bit_count{ 0 };
+
+	private:
+		void PutBits(uint32_t bits, int count);
+		void DrainBits();
+		void AlignToByte();
+		void FlushOutput(bool force);
+
+		void Slide();
+		void ResetDictionary();
+		void InsertUpTo(int p);
+		int FindMatch(int p, int chain, int& match_dist) const;
+		void Compress(bool flush);
+
+		void EmitBlock(bool final);
+		void EmitStored(bool final);
+
+	public:
+		// level 0 emits stored blocks only, 1 is the fastest and 9 the smallest
+		Deflater(int level, Sink sink, DeflateStrategy strategy = DeflateStrategy::DEFAULT);
+
+		void Write(const uint8_t* data, size_t size);
+
+		// Compress everything pushed so far and byte-align the stream with an empty stored block.
+		// A full flush also resets the dictionary so the following data does not reference earlier bytes.
+		void Flush(bool full = false);
+
+		// Emit the final block, no more data can be written after this call
+		void Finish();
+	};
+}
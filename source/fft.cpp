@@ -0,0 +1,84 @@
+#include "fft.hpp"
+#include <algorithm>
+#include <numbers>
+
+namespace qlm::detail
+{
+	Fft::Fft(int n) : size(n), twiddles(n / 2), reversed(n)
+	{
+		// twiddles in double so large sizes keep float accuracy
+		for (int i = 0; i < n / 2; i++)
+		{
+			const double angle = -2.0 * std::numbers::pi * i / n;
+			twiddles[i] = { static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)) };
+		}
+
+		int bits = 0;
+		while ((1 << bits) < n)
+			bits++;
+
+		for (int i = 0; i < n; i++)
+		{
+			int r = 0;
+			for (int b = 0; b < bits; b++)
+				r |= ((i >> b) & 1) << (bits - 1 - b);
+			reversed[i] = r;
+		}
+	}
+
+	void Fft::Transform(std::complex<float>* data, int lanes, bool inverse) const
+	{
+		for (int i = 0; i < size; i++)
+		{
+			if (i < reversed[i])
+				std::swap_ranges(data + static_cast<size_t>(i) * lanes, data + static_cast<size_t>(i + 1) * lanes,
+								 data + static_cast<size_t>(reversed[i]) * lanes);
+		}
+
+		// butterflies on split real and imaginary parts, std::complex multiplication checks for NaN otherwise
+		float* values = reinterpret_cast<float*>(data);
+		for (int half = 1; half < size; half *= 2)
+		{
+			const int step = size / (2 * half);
+			for (int start = 0; start < size; start += 2 * half)
+			{
+				for (int k = 0; k < half; k++)
+				{
+					const float wr = twiddles[k * step].real();
+					const float wi = inverse ? -twiddles[k * step].imag() : twiddles[k * step].imag();
+
+					float* a = values + static_cast<size_t>(start + k) * lanes * 2;
+					float* b = values + static_cast<size_t>(start + k + half) * lanes * 2;
+					for (int l = 0; l < 2 * lanes; l += 2)
+					{
+						const float br = b[l] * wr - b[l + 1] * wi;
+						const float bi = b[l] * wi + b[l + 1] * wr;
+						const float ar = a[l];
+						const float ai = a[l + 1];
+
+						a[l] = ar + br;
+						a[l + 1] = ai + bi;
+						b[l] = ar - br;
+						b[l + 1] = ai - bi;
+					}
+				}
+			}
+		}
+	}
+
+	void Fft::Forward2D(std::complex<float>* data) const
+	{
+		for (int y = 0; y < size; y++)
+			Transform(data + static_cast<size_t>(y) * size, 1, false);
+
+		Transform(data, size, false);
+	}
+
+	void Fft::Inverse2D(std::complex<float>* data) const
+	{
+		Transform(data, size, true);
+
+		for (int y = 0; y < size; y++)
+			Transform(data + static_cast<size_t>(y) * size, 1, true);
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+namespace qlm::detail
+{
+	// In-place radix-2 complex FFT of a power-of-two size; the inverse is not normalized.
+	// Twiddles and the bit-reversal permutation are computed once per size, so one plan serves all threads.
+	class Fft
+	{
+	private:
+		int size{ 0 };
+		std::vector<std::complex<float>> twiddles;
+		std::vector<int> reversed;
+
+	private:
+		// "lanes" interleaved transforms: element i of lane l is data[i * lanes + l]
+		void Transform(std::complex<float>* data, int lanes, bool inverse) const;
+
+	public:
+		explicit Fft(int n);
+
+		int Size() const
+		{
+			return size;
+		}
+
+		void Forward(std::complex<float>* data) const
+		{
+			Transform(data, 1, false);
+		}
+
+		void Inverse(std::complex<float>* data) const
+		{
+			Transform(data, 1, true);
+		}
+
+		// 2D transforms of a size x size row-major block; the column pass runs on whole rows at a time
+		void Forward2D(std::complex<float>* data) const;
+		void Inverse2D(std::complex<float>* data) const;
+	};
+}
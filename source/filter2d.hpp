@@ -0,0 +1,295 @@
+#pragma once
+
+#include "fft.hpp"
+#include "image.hpp"
+#include "neighborhood.hpp"
+#include "parallel.hpp"
+#include "saturate.hpp"
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace qlm::detail
+{
+	// Direct 2D correlation of all interleaved channels. Every thread takes a band of output rows and keeps a
+	// ring of kernel_height border-extended source rows. KW and KH fix the kernel size at compile time
+	// (0 for run-time sizes): the fixed sizes keep each output sum in a register with all taps unrolled,
+	// the run-time size accumulates one tap at a time over a whole row and skips zero taps.
+	// 8-bit pixels use 16-bit coefficients with 32-bit sums, which vectorize as 16-bit multiplies.
+	template<ImageFormat frmt, pixel_t T, BorderType border_type, typename Coef, typename Acc, int KW, int KH>
+	void Filter2DDirect(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<Coef>& kernel, int kw, int kh,
+						int shift, const Pixel<frmt, T>& border_pixel)
+	{
+		if constexpr (KW > 0)
+		{
+			kw = KW;
+			kh = KH;
+		}
+
+		constexpr int C = PixelChannels<frmt, T>();
+		const int width = in.width;
+		const int height = in.height;
+		const int ax = kw / 2;
+		const int ay = kh / 2;
+		const int ext_width = width + kw - 1;
+
+		Acc round{};
+		if constexpr (std::is_integral_v<Acc>)
+			round = shift > 0 ? Acc(1) << (shift - 1) : Acc(0);
+
+		const auto finalize = [shift, round](Acc v)
+		{
+			if constexpr (std::is_floating_point_v<Acc>)
+				return SaturateCast<T>(v);
+			else
+				return SaturateCast<T>((v + round) >> shift);
+		};
+
+		ParallelFor(0, height, std::max(16, 2 * kh), [&](int y0, int y1)
+		{
+			const int n = width * C;
+			std::vector<Pixel<frmt, T>> ring(static_cast<size_t>(kh) * ext_width);
+			std::vector<const T*> rows(kh);
+			std::vector<Acc> acc(n);
+
+			const int first_row = y0 - ay;
+			const auto slot = [&](int sy) { return ring.data() + static_cast<size_t>((sy - first_row) % kh) * ext_width; };
+
+			for (int sy = first_row; sy < first_row + kh - 1; sy++)
+				LoadExtendedRow<border_type>(in, sy, -ax, ext_width, border_pixel, slot(sy));
+
+			for (int y = y0; y < y1; y++)
+			{
+				LoadExtendedRow<border_type>(in, y - ay + kh - 1, -ax, ext_width, border_pixel, slot(y - ay + kh - 1));
+				for (int j = 0; j < kh; j++)
+					rows[j] = reinterpret_cast<const T*>(slot(y - ay + j));
+
+				T* dst = reinterpret_cast<T*>(out.GetRow(y));
+
+				if constexpr (KW > 0)
+				{
+					Coef c[KH][KW];
+					const T* r[KH];
+					for (int j = 0; j < KH; j++)
+					{
+						r[j] = rows[j];
+						for (int i = 0; i < KW; i++)
+							c[j][i] = kernel[j * KW + i];
+					}
+
+					// one pass per kernel row with the row taps unrolled, the last row also finalizes
+					for (int idx = 0; idx < n; idx++)
+					{
+						Acc sum = 0;
+						for (int i = 0; i < KW; i++)
+							sum += static_cast<Acc>(static_cast<Coef>(r[0][idx + i * C]) * c[0][i]);
+						acc[idx] = sum;
+					}
+
+					for (int j = 1; j < KH - 1; j++)
+					{
+						for (int idx = 0; idx < n; idx++)
+						{
+							Acc sum = acc[idx];
+							for (int i = 0; i < KW; i++)
+								sum += static_cast<Acc>(static_cast<Coef>(r[j][idx + i * C]) * c[j][i]);
+							acc[idx] = sum;
+						}
+					}
+
+					for (int idx = 0; idx < n; idx++)
+					{
+						Acc sum = acc[idx];
+						for (int i = 0; i < KW; i++)
+							sum += static_cast<Acc>(static_cast<Coef>(r[KH - 1][idx + i * C]) * c[KH - 1][i]);
+						dst[idx] = finalize(sum);
+					}
+				}
+				else
+				{
+					std::fill(acc.begin(), acc.end(), Acc(0));
+					for (int j = 0; j < kh; j++)
+					{
+						for (int i = 0; i < kw; i++)
+						{
+							const Coef c = kernel[j * kw + i];
+							if (c == 0)
+								continue;
+
+							const T* s = rows[j] + i * C;
+							for (int idx = 0; idx < n; idx++)
+								acc[idx] += static_cast<Acc>(static_cast<Coef>(s[idx]) * c);
+						}
+					}
+
+					for (int idx = 0; idx < n; idx++)
+						dst[idx] = finalize(acc[idx]);
+				}
+			}
+		});
+	}
+
+	// Power-of-two tile size of the FFT path with the lowest total transform cost for this image and kernel
+	inline int FftTileSize(int width, int height, int kw, int kh)
+	{
+		int best = 0;
+		double best_cost = 0.0;
+
+		for (int size = 16; size <= 1024; size *= 2)
+		{
+			const int tw = size - kw + 1;
+			const int th = size - kh + 1;
+			if (tw <= 0 || th <= 0)
+				continue;
+
+			const double tiles = std::ceil(double(width) / tw) * std::ceil(double(height) / th);
+			const double cost = tiles * size * size * std::log2(double(size));
+			if (best == 0 || cost < best_cost)
+			{
+				best = size;
+				best_cost = cost;
+			}
+		}
+
+		return best;
+	}
+
+	// Automatic selection: the FFT path is used when its estimated cost is lower than the direct one.
+	// One complex tile transform costs about 2.5 * size^2 * log2(size) multiply-adds per direction; the
+	// scattered butterflies run about 4 times slower per operation than the streaming direct loops, which
+	// puts the switch between 9x9 and 15x15 kernels depending on the image size.
+	template<ImageFormat frmt, pixel_t T>
+	bool PreferFft(int width, int height, int kw, int kh)
+	{
+		constexpr int C = PixelChannels<frmt, T>();
+		const int size = FftTileSize(width, height, kw, kh);
+		if (size == 0)
+			return false;
+
+		const int tw = size - kw + 1;
+		const int th = size - kh + 1;
+		const double tiles = std::ceil(double(width) / tw) * std::ceil(double(height) / th);
+		const double fft_cost = 4.0 * tiles * ((C + 1) / 2) * (2 * 2.5 * size * size * std::log2(double(size)) + 4.0 * size * size);
+		const double direct_cost = double(width) * height * C * kw * kh;
+
+		return fft_cost < direct_cost;
+	}
+
+	// 2D correlation through overlap-save FFT tiles. Each tile of size x size source pixels (border included)
+	// gives (size - kw + 1) x (size - kh + 1) output pixels; two real channels share one complex transform,
+	// one in the real part and one in the imaginary part, since the kernel spectrum is the same for both.
+	// Tiles are spread over all threads, the kernel spectrum is computed once.
+	template<ImageFormat frmt, pixel_t T, BorderType border_type>
+	void Filter2DFft(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<float>& kernel, int kw, int kh,
+					 const Pixel<frmt, T>& border_pixel)
+	{
+		constexpr int C = PixelChannels<frmt, T>();
+		const int width = in.width;
+		const int height = in.height;
+		const int ax = kw / 2;
+		const int ay = kh / 2;
+
+		const int size = FftTileSize(width, height, kw, kh);
+		const int tw = size - kw + 1;
+		const int th = size - kh + 1;
+		const int tiles_x = (width + tw - 1) / tw;
+		const int tiles_y = (height + th - 1) / th;
+		const size_t area = static_cast<size_t>(size) * size;
+		const Fft fft(size);
+
+		// out(p) = sum k(i) block(p + i - a) is a circular convolution with k placed at (a - i) mod size,
+		// the inverse transform normalization is folded into the spectrum
+		std::vector<std::complex<float>> spectrum(area);
+		const float norm = 1.0f / static_cast<float>(area);
+		for (int j = 0; j < kh; j++)
+		{
+			const int v = (ay - j + size) % size;
+			for (int i = 0; i < kw; i++)
+			{
+				const int u = (ax - i + size) % size;
+				spectrum[static_cast<size_t>(v) * size + u] = kernel[j * kw + i] * norm;
+			}
+		}
+		fft.Forward2D(spectrum.data());
+
+		ParallelFor(0, tiles_x * tiles_y, 1, [&](int first, int last)
+		{
+			std::vector<Pixel<frmt, T>> block(area);
+			std::vector<std::complex<float>> data(area);
+
+			for (int tile = first; tile < last; tile++)
+			{
+				const int out_x = (tile % tiles_x) * tw;
+				const int out_y = (tile / tiles_x) * th;
+				const int valid_w = std::min(tw, width - out_x);
+				const int valid_h = std::min(th, height - out_y);
+
+				for (int r = 0; r < size; r++)
+					LoadExtendedRow<border_type>(in, out_y - ay + r, out_x - ax, size, border_pixel, block.data() + static_cast<size_t>(r) * size);
+
+				const T* src = reinterpret_cast<const T*>(block.data());
+				for (int c0 = 0; c0 < C; c0 += 2)
+				{
+					const int c1 = c0 + 1;
+					for (size_t k = 0; k < area; k++)
+						data[k] = { static_cast<float>(src[k * C + c0]), c1 < C ? static_cast<float>(src[k * C + c1]) : 0.0f };
+
+					fft.Forward2D(data.data());
+
+					for (size_t k = 0; k < area; k++)
+					{
+						const float re = data[k].real() * spectrum[k].real() - data[k].imag() * spectrum[k].imag();
+						const float im = data[k].real() * spectrum[k].imag() + data[k].imag() * spectrum[k].real();
+						data[k] = { re, im };
+					}
+
+					fft.Inverse2D(data.data());
+
+					for (int r = 0; r < valid_h; r++)
+					{
+						T* dst = reinterpret_cast<T*>(out.GetRow(out_y + r) + out_x);
+						const std::complex<float>* res = data.data() + static_cast<size_t>(r + ay) * size + ax;
+						for (int q = 0; q < valid_w; q++)
+						{
+							dst[q * C + c0] = SaturateCast<T>(res[q].real());
+							if (c1 < C)
+								dst[q * C + c1] = SaturateCast<T>(res[q].imag());
+						}
+					}
+				}
+			}
+		});
+	}
+
+	// Quantize a 2D kernel to 16-bit coefficients for the 32-bit direct path of 8-bit pixels, leaving room for the
+	// rounding residual. Returns the shift, or -1 when fewer than 8 fractional bits fit (the float path is used then).
+	inline int QuantizeKernel2D(const std::vector<float>& kernel, std::vector<int16_t>& quantized)
+	{
+		const double sum = std::accumulate(kernel.begin(), kernel.end(), 0.0, [](double s, float v) { return s + std::abs(v); }) + 1e-9;
+		const double peak = std::accumulate(kernel.begin(), kernel.end(), 0.0, [](double m, float v) { return std::max(m, double(std::abs(v))); }) + 1e-9;
+		const int sum_bits = static_cast<int>(std::floor(std::log2(1073741824.0 / (255.0 * sum))));
+		const int coef_bits = static_cast<int>(std::floor(std::log2(16383.0 / peak)));
+		const int bits = std::min({ 16, sum_bits, coef_bits });
+		if (bits < 8)
+			return -1;
+
+		QuantizeKernel(kernel, bits, quantized);
+
+		return bits;
+	}
+
+	// Direct path with the unrolled 3x3 and 5x5 kernels when the size matches
+	template<ImageFormat frmt, pixel_t T, BorderType border_type, typename Coef, typename Acc>
+	void Filter2DDirectDispatch(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<Coef>& kernel, int kw, int kh,
+								int shift, const Pixel<frmt, T>& border_pixel)
+	{
+		if (kw == 3 && kh == 3)
+			Filter2DDirect<frmt, T, border_type, Coef, Acc, 3, 3>(in, out, kernel, kw, kh, shift, border_pixel);
+		else if (kw == 5 && kh == 5)
+			Filter2DDirect<frmt, T, border_type, Coef, Acc, 5, 5>(in, out, kernel, kw, kh, shift, border_pixel);
+		else
+			Filter2DDirect<frmt, T, border_type, Coef, Acc, 0, 0>(in, out, kernel, kw, kh, shift, border_pixel);
+	}
+}
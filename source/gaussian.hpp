@@ -0,0 +1,266 @@
+#pragma once
+
+#include "image.hpp"
+#include "neighborhood.hpp"
+#include "parallel.hpp"
+#include "saturate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace qlm::detail
+{
+	// Sampled Gaussian of standard deviation sigma over [-radius, radius], normalized to a unit sum
+	inline std::vector<float> GaussianKernel(double sigma, int radius)
+	{
+		std::vector<double> weights(2 * radius + 1);
+		double sum = 0.0;
+		for (int i = -radius; i <= radius; i++)
+		{
+			weights[i + radius] = std::exp(-0.5 * i * i / (sigma * sigma));
+			sum += weights[i + radius];
+		}
+
+		std::vector<float> kernel(weights.size());
+		for (size_t i = 0; i < weights.size(); i++)
+			kernel[i] = static_cast<float>(weights[i] / sum);
+
+		return kernel;
+	}
+
+	// Fourth-order recursive Gaussian of Deriche (1993). The impulse response is fitted with two damped cosines,
+	//   h(n) = (a0 cos(w0 n / s) + a1 sin(w0 n / s)) exp(-b0 n / s) + (c0 cos(w1 n / s) + c1 sin(w1 n / s)) exp(-b1 n / s),
+	// applied as the sum of a causal pass (n >= 0) and an anti-causal pass (n < 0), constant cost for any sigma:
+	//   causal:      y+[n] = n0 x[n] + n1 x[n-1] + n2 x[n-2] + n3 x[n-3] - d1 y+[n-1] - ... - d4 y+[n-4]
+	//   anti-causal: y-[n] = m1 x[n+1] + ... + m4 x[n+4] - d1 y-[n+1] - ... - d4 y-[n+4]
+	// The coefficients are scaled so the discrete filter has a unit gain.
+	struct RecursiveGaussianCoefficients
+	{
+		double n[4]{};
+		double m[4]{};
+		double d[4]{};
+
+		// outputs of both passes for a constant unit input, used to start the recursions in a steady state
+		double causal_gain{ 0.0 };
+		double anticausal_gain{ 0.0 };
+
+		explicit RecursiveGaussianCoefficients(double sigma)
+		{
+			const double a0 = 1.680, a1 = 3.735, b0 = 1.783, w0 = 0.6318;
+			const double c0 = -0.6803, c1 = -0.2598, b1 = 1.723, w1 = 1.997;
+
+			// every damped cosine is a second-order section A + (B sin w - A cos w) p z^-1 over 1 - 2 p cos w z^-1 + p^2 z^-2
+			const auto section = [sigma](double A, double B, double b, double w, double num[2], double den[3])
+			{
+				const double p = std::exp(-b / sigma);
+				const double cs = std::cos(w / sigma);
+				const double sn = std::sin(w / sigma);
+				num[0] = A;
+				num[1] = p * (B * sn - A * cs);
+				den[0] = 1.0;
+				den[1] = -2.0 * p * cs;
+				den[2] = p * p;
+			};
+
+			double num0[2], den0[3], num1[2], den1[3];
+			section(a0, a1, b0, w0, num0, den0);
+			section(c0, c1, b1, w1, num1, den1);
+
+			// N = N0 D1 + N1 D0, D = D0 D1
+			double num[4] = {}, den[5] = {};
+			for (int i = 0; i < 2; i++)
+			{
+				for (int j = 0; j < 3; j++)
+					num[i + j] += num0[i] * den1[j] + num1[i] * den0[j];
+			}
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++)
+					den[i + j] += den0[i] * den1[j];
+			}
+
+			// the anti-causal response h(-n), n < 0, is N(z) - h(0) D(z) over D(z) with z instead of z^-1
+			const double h0 = num[0];
+			const double anti[4] = { num[1] - h0 * den[1], num[2] - h0 * den[2], num[3] - h0 * den[3], -h0 * den[4] };
+
+			const double den_sum = den[0] + den[1] + den[2] + den[3] + den[4];
+			const double causal_sum = (num[0] + num[1] + num[2] + num[3]) / den_sum;
+			const double anti_sum = (anti[0] + anti[1] + anti[2] + anti[3]) / den_sum;
+			const double scale = 1.0 / (causal_sum + anti_sum);
+
+			for (int i = 0; i < 4; i++)
+			{
+				n[i] = num[i] * scale;
+				m[i] = anti[i] * scale;
+				d[i] = den[i + 1];
+			}
+
+			causal_gain = causal_sum * scale;
+			anticausal_gain = anti_sum * scale;
+		}
+	};
+
+	// Recursive Gaussian blur of all interleaved channels. The horizontal pass runs along each row with the
+	// channels of a pixel as parallel lanes, the vertical pass runs down strips of columns with the whole strip
+	// as lanes; both passes run on all threads. Every line is extended by 6 sigma with the border type and the
+	// recursions start in the steady state of the first (last) sample, so the border is reproduced.
+	template<ImageFormat frmt, pixel_t T, BorderType border_type>
+	void RecursiveGaussian(const Image<frmt, T>& in, Image<frmt, T>& out, double sigma_x, double sigma_y, const Pixel<frmt, T>& border_pixel)
+	{
+		constexpr int C = PixelChannels<frmt, T>();
+		const int width = in.width;
+		const int height = in.height;
+		const int mx = static_cast<int>(std::ceil(6.0 * sigma_x));
+		const int my = static_cast<int>(std::ceil(6.0 * sigma_y));
+		const RecursiveGaussianCoefficients cx(sigma_x);
+		const RecursiveGaussianCoefficients cy(sigma_y);
+
+		// horizontally filtered rows
+		std::vector<float> temp(static_cast<size_t>(width) * height * C);
+
+		ParallelFor(0, height, 8, [&](int y0, int y1)
+		{
+			const int ext_width = width + 2 * mx;
+			std::vector<Pixel<frmt, T>> ext(ext_width);
+
+			// samples with 3 leading and 4 trailing copies of the end samples, causal output with 4 leading
+			// steady-state values, anti-causal output with 4 trailing ones
+			std::vector<double> xs(static_cast<size_t>(ext_width + 7) * C);
+			std::vector<double> causal(static_cast<size_t>(ext_width + 4) * C);
+			std::vector<double> anticausal(static_cast<size_t>(ext_width + 4) * C);
+
+			double* X = xs.data() + 3 * C;
+			double* F = causal.data() + 4 * C;
+			double* B = anticausal.data();
+
+			for (int y = y0; y < y1; y++)
+			{
+				LoadExtendedRow<border_type>(in, y, -mx, ext_width, border_pixel, ext.data());
+				const T* s = reinterpret_cast<const T*>(ext.data());
+
+				for (int i = 0; i < ext_width * C; i++)
+					X[i] = static_cast<double>(s[i]);
+
+				for (int c = 0; c < C; c++)
+				{
+					const double first = X[c];
+					const double last = X[(ext_width - 1) * C + c];
+					for (int k = 1; k <= 4; k++)
+					{
+						if (k <= 3)
+							X[-k * C + c] = first;
+						X[(ext_width - 1 + k) * C + c] = last;
+						F[-k * C + c] = first * cx.causal_gain;
+						B[(ext_width - 1 + k) * C + c] = last * cx.anticausal_gain;
+					}
+				}
+
+				for (int i = 0; i < ext_width * C; i++)
+				{
+					F[i] = cx.n[0] * X[i] + cx.n[1] * X[i - C] + cx.n[2] * X[i - 2 * C] + cx.n[3] * X[i - 3 * C]
+						 - cx.d[0] * F[i - C] - cx.d[1] * F[i - 2 * C] - cx.d[2] * F[i - 3 * C] - cx.d[3] * F[i - 4 * C];
+				}
+
+				for (int i = ext_width * C - 1; i >= 0; i--)
+				{
+					B[i] = cx.m[0] * X[i + C] + cx.m[1] * X[i + 2 * C] + cx.m[2] * X[i + 3 * C] + cx.m[3] * X[i + 4 * C]
+						 - cx.d[0] * B[i + C] - cx.d[1] * B[i + 2 * C] - cx.d[2] * B[i + 3 * C] - cx.d[3] * B[i + 4 * C];
+				}
+
+				float* dst = temp.data() + static_cast<size_t>(y) * width * C;
+				for (int i = 0; i < width * C; i++)
+					dst[i] = static_cast<float>(F[i + mx * C] + B[i + mx * C]);
+			}
+		});
+
+		// rows outside the image: constant borders are flat, so the horizontal pass leaves them unchanged
+		const int n = width * C;
+		std::vector<float> border_row(n);
+		for (int i = 0; i < n; i++)
+			border_row[i] = static_cast<float>(reinterpret_cast<const T*>(&border_pixel)[i % C]);
+
+		constexpr int strip = 64;
+		const int strips = (n + strip - 1) / strip;
+		const int ext_height = height + 2 * my;
+
+		// source row of extended row r, rows before the first and after the last repeat the end rows
+		std::vector<const float*> rows(ext_height + 7);
+		for (int r = -3; r < ext_height + 4; r++)
+		{
+			const int sy = BorderIndex<border_type>(std::clamp(r, 0, ext_height - 1) - my, height);
+			rows[r + 3] = sy < 0 ? border_row.data() : temp.data() + static_cast<size_t>(sy) * n;
+		}
+
+		ParallelFor(0, strips, 1, [&](int first, int last)
+		{
+			std::vector<double> causal(static_cast<size_t>(ext_height + 4) * strip);
+			std::vector<double> ring(5 * strip);
+			const float* const* R = rows.data() + 3;
+
+			for (int strip_index = first; strip_index < last; strip_index++)
+			{
+				const int i0 = strip_index * strip;
+				const int count = std::min(strip, n - i0);
+				const auto F = [&](int r) { return causal.data() + static_cast<size_t>(r + 4) * strip; };
+				const auto B = [&](int r) { return ring.data() + static_cast<size_t>(r % 5) * strip; };
+
+				for (int k = 1; k <= 4; k++)
+				{
+					double* f = F(-k);
+					double* b = B(ext_height - 1 + k);
+					for (int i = 0; i < count; i++)
+					{
+						f[i] = R[0][i0 + i] * cy.causal_gain;
+						b[i] = R[ext_height - 1][i0 + i] * cy.anticausal_gain;
+					}
+				}
+
+				for (int r = 0; r < ext_height; r++)
+				{
+					const float* x0 = R[r] + i0;
+					const float* x1 = R[r - 1] + i0;
+					const float* x2 = R[r - 2] + i0;
+					const float* x3 = R[r - 3] + i0;
+					const double* f1 = F(r - 1);
+					const double* f2 = F(r - 2);
+					const double* f3 = F(r - 3);
+					const double* f4 = F(r - 4);
+					double* f = F(r);
+
+					for (int i = 0; i < count; i++)
+					{
+						f[i] = cy.n[0] * x0[i] + cy.n[1] * x1[i] + cy.n[2] * x2[i] + cy.n[3] * x3[i]
+							 - cy.d[0] * f1[i] - cy.d[1] * f2[i] - cy.d[2] * f3[i] - cy.d[3] * f4[i];
+					}
+				}
+
+				for (int r = ext_height - 1; r >= my; r--)
+				{
+					const float* x1 = R[r + 1] + i0;
+					const float* x2 = R[r + 2] + i0;
+					const float* x3 = R[r + 3] + i0;
+					const float* x4 = R[r + 4] + i0;
+					const double* b1 = B(r + 1);
+					const double* b2 = B(r + 2);
+					const double* b3 = B(r + 3);
+					const double* b4 = B(r + 4);
+					double* b = B(r);
+
+					for (int i = 0; i < count; i++)
+					{
+						b[i] = cy.m[0] * x1[i] + cy.m[1] * x2[i] + cy.m[2] * x3[i] + cy.m[3] * x4[i]
+							 - cy.d[0] * b1[i] - cy.d[1] * b2[i] - cy.d[2] * b3[i] - cy.d[3] * b4[i];
+					}
+
+					if (r < my + height)
+					{
+						const double* f = F(r);
+						T* dst = reinterpret_cast<T*>(out.GetRow(r - my)) + i0;
+						for (int i = 0; i < count; i++)
+							dst[i] = SaturateCast<T>(f[i] + b[i]);
+					}
+				}
+			}
+		});
+	}
+}
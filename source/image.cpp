@@ -45,32 +45,17 @@ namespace qlm
 			// Not a border pixel
 			return this->GetPixel(x, y);
 		}
+		else if (border_mode.border_type == BorderType::BORDER_CONSTANT)
+		{
+			return border_mode.border_pixel;
+		}
 		else
 		{
 			// A border pixel
-			switch (border_mode.border_type)
+			return DispatchBorder(border_mode.border_type, [&](auto policy)
 			{
-				case qlm::BorderType::BORDER_CONSTANT:
-				{
-					return border_mode.border_pixel;
-				}
-				case qlm::BorderType::BORDER_REPLICATE:
-				{
-					int x_idx = std::clamp(x, 0, width - 1);
-					int y_idx = std::clamp(y, 0, height - 1);
-					return this->GetPixel(x_idx, y_idx);
-				}
-				case qlm::BorderType::BORDER_REFLECT:
-				{
-					int x_idx = this->ReflectBorderIndex(x, width);
-					int y_idx = this->ReflectBorderIndex(y, height);
-					return this->GetPixel(x_idx, y_idx);
-				}
-				default:
-				{
-					return Pixel<frmt, T>{};
-				}
-			}
+				return this->GetPixel(BorderIndex<policy.value>(x, width), BorderIndex<policy.value>(y, height));
+			});
 		}
 	}
 
@@ -78,11 +63,13 @@ namespace qlm
 	// explicit instantiation
 	template void Image<ImageFormat::GRAY, uint8_t>::create(int, int, Pixel<ImageFormat::GRAY, uint8_t>, int);
 	template void Image<ImageFormat::GRAY, int16_t>::create(int, int, Pixel<ImageFormat::GRAY, int16_t>, int);
+	template void Image<ImageFormat::GRAY, uint16_t>::create(int, int, Pixel<ImageFormat::GRAY, uint16_t>, int);
 	template void Image<ImageFormat::GRAY, int>::create(int, int, Pixel<ImageFormat::GRAY, int>, int);
 	template void Image<ImageFormat::GRAY, float>::create(int, int, Pixel<ImageFormat::GRAY, float>, int);
 
 	template void Image<ImageFormat::RGB, uint8_t>::create(int, int, Pixel<ImageFormat::RGB, uint8_t>, int);
 	template void Image<ImageFormat::RGB, int16_t>::create(int, int, Pixel<ImageFormat::RGB, int16_t>, int);
+	template void Image<ImageFormat::RGB, uint16_t>::create(int, int, Pixel<ImageFormat::RGB, uint16_t>, int);
 	template void Image<ImageFormat::RGB, float>::create(int, int, Pixel<ImageFormat::RGB, float>, int);
 
 	template void Image<ImageFormat::HLS, uint8_t>::create(int, int, Pixel<ImageFormat::HLS, uint8_t>, int);
@@ -95,15 +82,18 @@ namespace qlm
 
 	template void Image<ImageFormat::YCrCb, uint8_t>::create(int, int, Pixel<ImageFormat::YCrCb, uint8_t>, int);
 	template void Image<ImageFormat::YCrCb, int16_t>::create(int, int, Pixel<ImageFormat::YCrCb, int16_t>, int);
+	template void Image<ImageFormat::YCrCb, uint16_t>::create(int, int, Pixel<ImageFormat::YCrCb, uint16_t>, int);
 	template void Image<ImageFormat::YCrCb, float>::create(int, int, Pixel<ImageFormat::YCrCb, float>, int);
 
 	// -------------------------------------------------------------------------------------------------------------
 	template void Image<ImageFormat::GRAY, uint8_t>::create(int, int, int);
 	template void Image<ImageFormat::GRAY, int16_t>::create(int, int, int);
+	template void Image<ImageFormat::GRAY, uint16_t>::create(int, int, int);
 	template void Image<ImageFormat::GRAY, int32_t>::create(int, int, int);
 	template void Image<ImageFormat::GRAY, float>::create(int, int, int);
 	template void Image<ImageFormat::RGB, uint8_t>::create(int, int, int);
 	template void Image<ImageFormat::RGB, int16_t>::create(int, int, int);
+	template void Image<ImageFormat::RGB, uint16_t>::create(int, int, int);
 	template void Image<ImageFormat::RGB, float>::create(int, int, int);
 	template void Image<ImageFormat::HLS, uint8_t>::create(int, int, int);
 	template void Image<ImageFormat::HLS, int16_t>::create(int, int, int);
@@ -113,14 +103,17 @@ namespace qlm
 	template void Image<ImageFormat::HSV, float>::create(int, int, int);
 	template void Image<ImageFormat::YCrCb, uint8_t>::create(int, int, int);
 	template void Image<ImageFormat::YCrCb, int16_t>::create(int, int, int);
+	template void Image<ImageFormat::YCrCb, uint16_t>::create(int, int, int);
 	template void Image<ImageFormat::YCrCb, float>::create(int, int, int);
 	// ------------------------------------------------------------------------------------------------------------
 	template Pixel<ImageFormat::GRAY, uint8_t> Image<ImageFormat::GRAY, uint8_t>::GetPixel(int, int, const BorderMode<ImageFormat::GRAY, uint8_t>&) const;
 	template Pixel<ImageFormat::GRAY, int16_t> Image<ImageFormat::GRAY, int16_t>::GetPixel(int, int, const BorderMode<ImageFormat::GRAY, int16_t>&) const;
+	template Pixel<ImageFormat::GRAY, uint16_t> Image<ImageFormat::GRAY, uint16_t>::GetPixel(int, int, const BorderMode<ImageFormat::GRAY, uint16_t>&) const;
 	template Pixel<ImageFormat::GRAY, int32_t> Image<ImageFormat::GRAY, int32_t>::GetPixel(int, int, const BorderMode<ImageFormat::GRAY, int32_t>&) const;
 	template Pixel<ImageFormat::GRAY, float> Image<ImageFormat::GRAY, float>::GetPixel(int, int, const BorderMode<ImageFormat::GRAY, float>&) const;
 	template Pixel<ImageFormat::RGB, uint8_t> Image<ImageFormat::RGB, uint8_t>::GetPixel(int, int, const BorderMode<ImageFormat::RGB, uint8_t>&) const;
 	template Pixel<ImageFormat::RGB, int16_t> Image<ImageFormat::RGB, int16_t>::GetPixel(int, int, const BorderMode<ImageFormat::RGB, int16_t>&) const;
+	template Pixel<ImageFormat::RGB, uint16_t> Image<ImageFormat::RGB, uint16_t>::GetPixel(int, int, const BorderMode<ImageFormat::RGB, uint16_t>&) const;
 	template Pixel<ImageFormat::RGB, float> Image<ImageFormat::RGB, float>::GetPixel(int, int, const BorderMode<ImageFormat::RGB, float>&) const;
 
 	// -------------------------------------------------------------------------------------------------------------
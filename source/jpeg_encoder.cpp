@@ -0,0 +1,512 @@
+#include "jpeg_encoder.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace qlm::detail
+{
+	// zigzag position -> natural (row-major) index
+	static constexpr uint8_t zigzag[64] = {
+		0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+		12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+		58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+	};
+
+	// ITU T.81 Annex K tables, natural order
+	static constexpr uint8_t luma_quant[64] = {
+		16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+		14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+		18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+		49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99
+	};
+
+	static constexpr uint8_t chroma_quant[64] = {
+		17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+		24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99
+	};
+
+	struct HuffmanSpec
+	{
+		uint8_t bits[16]; // number of codes of length 1 to 16
+		std::vector<uint8_t> values;
+	};
+
+	static const HuffmanSpec luma_dc{ { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 }, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 } };
+	static const HuffmanSpec chroma_dc{ { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 }, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 } };
+
+	static const HuffmanSpec luma_ac{ { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d }, {
+		0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+		0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+		0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+		0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+		0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+		0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+		0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+		0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+		0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+		0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+		0xf9, 0xfa } };
+
+	static const HuffmanSpec chroma_ac{ { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 }, {
+		0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+		0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+		0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+		0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+		0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+		0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+		0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+		0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+		0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+		0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+		0xf9, 0xfa } };
+
+	// canonical code and length of every symbol
+	struct HuffmanTable
+	{
+		uint16_t code[256]{};
+		uint8_t size[256]{};
+
+		explicit HuffmanTable(const HuffmanSpec& spec)
+		{
+			uint16_t next = 0;
+			size_t k = 0;
+
+			for (int len = 1; len <= 16; len++, next <<= 1)
+			{
+				for (int i = 0; i < spec.bits[len - 1]; i++, k++)
+				{
+					code[spec.values[k]] = next++;
+					size[spec.values[k]] = static_cast<uint8_t>(len);
+				}
+			}
+		}
+	};
+
+	// One quantization table and the matching reciprocals, laid out like the output of ForwardDct
+	struct Quantizer
+	{
+		uint8_t table[64]; // natural order
+		float scale[64];   // transposed order, AAN scale factors folded in
+
+		Quantizer(const uint8_t* base, int scaled_quality)
+		{
+			static constexpr float aan[8] = { 1.0f, 1.387039845f, 1.306562965f, 1.175875602f, 1.0f, 0.785694958f, 0.541196100f, 0.275899379f };
+
+			for (int i = 0; i < 64; i++)
+				table[i] = static_cast<uint8_t>(std::clamp((base[i] * scaled_quality + 50) / 100, 1, 255));
+
+			for (int v = 0; v < 8; v++)
+			{
+				for (int u = 0; u < 8; u++)
+					scale[u * 8 + v] = 1.0f / (table[v * 8 + u] * aan[v] * aan[u] * 8.0f);
+			}
+		}
+	};
+
+	// AAN 1-D DCT down the 8 columns of a row-major 8x8 block; every statement works on 8 lanes at once
+	static void DctColumns(float* b)
+	{
+		for (int x = 0; x < 8; x++)
+		{
+			const float tmp0 = b[0 * 8 + x] + b[7 * 8 + x];
+			const float tmp7 = b[0 * 8 + x] - b[7 * 8 + x];
+			const float tmp1 = b[1 * 8 + x] + b[6 * 8 + x];
+			const float tmp6 = b[1 * 8 + x] - b[6 * 8 + x];
+			const float tmp2 = b[2 * 8 + x] + b[5 * 8 + x];
+			const float tmp5 = b[2 * 8 + x] - b[5 * 8 + x];
+			const float tmp3 = b[3 * 8 + x] + b[4 * 8 + x];
+			const float tmp4 = b[3 * 8 + x] - b[4 * 8 + x];
+
+			// even part
+			const float tmp10 = tmp0 + tmp3;
+			const float tmp13 = tmp0 - tmp3;
+			const float tmp11 = tmp1 + tmp2;
+			const float tmp12 = tmp1 - tmp2;
+
+			b[0 * 8 + x] = tmp10 + tmp11;
+			b[4 * 8 + x] = tmp10 - tmp11;
+
+			const float z1 = (tmp12 + tmp13) * 0.707106781f;
+			b[2 * 8 + x] = tmp13 + z1;
+			b[6 * 8 + x] = tmp13 - z1;
+
+			// odd part
+			const float o10 = tmp4 + tmp5;
+			const float o11 = tmp5 + tmp6;
+			const float o12 = tmp6 + tmp7;
+
+			const float z5 = (o10 - o12) * 0.382683433f;
+			const float z2 = 0.541196100f * o10 + z5;
+			const float z4 = 1.306562965f * o12 + z5;
+			const float z3 = o11 * 0.707106781f;
+
+			const float z11 = tmp7 + z3;
+			const float z13 = tmp7 - z3;
+
+			b[5 * 8 + x] = z13 + z2;
+			b[3 * 8 + x] = z13 - z2;
+			b[1 * 8 + x] = z11 + z4;
+			b[7 * 8 + x] = z11 - z4;
+		}
+	}
+
+	// 2-D forward DCT, the result is transposed: coefficient (v, u) ends up at b[u * 8 + v]
+	static void ForwardDct(float* b)
+	{
+		DctColumns(b);
+
+		for (int y = 0; y < 8; y++)
+		{
+			for (int x = y + 1; x < 8; x++)
+				std::swap(b[y * 8 + x], b[x * 8 + y]);
+		}
+
+		DctColumns(b);
+	}
+
+	// Entropy coded segment writer with 0xFF byte stuffing
+	class BitWriter
+	{
+	private:
+		std::vector<uint8_t>& out;
+		uint32_t buffer{ 0 };
+		int count{ 0 };
+
+	public:
+		explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+		void Put(uint32_t bits, int size)
+		{
+			buffer = (buffer << size) | bits;
+			count += size;
+
+			while (count >= 8)
+			{
+				count -= 8;
+				const uint8_t byte = static_cast<uint8_t>(buffer >> count);
+				out.push_back(byte);
+				if (byte == 0xFF)
+					out.push_back(0);
+			}
+		}
+
+		// pad the last byte with ones
+		void Flush()
+		{
+			if (count > 0)
+				Put((1u << (8 - count)) - 1, 8 - count);
+		}
+	};
+
+	static int BitLength(int v)
+	{
+		v = v < 0 ? -v : v;
+		int n = 0;
+		while (v)
+		{
+			n++;
+			v >>= 1;
+		}
+		return n;
+	}
+
+	// Transform, quantize and code one 8x8 block, "dc" is the predictor of the component
+	static void EncodeBlock(BitWriter& writer, float* block, const Quantizer& quant, const HuffmanTable& dc_table, const HuffmanTable& ac_table, int& dc)
+	{
+		ForwardDct(block);
+
+		// the transposed zigzag order matches the transposed DCT output
+		static constexpr auto order = []()
+		{
+			std::array<uint8_t, 64> t{};
+			for (int i = 0; i < 64; i++)
+				t[i] = static_cast<uint8_t>((zigzag[i] % 8) * 8 + zigzag[i] / 8);
+			return t;
+		}();
+
+		int q[64];
+		for (int i = 0; i < 64; i++)
+		{
+			const float v = block[i] * quant.scale[i];
+			q[i] = static_cast<int>(v < 0 ? v - 0.5f : v + 0.5f);
+		}
+
+		const int diff = q[0] - dc;
+		dc = q[0];
+
+		int size = BitLength(diff);
+		writer.Put(dc_table.code[size], dc_table.size[size]);
+		if (size)
+			writer.Put((diff < 0 ? diff - 1 : diff) & ((1 << size) - 1), size);
+
+		int run = 0;
+		for (int i = 1; i < 64; i++)
+		{
+			const int v = q[order[i]];
+			if (v == 0)
+			{
+				run++;
+				continue;
+			}
+
+			for (; run >= 16; run -= 16)
+				writer.Put(ac_table.code[0xF0], ac_table.size[0xF0]);
+
+			size = BitLength(v);
+			const int symbol = (run << 4) | size;
+			writer.Put(ac_table.code[symbol], ac_table.size[symbol]);
+			writer.Put((v < 0 ? v - 1 : v) & ((1 << size) - 1), size);
+			run = 0;
+		}
+
+		if (run > 0)
+			writer.Put(ac_table.code[0x00], ac_table.size[0x00]);
+	}
+
+	static void PutMarker(std::vector<uint8_t>& out, uint8_t marker, size_t length)
+	{
+		out.push_back(0xFF);
+		out.push_back(marker);
+		out.push_back(static_cast<uint8_t>(length >> 8));
+		out.push_back(static_cast<uint8_t>(length));
+	}
+
+	static void PutHuffmanSpec(std::vector<uint8_t>& out, int id, const HuffmanSpec& spec)
+	{
+		out.push_back(static_cast<uint8_t>(id));
+		out.insert(out.end(), spec.bits, spec.bits + 16);
+		out.insert(out.end(), spec.values.begin(), spec.values.end());
+	}
+
+	bool WriteJpeg(std::ostream& stream, const uint8_t* data, int width, int height, int comp, int quality, int h_sampling, int v_sampling)
+	{
+		if (data == nullptr || width <= 0 || height <= 0 || width > 65535 || height > 65535 || comp < 1 || comp > 4)
+			return false;
+
+		quality = quality ? quality : 90;
+		const int auto_sampling = quality <= 90 ? 2 : 1;
+		quality = std::clamp(quality, 1, 100);
+		const int scaled_quality = quality < 50 ? 5000 / quality : 200 - quality * 2;
+
+		const bool color = comp >= 3;
+		const int hs = color ? std::clamp(h_sampling > 0 ? h_sampling : auto_sampling, 1, 2) : 1;
+		const int vs = color ? std::clamp(v_sampling > 0 ? v_sampling : auto_sampling, 1, 2) : 1;
+		const int mcu_width = 8 * hs;
+		const int mcu_height = 8 * vs;
+		const int mcus_x = (width + mcu_width - 1) / mcu_width;
+		const int mcus_y = (height + mcu_height - 1) / mcu_height;
+
+		// restart interval of whole MCU rows, about 256 MCUs so large images split in many strips
+		const int strip_rows = std::clamp((256 + mcus_x - 1) / mcus_x, 1, 65535 / mcus_x);
+		const int num_strips = (mcus_y + strip_rows - 1) / strip_rows;
+
+		const Quantizer luma(luma_quant, scaled_quality);
+		const Quantizer chroma(chroma_quant, scaled_quality);
+		const HuffmanTable luma_dc_table(luma_dc), luma_ac_table(luma_ac);
+		const HuffmanTable chroma_dc_table(chroma_dc), chroma_ac_table(chroma_ac);
+
+		std::vector<std::vector<uint8_t>> strips(num_strips);
+
+		ParallelFor(0, num_strips, 1, [&](int first, int last)
+		{
+			// planar, level shifted samples of one MCU row, padded to whole MCUs by edge replication
+			const int plane_width = mcus_x * mcu_width;
+			std::vector<float> y_plane(plane_width * mcu_height);
+			std::vector<float> cb_plane(color ? plane_width * mcu_height : 0);
+			std::vector<float> cr_plane(color ? plane_width * mcu_height : 0);
+			alignas(32) float block[64];
+
+			const auto load_block = [&](const float* plane, int bx, int by)
+			{
+				for (int y = 0; y < 8; y++)
+				{
+					const float* row = plane + (by + y) * plane_width + bx;
+					std::copy(row, row + 8, block + y * 8);
+				}
+			};
+
+			// subsampled chroma block: the mean of hs x vs samples
+			const auto load_chroma_block = [&](const float* plane, int bx)
+			{
+				// without vertical subsampling "next" is the same row, counted twice
+				const float norm = hs == 2 ? 0.25f : 0.5f;
+				for (int y = 0; y < 8; y++)
+				{
+					const float* row = plane + y * vs * plane_width + bx;
+					const float* next = row + (vs - 1) * plane_width;
+
+					if (hs == 2)
+					{
+						for (int x = 0; x < 8; x++)
+							block[y * 8 + x] = norm * (row[2 * x] + row[2 * x + 1] + next[2 * x] + next[2 * x + 1]);
+					}
+					else
+					{
+						for (int x = 0; x < 8; x++)
+							block[y * 8 + x] = norm * (row[x] + next[x]);
+					}
+				}
+			};
+
+			for (int s = first; s < last; s++)
+			{
+				std::vector<uint8_t>& out = strips[s];
+				out.reserve(static_cast<size_t>(strip_rows) * plane_width * mcu_height * (color ? 3 : 1) / 4);
+				BitWriter writer(out);
+				int dc_y = 0, dc_cb = 0, dc_cr = 0;
+
+				const int mcu_row_end = std::min((s + 1) * strip_rows, mcus_y);
+				for (int my = s * strip_rows; my < mcu_row_end; my++)
+				{
+					for (int y = 0; y < mcu_height; y++)
+					{
+						const int sy = std::min(my * mcu_height + y, height - 1);
+						const uint8_t* src = data + static_cast<size_t>(sy) * width * comp;
+						float* py = &y_plane[y * plane_width];
+
+						if (color)
+						{
+							float* pcb = &cb_plane[y * plane_width];
+							float* pcr = &cr_plane[y * plane_width];
+
+							for (int x = 0; x < width; x++)
+							{
+								const float r = src[x * comp];
+								const float g = src[x * comp + 1];
+								const float b = src[x * comp + 2];
+
+								py[x] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+								pcb[x] = -0.168735892f * r - 0.331264108f * g + 0.5f * b;
+								pcr[x] = 0.5f * r - 0.418687589f * g - 0.081312411f * b;
+							}
+
+							std::fill(pcb + width, pcb + plane_width, pcb[width - 1]);
+							std::fill(pcr + width, pcr + plane_width, pcr[width - 1]);
+						}
+						else
+						{
+							for (int x = 0; x < width; x++)
+								py[x] = src[x * comp] - 128.0f;
+						}
+
+						std::fill(py + width, py + plane_width, py[width - 1]);
+					}
+
+					for (int mx = 0; mx < mcus_x; mx++)
+					{
+						const int x0 = mx * mcu_width;
+
+						for (int by = 0; by < mcu_height; by += 8)
+						{
+							for (int bx = 0; bx < mcu_width; bx += 8)
+							{
+								load_block(y_plane.data(), x0 + bx, by);
+								EncodeBlock(writer, block, luma, luma_dc_table, luma_ac_table, dc_y);
+							}
+						}
+
+						if (color)
+						{
+							if (hs * vs == 1)
+								load_block(cb_plane.data(), x0, 0);
+							else
+								load_chroma_block(cb_plane.data(), x0);
+							EncodeBlock(writer, block, chroma, chroma_dc_table, chroma_ac_table, dc_cb);
+
+							if (hs * vs == 1)
+								load_block(cr_plane.data(), x0, 0);
+							else
+								load_chroma_block(cr_plane.data(), x0);
+							EncodeBlock(writer, block, chroma, chroma_dc_table, chroma_ac_table, dc_cr);
+						}
+					}
+				}
+
+				writer.Flush();
+			}
+		});
+
+		// headers
+		std::vector<uint8_t> header = { 0xFF, 0xD8 };
+
+		static constexpr uint8_t jfif[] = { 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0 };
+		PutMarker(header, 0xE0, 2 + sizeof(jfif));
+		header.insert(header.end(), jfif, jfif + sizeof(jfif));
+
+		const int num_tables = color ? 2 : 1;
+		PutMarker(header, 0xDB, 2 + 65 * num_tables);
+		for (int t = 0; t < num_tables; t++)
+		{
+			const Quantizer& quant = t == 0 ? luma : chroma;
+			header.push_back(static_cast<uint8_t>(t));
+			for (int i = 0; i < 64; i++)
+				header.push_back(quant.table[zigzag[i]]);
+		}
+
+		const int num_components = color ? 3 : 1;
+		PutMarker(header, 0xC0, 8 + 3 * num_components);
+		header.push_back(8);
+		header.push_back(static_cast<uint8_t>(height >> 8));
+		header.push_back(static_cast<uint8_t>(height));
+		header.push_back(static_cast<uint8_t>(width >> 8));
+		header.push_back(static_cast<uint8_t>(width));
+		header.push_back(static_cast<uint8_t>(num_components));
+		for (int c = 0; c < num_components; c++)
+		{
+			header.push_back(static_cast<uint8_t>(c + 1));
+			header.push_back(static_cast<uint8_t>(c == 0 ? (hs << 4) | vs : 0x11));
+			header.push_back(c == 0 ? 0 : 1);
+		}
+
+		size_t dht_length = 2 + 17 * 2 + luma_dc.values.size() + luma_ac.values.size();
+		if (color)
+			dht_length += 17 * 2 + chroma_dc.values.size() + chroma_ac.values.size();
+		PutMarker(header, 0xC4, dht_length);
+		PutHuffmanSpec(header, 0x00, luma_dc);
+		PutHuffmanSpec(header, 0x10, luma_ac);
+		if (color)
+		{
+			PutHuffmanSpec(header, 0x01, chroma_dc);
+			PutHuffmanSpec(header, 0x11, chroma_ac);
+		}
+
+		// DRI: the restart interval is counted in MCUs
+		const int interval = strip_rows * mcus_x;
+		PutMarker(header, 0xDD, 4);
+		header.push_back(static_cast<uint8_t>(interval >> 8));
+		header.push_back(static_cast<uint8_t>(interval));
+
+		PutMarker(header, 0xDA, 6 + 2 * num_components);
+		header.push_back(static_cast<uint8_t>(num_components));
+		for (int c = 0; c < num_components; c++)
+		{
+			header.push_back(static_cast<uint8_t>(c + 1));
+			header.push_back(c == 0 ? 0x00 : 0x11);
+		}
+		header.push_back(0);
+		header.push_back(63);
+		header.push_back(0);
+
+		stream.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+		for (int s = 0; s < num_strips; s++)
+		{
+			stream.write(reinterpret_cast<const char*>(strips[s].data()), strips[s].size());
+
+			if (s + 1 < num_strips)
+			{
+				const char rst[2] = { static_cast<char>(0xFF), static_cast<char>(0xD0 + s % 8) };
+				stream.write(rst, 2);
+			}
+		}
+
+		const char eoi[2] = { static_cast<char>(0xFF), static_cast<char>(0xD9) };
+		stream.write(eoi, 2);
+
+		return static_cast<bool>(stream);
+	}
+}
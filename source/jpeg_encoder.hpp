@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+namespace qlm::detail
+{
+	// Baseline JPEG encoder for 8-bit images with "comp" channels (1 to 4, alpha is dropped).
+	// One or two channels are coded as grayscale, three or four as YCbCr. Quality follows stb_image_write:
+	// 1 to 100 (0 means 90). "h_sampling" and "v_sampling" are the chroma subsampling factors (1 or 2),
+	// 0 subsamples 4:2:0 up to quality 90 and keeps full resolution chroma above, like stb_image_write.
+	// The image is cut into strips of MCU rows that are converted, transformed, quantized and entropy coded
+	// on all threads; a restart marker closes every strip so the coded strips are simply concatenated.
+	bool WriteJpeg(std::ostream& stream, const uint8_t* data, int width, int height, int comp, int quality, int h_sampling = 0, int v_sampling = 0);
+}
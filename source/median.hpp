@@ -0,0 +1,341 @@
+#pragma once
+
+#include "image.hpp"
+#include "neighborhood.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace qlm::detail
+{
+	template<typename T>
+	inline T Median3(T a, T b, T c)
+	{
+		return std::max(std::min(a, b), std::min(std::max(a, b), c));
+	}
+
+	// Paeth's 99 compare-exchanges leaving the median of 25 values in position 12
+	inline constexpr uint8_t median25_network[99][2] = {
+		{ 0, 1 }, { 3, 4 }, { 2, 4 }, { 2, 3 }, { 6, 7 }, { 5, 7 }, { 5, 6 }, { 9, 10 }, { 8, 10 },
+		{ 8, 9 }, { 12, 13 }, { 11, 13 }, { 11, 12 }, { 15, 16 }, { 14, 16 }, { 14, 15 }, { 18, 19 }, { 17, 19 },
+		{ 17, 18 }, { 21, 22 }, { 20, 22 }, { 20, 21 }, { 23, 24 }, { 2, 5 }, { 3, 6 }, { 0, 6 }, { 0, 3 },
+		{ 4, 7 }, { 1, 7 }, { 1, 4 }, { 11, 14 }, { 8, 14 }, { 8, 11 }, { 12, 15 }, { 9, 15 }, { 9, 12 },
+		{ 13, 16 }, { 10, 16 }, { 10, 13 }, { 20, 23 }, { 17, 23 }, { 17, 20 }, { 21, 24 }, { 18, 24 }, { 18, 21 },
+		{ 19, 22 }, { 8, 17 }, { 9, 18 }, { 0, 18 }, { 0, 9 }, { 10, 19 }, { 1, 19 }, { 1, 10 }, { 11, 20 },
+		{ 2, 20 }, { 2, 11 }, { 12, 21 }, { 3, 21 }, { 3, 12 }, { 13, 22 }, { 4, 22 }, { 4, 13 }, { 14, 23 },
+		{ 5, 23 }, { 5, 14 }, { 15, 24 }, { 6, 24 }, { 6, 15 }, { 7, 16 }, { 7, 19 }, { 13, 21 }, { 15, 23 },
+		{ 7, 13 }, { 7, 15 }, { 1, 9 }, { 3, 11 }, { 5, 17 }, { 11, 17 }, { 9, 17 }, { 4, 10 }, { 6, 12 },
+		{ 7, 14 }, { 4, 6 }, { 4, 7 }, { 12, 14 }, { 10, 14 }, { 6, 7 }, { 10, 12 }, { 6, 10 }, { 6, 17 },
+		{ 12, 17 }, { 7, 17 }, { 7, 10 }, { 12, 18 }, { 7, 12 }, { 10, 18 }, { 12, 20 }, { 10, 20 }, { 10, 12 }
+	};
+
+	// 3x3 and 5x5 medians of all interleaved channels with min/max networks that vectorize across the row.
+	// Every thread takes a band of rows and keeps the extended source rows of the window in a ring.
+	// 3x3 sorts every column of three once per row, the median is then the median of the largest column
+	// minimum, the median of the column medians and the smallest column maximum.
+	template<ImageFormat frmt, pixel_t T, BorderType border_type>
+	void MedianNetwork(const Image<frmt, T>& in, Image<frmt, T>& out, int ksize, const Pixel<frmt, T>& border_pixel)
+	{
+		constexpr int C = PixelChannels<frmt, T>();
+		const int width = in.width;
+		const int height = in.height;
+		const int r = ksize / 2;
+		const int ext_width = width + 2 * r;
+
+		ParallelFor(0, height, 32, [&](int y0, int y1)
+		{
+			const int m = ext_width * C;
+			const int n = width * C;
+			const int size = ksize;
+
+			std::vector<Pixel<frmt, T>> ring(static_cast<size_t>(size) * ext_width);
+			std::vector<T> columns(static_cast<size_t>(3) * m);
+			T* lo = columns.data();
+			T* mid = lo + m;
+			T* hi = mid + m;
+			constexpr int block = 256;
+			T p[25][block];
+
+			const int first_row = y0 - r;
+			const auto slot = [&](int sy) { return reinterpret_cast<const T*>(ring.data() + static_cast<size_t>((sy - first_row) % size) * ext_width); };
+			const auto load = [&](int sy)
+			{
+				Pixel<frmt, T>* dst = ring.data() + static_cast<size_t>((sy - first_row) % size) * ext_width;
+				LoadExtendedRow<border_type>(in, sy, -r, ext_width, border_pixel, dst);
+			};
+
+			for (int sy = first_row; sy < first_row + size - 1; sy++)
+				load(sy);
+
+			for (int y = y0; y < y1; y++)
+			{
+				load(y + r);
+				T* dst = reinterpret_cast<T*>(out.GetRow(y));
+
+				if (size == 3)
+				{
+					const T* r0 = slot(y - 1);
+					const T* r1 = slot(y);
+					const T* r2 = slot(y + 1);
+					// one output per loop, three would take too many alias checks to vectorize
+					for (int i = 0; i < m; i++)
+						lo[i] = std::min(std::min(r0[i], r1[i]), r2[i]);
+					for (int i = 0; i < m; i++)
+						mid[i] = Median3(r0[i], r1[i], r2[i]);
+					for (int i = 0; i < m; i++)
+						hi[i] = std::max(std::max(r0[i], r1[i]), r2[i]);
+
+					for (int i = 0; i < n; i++)
+					{
+						const T max_lo = std::max(std::max(lo[i], lo[i + C]), lo[i + 2 * C]);
+						const T min_hi = std::min(std::min(hi[i], hi[i + C]), hi[i + 2 * C]);
+						const T med_mid = Median3(mid[i], mid[i + C], mid[i + 2 * C]);
+						dst[i] = Median3(max_lo, med_mid, min_hi);
+					}
+				}
+				else
+				{
+					// the network runs on planar blocks, each compare-exchange is then one vectorized loop
+					const T* rows[5] = { slot(y - 2), slot(y - 1), slot(y), slot(y + 1), slot(y + 2) };
+					for (int i0 = 0; i0 < n; i0 += block)
+					{
+						const int len = std::min(block, n - i0);
+						for (int ky = 0; ky < 5; ky++)
+						{
+							for (int kx = 0; kx < 5; kx++)
+								std::copy_n(rows[ky] + i0 + kx * C, len, p[ky * 5 + kx]);
+						}
+
+						for (const auto& pair : median25_network)
+						{
+							T* a = p[pair[0]];
+							T* b = p[pair[1]];
+							for (int i = 0; i < len; i++)
+							{
+								const T lo = std::min(a[i], b[i]);
+								b[i] = std::max(a[i], b[i]);
+								a[i] = lo;
+							}
+						}
+
+						std::copy_n(p[12], len, dst + i0);
+					}
+				}
+			}
+		});
+	}
+
+	// Constant-time median of 8-bit images (Perreault and Hebert, 2007). Every column keeps a histogram of
+	// the 2r + 1 values of the window in 16 coarse bins (high nibble) and 16 x 16 fine bins; moving down a row
+	// adds one value to each column and removes one. Along a row the window histogram adds the entering
+	// column and removes the leaving one, coarse bins only: the fine bins of a segment are brought up to date
+	// lazily, when the median falls in that segment. The image is cut into column strips, one per task, so the
+	// column histograms of a strip stay in cache.
+	template<ImageFormat frmt, BorderType border_type>
+	void MedianHistogram8(const Image<frmt, uint8_t>& in, Image<frmt, uint8_t>& out, int ksize, const Pixel<frmt, uint8_t>& border_pixel)
+	{
+		constexpr int C = PixelChannels<frmt, uint8_t>();
+		const int width = in.width;
+		const int height = in.height;
+		const int r = ksize / 2;
+
+		// strips wide enough that the 2r extra columns stay a small overhead, narrow enough to share the work
+		const int strip_width = std::max(32, std::min(std::max(128, 4 * r), (width + ThreadCount() - 1) / ThreadCount()));
+		const int strips = (width + strip_width - 1) / strip_width;
+
+		ParallelFor(0, strips, 1, [&](int s0, int s1)
+		{
+			const int radius = r;
+			const int diameter = 2 * r + 1;
+			const int threshold = diameter * diameter / 2;
+			const int rows = height;
+
+			for (int s = s0; s < s1; s++)
+			{
+				const int x0 = s * strip_width;
+				const int x1 = std::min(x0 + strip_width, width);
+				const int count = x1 - x0;
+				const int cols = count + 2 * radius;
+
+				// coarse: [channel][column][16], fine: [channel][segment][column][16]
+				std::vector<uint16_t> col_coarse(static_cast<size_t>(C) * cols * 16, 0);
+				std::vector<uint16_t> col_fine(static_cast<size_t>(C) * 16 * cols * 16, 0);
+				std::vector<Pixel<frmt, uint8_t>> row(cols);
+				std::vector<uint16_t> kernel(16 + 16 * 16);
+
+				const auto update_columns = [&](int sy, int delta)
+				{
+					LoadExtendedRow<border_type>(in, sy, x0 - radius, cols, border_pixel, row.data());
+					const uint8_t* values = reinterpret_cast<const uint8_t*>(row.data());
+					for (int col = 0; col < cols; col++)
+					{
+						for (int c = 0; c < C; c++)
+						{
+							const int v = values[col * C + c];
+							col_coarse[(static_cast<size_t>(c) * cols + col) * 16 + (v >> 4)] += static_cast<uint16_t>(delta);
+							col_fine[((static_cast<size_t>(c) * 16 + (v >> 4)) * cols + col) * 16 + (v & 15)] += static_cast<uint16_t>(delta);
+						}
+					}
+				};
+
+				for (int sy = -radius; sy < radius; sy++)
+					update_columns(sy, 1);
+
+				for (int y = 0; y < rows; y++)
+				{
+					update_columns(y + radius, 1);
+					if (y > 0)
+						update_columns(y - radius - 1, -1);
+
+					uint8_t* dst = reinterpret_cast<uint8_t*>(out.GetRow(y) + x0);
+
+					for (int c = 0; c < C; c++)
+					{
+						const uint16_t* coarse_columns = col_coarse.data() + static_cast<size_t>(c) * cols * 16;
+						const uint16_t* fine_columns = col_fine.data() + static_cast<size_t>(c) * 16 * cols * 16;
+
+						uint16_t* coarse = kernel.data();
+						uint16_t* fine = coarse + 16;
+						int next_column[16] = {}; // fine segment k holds the columns [next_column[k] - diameter, next_column[k])
+						std::fill_n(coarse, 16, 0);
+
+						for (int col = 0; col < diameter; col++)
+						{
+							for (int b = 0; b < 16; b++)
+								coarse[b] += coarse_columns[col * 16 + b];
+						}
+
+						for (int j = 0; j < count; j++)
+						{
+							int k = 0, sum = 0;
+							while (sum + coarse[k] <= threshold)
+								sum += coarse[k++];
+
+							// fine[k] always covers a full window of columns, rebuilt when it is too old to slide
+							const uint16_t* segment = fine_columns + static_cast<size_t>(k) * cols * 16;
+							uint16_t* window = fine + k * 16;
+							if (next_column[k] <= j)
+							{
+								std::fill_n(window, 16, 0);
+								for (int col = j; col < j + diameter; col++)
+								{
+									for (int b = 0; b < 16; b++)
+										window[b] += segment[col * 16 + b];
+								}
+							}
+							else
+							{
+								for (int col = next_column[k]; col < j + diameter; col++)
+								{
+									for (int b = 0; b < 16; b++)
+										window[b] += segment[col * 16 + b] - segment[(col - diameter) * 16 + b];
+								}
+							}
+							next_column[k] = j + diameter;
+
+							int b = 0;
+							while (sum + window[b] <= threshold)
+								sum += window[b++];
+
+							dst[j * C + c] = static_cast<uint8_t>(16 * k + b);
+
+							if (j + 1 < count)
+							{
+								const uint16_t* entering = coarse_columns + (j + diameter) * 16;
+								const uint16_t* leaving = coarse_columns + j * 16;
+								for (int i = 0; i < 16; i++)
+									coarse[i] += entering[i] - leaving[i];
+							}
+						}
+					}
+				}
+			}
+		});
+	}
+
+	// Median of 16-bit images with a three level histogram of the window (256, 4096 and 65536 bins). The
+	// median of the next pixel is usually in or near the top level bin of the last one: that bin is kept
+	// with the number of values under it and moved bin by bin, two scans of 16 bins then find the median.
+	// Every thread takes a band of rows; along a row the window drops its leaving column and adds the
+	// entering one, 2r + 1 values each.
+	template<ImageFormat frmt, BorderType border_type>
+	void MedianHistogram16(const Image<frmt, uint16_t>& in, Image<frmt, uint16_t>& out, int ksize, const Pixel<frmt, uint16_t>& border_pixel)
+	{
+		constexpr int C = PixelChannels<frmt, uint16_t>();
+		constexpr int levels_size = 256 + 4096 + 65536;
+
+		const int width = in.width;
+		const int height = in.height;
+		const int r = ksize / 2;
+		const int ext_width = width + 2 * r;
+
+		ParallelFor(0, height, 16, [&](int y0, int y1)
+		{
+			const int diameter = 2 * r + 1;
+			const int threshold = diameter * diameter / 2;
+			const int m = ext_width * C;
+
+			std::vector<uint16_t> hist(levels_size, 0);
+			std::vector<Pixel<frmt, uint16_t>> window(static_cast<size_t>(diameter) * ext_width);
+
+			uint16_t* top = hist.data();
+			uint16_t* middle = top + 256;
+			uint16_t* bottom = middle + 4096;
+
+			for (int y = y0; y < y1; y++)
+			{
+				for (int k = 0; k < diameter; k++)
+					LoadExtendedRow<border_type>(in, y - r + k, -r, ext_width, border_pixel, window.data() + static_cast<size_t>(k) * ext_width);
+
+				const uint16_t* rows = reinterpret_cast<const uint16_t*>(window.data());
+				uint16_t* dst = reinterpret_cast<uint16_t*>(out.GetRow(y));
+
+				for (int c = 0; c < C; c++)
+				{
+					// top level bin of the last median and the number of values in the top bins under it
+					int bin = 0, below = 0;
+
+					const auto column = [&](int col, int delta)
+					{
+						for (int k = 0; k < diameter; k++)
+						{
+							const int v = rows[static_cast<size_t>(k) * m + col * C + c];
+							top[v >> 8] += static_cast<uint16_t>(delta);
+							middle[v >> 4] += static_cast<uint16_t>(delta);
+							bottom[v] += static_cast<uint16_t>(delta);
+							below += delta & -static_cast<int>((v >> 8) < bin);
+						}
+					};
+
+					for (int col = 0; col < diameter - 1; col++)
+						column(col, 1);
+
+					for (int x = 0; x < width; x++)
+					{
+						column(x + diameter - 1, 1);
+
+						while (below > threshold)
+							below -= top[--bin];
+						while (below + top[bin] <= threshold)
+							below += top[bin++];
+
+						int sum = below, index = bin * 16;
+						while (sum + middle[index] <= threshold)
+							sum += middle[index++];
+						index *= 16;
+						while (sum + bottom[index] <= threshold)
+							sum += bottom[index++];
+
+						dst[x * C + c] = static_cast<uint16_t>(index);
+						column(x, -1);
+					}
+
+					// the histogram is left empty for the next row
+					for (int col = width; col < width + diameter - 1; col++)
+						column(col, -1);
+				}
+			}
+		});
+	}
+}
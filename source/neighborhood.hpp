@@ -0,0 +1,67 @@
+#pragma once
+
+#include "image.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace qlm::detail
+{
+	// "count" pixels of source row sy starting at column x0; rows and columns outside the image follow the
+	// border type. Only the part outside the image is resolved per pixel, the interior is a straight copy.
+	template<BorderType border_type, ImageFormat frmt, pixel_t T>
+	void LoadExtendedRow(const Image<frmt, T>& in, int sy, int x0, int count, const Pixel<frmt, T>& border_pixel, Pixel<frmt, T>* dst)
+	{
+		const int width = in.width;
+		const int src_y = BorderIndex<border_type>(sy, in.height);
+
+		if (src_y < 0)
+		{
+			std::fill_n(dst, count, border_pixel);
+			return;
+		}
+
+		const Pixel<frmt, T>* src = in.GetRow(src_y);
+		const int interior_begin = std::clamp(-x0, 0, count);
+		const int interior_end = std::clamp(width - x0, interior_begin, count);
+
+		for (int x = 0; x < interior_begin; x++)
+		{
+			const int sx = BorderIndex<border_type>(x0 + x, width);
+			dst[x] = sx < 0 ? border_pixel : src[sx];
+		}
+
+		if (interior_end > interior_begin)
+			std::copy(src + x0 + interior_begin, src + x0 + interior_end, dst + interior_begin);
+
+		for (int x = interior_end; x < count; x++)
+		{
+			const int sx = BorderIndex<border_type>(x0 + x, width);
+			dst[x] = sx < 0 ? border_pixel : src[sx];
+		}
+	}
+
+	// Round a kernel to fixed-point with "bits" fractional bits. The rounding residual goes to the largest
+	// coefficient so the fixed-point kernel keeps the gain of the float one (flat areas stay flat).
+	template<typename I>
+	void QuantizeKernel(const std::vector<float>& kernel, int bits, std::vector<I>& quantized)
+	{
+		const double one = std::ldexp(1.0, bits);
+		double sum = 0.0;
+		long long quantized_sum = 0;
+
+		quantized.resize(kernel.size());
+		for (size_t i = 0; i < kernel.size(); i++)
+		{
+			quantized[i] = static_cast<I>(std::llround(kernel[i] * one));
+			sum += kernel[i];
+			quantized_sum += quantized[i];
+		}
+
+		if (kernel.empty())
+			return;
+
+		const auto largest = std::max_element(kernel.begin(), kernel.end(), [](float a, float b) { return std::abs(a) < std::abs(b); });
+		quantized[largest - kernel.begin()] += static_cast<I>(std::llround(sum * one) - quantized_sum);
+	}
+}
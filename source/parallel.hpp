@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace qlm::detail
+{
+	inline int ThreadCount()
+	{
+		return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	// Split [begin, end) in contiguous chunks of at least "grain" items and run func(first, last) on each chunk.
+	// The calling thread takes the first chunk, the call returns when every chunk is done.
+	// Chunks copy the captured sizes and constants their loops read into locals first: the compiler cannot
+	// prove that stores to the rows (char-typed for 8-bit pixels) leave variables captured by reference
+	// unchanged, so it would reload them on every iteration and give up on vectorizing the loops.
+	template<typename Func>
+	void ParallelFor(int begin, int end, int grain, Func&& func)
+	{
+		const int count = end - begin;
+		if (count <= 0)
+			return;
+
+		grain = std::max(grain, 1);
+		const int threads = std::min(ThreadCount(), (count + grain - 1) / grain);
+
+		if (threads <= 1)
+		{
+			func(begin, end);
+			return;
+		}
+
+		const int chunk = (count + threads - 1) / threads;
+		std::vector<std::jthread> pool;
+		pool.reserve(threads - 1);
+
+		for (int first = begin + chunk; first < end; first += chunk)
+		{
+			const int last = std::min(first + chunk, end);
+			pool.emplace_back([&func, first, last]() { func(first, last); });
+		}
+
+		func(begin, std::min(begin + chunk, end));
+	}
+}
@@ -0,0 +1,264 @@
+#include "png_encoder.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace qlm::detail
+{
+	static void PutU32(uint8_t* out, uint32_t v)
+	{
+		out[0] = static_cast<uint8_t>(v >> 24);
+		out[1] = static_cast<uint8_t>(v >> 16);
+		out[2] = static_cast<uint8_t>(v >> 8);
+		out[3] = static_cast<uint8_t>(v);
+	}
+
+	static uint8_t Paeth(int a, int b, int c)
+	{
+		const int p = a + b - c;
+		const int pa = std::abs(p - a);
+		const int pb = std::abs(p - b);
+		const int pc = std::abs(p - c);
+
+		if (pa <= pb && pa <= pc)
+			return static_cast<uint8_t>(a);
+		if (pb <= pc)
+			return static_cast<uint8_t>(b);
+		return static_cast<uint8_t>(c);
+	}
+
+	// filter types: 0 none, 1 sub, 2 up, 3 average, 4 paeth
+	static void ApplyFilter(int type, const uint8_t* row, const uint8_t* prev, size_t row_bytes, int bpp, uint8_t* out)
+	{
+		const size_t first = std::min(static_cast<size_t>(bpp), row_bytes);
+
+		// one loop per type so the common filters vectorize
+		switch (type)
+		{
+			case 1:
+				std::copy(row, row + first, out);
+				for (size_t i = first; i < row_bytes; i++)
+					out[i] = static_cast<uint8_t>(row[i] - row[i - bpp]);
+				break;
+			case 2:
+				for (size_t i = 0; i < row_bytes; i++)
+					out[i] = static_cast<uint8_t>(row[i] - prev[i]);
+				break;
+			case 3:
+				for (size_t i = 0; i < first; i++)
+					out[i] = static_cast<uint8_t>(row[i] - (prev[i] >> 1));
+				for (size_t i = first; i < row_bytes; i++)
+					out[i] = static_cast<uint8_t>(row[i] - ((row[i - bpp] + prev[i]) >> 1));
+				break;
+			case 4:
+				for (size_t i = 0; i < first; i++)
+					out[i] = static_cast<uint8_t>(row[i] - prev[i]);
+				for (size_t i = first; i < row_bytes; i++)
+					out[i] = static_cast<uint8_t>(row[i] - Paeth(row[i - bpp], prev[i], prev[i - bpp]));
+				break;
+			default:
+				std::copy(row, row + row_bytes, out);
+				break;
+		}
+	}
+
+	void FilterPngRow(const uint8_t* row, const uint8_t* prev, size_t row_bytes, int bpp, uint8_t* out, int filter)
+	{
+		if (filter >= 0)
+		{
+			out[0] = static_cast<uint8_t>(std::min(filter, 4));
+			ApplyFilter(out[0], row, prev, row_bytes, bpp, out + 1);
+			return;
+		}
+
+		thread_local std::vector<uint8_t> candidate;
+		candidate.resize(row_bytes);
+		uint64_t best_cost = UINT64_MAX;
+
+		for (int type = 0; type < 5; type++)
+		{
+			ApplyFilter(type, row, prev, row_bytes, bpp, candidate.data());
+
+			uint64_t cost = 0;
+			for (size_t i = 0; i < row_bytes; i++)
+				cost += std::abs(static_cast<int8_t>(candidate[i]));
+
+			if (cost < best_cost)
+			{
+				best_cost = cost;
+				out[0] = static_cast<uint8_t>(type);
+				std::copy(candidate.begin(), candidate.end(), out + 1);
+			}
+		}
+	}
+
+	void ZlibHeader(int level, uint8_t header[2])
+	{
+		// 32K window, deflate; FLEVEL is informative only
+		const int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+		header[0] = 0x78;
+		header[1] = static_cast<uint8_t>(flevel << 6);
+		header[1] = static_cast<uint8_t>(header[1] + 31 - ((header[0] << 8) | header[1]) % 31);
+	}
+
+	void WritePngChunk(std::ostream& stream, const char type[4], const uint8_t* data, size_t size)
+	{
+		uint8_t buf[4];
+
+		PutU32(buf, static_cast<uint32_t>(size));
+		stream.write(reinterpret_cast<const char*>(buf), 4);
+		stream.write(type, 4);
+		if (size > 0)
+			stream.write(reinterpret_cast<const char*>(data), size);
+
+		uint32_t crc = Crc32(0, reinterpret_cast<const uint8_t*>(type), 4);
+		crc = Crc32(crc, data, size);
+		PutU32(buf, crc);
+		stream.write(reinterpret_cast<const char*>(buf), 4);
+	}
+
+	void WritePngHeader(std::ostream& stream, int width, int height, int comp)
+	{
+		static constexpr uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		static constexpr uint8_t color_type[5] = { 0, 0, 4, 2, 6 };
+
+		stream.write(reinterpret_cast<const char*>(signature), 8);
+
+		uint8_t ihdr[13];
+		PutU32(ihdr, static_cast<uint32_t>(width));
+		PutU32(ihdr + 4, static_cast<uint32_t>(height));
+		ihdr[8] = 8;                 // bit depth
+		ihdr[9] = color_type[comp];  // color type
+		ihdr[10] = 0;                // compression
+		ihdr[11] = 0;                // filter
+		ihdr[12] = 0;                // interlace
+		WritePngChunk(stream, "IHDR", ihdr, sizeof(ihdr));
+	}
+
+	PngEncoder::PngEncoder(std::ostream& stream, int width, int height, int comp, int level, int filter)
+		: stream(stream), row_bytes(static_cast<size_t>(width) * comp), comp(comp), filter(filter),
+		  prev_row(row_bytes, 0), filtered(row_bytes + 1),
+		  deflater(level, [this](const uint8_t* data, size_t size) { Append(data, size); })
+	{
+		WritePngHeader(stream, width, height, comp);
+
+		uint8_t header[2];
+		ZlibHeader(level, header);
+		Append(header, 2);
+	}
+
+	void PngEncoder::Append(const uint8_t* data, size_t size)
+	{
+		idat.insert(idat.end(), data, data + size);
+
+		if (idat.size() >= idat_size)
+		{
+			WritePngChunk(stream, "IDAT", idat.data(), idat.size());
+			idat.clear();
+		}
+	}
+
+	void PngEncoder::WriteRow(const uint8_t* row)
+	{
+		FilterPngRow(row, prev_row.data(), row_bytes, comp, filtered.data(), filter);
+		std::copy(row, row + row_bytes, prev_row.begin());
+
+		adler = Adler32(adler, filtered.data(), filtered.size());
+		deflater.Write(filtered.data(), filtered.size());
+	}
+
+	bool PngEncoder::Finish()
+	{
+		deflater.Finish();
+
+		uint8_t trailer[4];
+		PutU32(trailer, adler);
+		idat.insert(idat.end(), trailer, trailer + 4);
+
+		WritePngChunk(stream, "IDAT", idat.data(), idat.size());
+		idat.clear();
+		WritePngChunk(stream, "IEND", nullptr, 0);
+
+		return static_cast<bool>(stream);
+	}
+
+	bool WritePng(std::ostream& stream, const uint8_t* data, int width, int height, int comp, int level, int filter, DeflateStrategy strategy)
+	{
+		const size_t row_bytes = static_cast<size_t>(width) * comp;
+
+		// blocks of about 256K input bytes, small enough to give every thread work and large enough
+		// for the dictionary reset at each block boundary to cost little
+		constexpr size_t block_bytes = 1 << 18;
+		const int block_rows = static_cast<int>(std::max<size_t>(1, block_bytes / (row_bytes + 1)));
+		const int num_blocks = (height + block_rows - 1) / block_rows;
+
+		struct Block
+		{
+			std::vector<uint8_t> compressed;
+			uint32_t adler{ 1 };
+			uint32_t crc{ 0 };
+			size_t size{ 0 }; // uncompressed bytes
+		};
+		std::vector<Block> blocks(num_blocks);
+
+		ParallelFor(0, num_blocks, 1, [&](int first, int last)
+		{
+			std::vector<uint8_t> filtered(row_bytes + 1);
+			const std::vector<uint8_t> zeros(row_bytes, 0);
+
+			for (int b = first; b < last; b++)
+			{
+				Block& block = blocks[b];
+				Deflater deflater(level, [&block](const uint8_t* d, size_t n) { block.compressed.insert(block.compressed.end(), d, d + n); }, strategy);
+
+				const int y0 = b * block_rows;
+				const int y1 = std::min(y0 + block_rows, height);
+				for (int y = y0; y < y1; y++)
+				{
+					const uint8_t* row = data + y * row_bytes;
+					const uint8_t* prev = y > 0 ? row - row_bytes : zeros.data();
+
+					FilterPngRow(row, prev, row_bytes, comp, filtered.data(), filter);
+					block.adler = Adler32(block.adler, filtered.data(), filtered.size());
+					block.size += filtered.size();
+					deflater.Write(filtered.data(), filtered.size());
+				}
+
+				if (b == num_blocks - 1)
+					deflater.Finish();
+				else
+					deflater.Flush();
+
+				block.crc = Crc32(Crc32(0, reinterpret_cast<const uint8_t*>("IDAT"), 4), block.compressed.data(), block.compressed.size());
+			}
+		});
+
+		WritePngHeader(stream, width, height, comp);
+
+		uint8_t header[2];
+		ZlibHeader(level, header);
+		WritePngChunk(stream, "IDAT", header, 2);
+
+		uint32_t adler = 1;
+		for (const Block& block : blocks)
+		{
+			// the CRC was computed by the worker
+			uint8_t buf[4];
+			PutU32(buf, static_cast<uint32_t>(block.compressed.size()));
+			stream.write(reinterpret_cast<const char*>(buf), 4);
+			stream.write("IDAT", 4);
+			stream.write(reinterpret_cast<const char*>(block.compressed.data()), block.compressed.size());
+			PutU32(buf, block.crc);
+			stream.write(reinterpret_cast<const char*>(buf), 4);
+
+			adler = Adler32Combine(adler, block.adler, block.size);
+		}
+
+		uint8_t trailer[4];
+		PutU32(trailer, adler);
+		WritePngChunk(stream, "IDAT", trailer, 4);
+		WritePngChunk(stream, "IEND", nullptr, 0);
+
+		return static_cast<bool>(stream);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "deflate.hpp"
+#include <ostream>
+
+namespace qlm::detail
+{
+	// Filter one row for PNG (filter type byte followed by the filtered bytes). A negative "filter" picks the
+	// filter with the smallest sum of absolute signed residuals, 0 to 4 forces a filter type.
+	// "prev" is the previous unfiltered row or zeros.
+	void FilterPngRow(const uint8_t* row, const uint8_t* prev, size_t row_bytes, int bpp, uint8_t* out, int filter = -1);
+
+	// zlib stream header (RFC 1950) for a given deflate level
+	void ZlibHeader(int level, uint8_t header[2]);
+
+	// Write a complete PNG chunk: length, type, data and CRC
+	void WritePngChunk(std::ostream& stream, const char type[4], const uint8_t* data, size_t size);
+
+	// Write the PNG signature and the IHDR chunk for 8-bit images with "comp" channels (1 to 4)
+	void WritePngHeader(std::ostream& stream, int width, int height, int comp);
+
+	// Row-by-row PNG encoder, only the previous row and the pending IDAT data are kept in memory
+	class PngEncoder
+	{
+	private:
+		static constexpr size_t idat_size = 1 << 16;
+
+		std::ostream& stream;
+		size_t row_bytes;
+		int comp;
+		int filter;
+
+		std::vector<uint8_t> prev_row;
+		std::vector<uint8_t> filtered;
+		std::vector<uint8_t> idat;
+		uint32_t adler{ 1 };
+		Deflater deflater;
+
+	private:
+		void Append(const uint8_t* data, size_t size);
+
+	public:
+		PngEncoder(std::ostream& stream, int width, int height, int comp, int level = 6, int filter = -1);
+
+		void WriteRow(const uint8_t* row);
+
+		bool Finish();
+	};
+
+	// Encode a whole 8-bit image. Blocks of rows are filtered and deflated independently on all threads,
+	// every block but the last ends with a sync flush so the concatenation is one valid zlib stream.
+	bool WritePng(std::ostream& stream, const uint8_t* data, int width, int height, int comp, int level = 6, int filter = -1,
+				  DeflateStrategy strategy = DeflateStrategy::DEFAULT);
+}
@@ -0,0 +1,347 @@
+#pragma once
+
+#include "geometry.hpp"
+#include "neighborhood.hpp"
+#include "parallel.hpp"
+#include "saturate.hpp"
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+namespace qlm::detail
+{
+	// Resampling coefficients of one axis: output position i reads "taps" source positions from start[i]
+	// with weights[i * taps + k]. All the windows have the same length, shorter ones are padded with zeros,
+	// and they stay inside the source so no border handling is needed.
+	template<typename W>
+	struct ResampleTable
+	{
+		int taps{ 0 };
+		std::vector<int> start;
+		std::vector<W> weights;
+	};
+
+	inline double ResampleSupport(Interpolation interpolation)
+	{
+		switch (interpolation)
+		{
+			case Interpolation::BICUBIC:
+				return 2.0;
+			case Interpolation::LANCZOS3:
+				return 3.0;
+			default:
+				return 1.0;
+		}
+	}
+
+	inline double ResampleFilter(Interpolation interpolation, double x)
+	{
+		x = std::abs(x);
+		switch (interpolation)
+		{
+			case Interpolation::BICUBIC:
+			{
+				constexpr double a = -0.5;
+				if (x < 1.0)
+					return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+				if (x < 2.0)
+					return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+				return 0.0;
+			}
+			case Interpolation::LANCZOS3:
+			{
+				if (x >= 3.0)
+					return 0.0;
+				if (x < 1e-8)
+					return 1.0;
+				const double px = std::numbers::pi * x;
+				return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+			}
+			default:
+				return x < 1.0 ? 1.0 - x : 0.0;
+		}
+	}
+
+	// Normalized weights of every output position in double, before they are converted to the table type
+	inline void ResampleWeights(int in_size, int out_size, Interpolation interpolation, std::vector<int>& start, std::vector<int>& count,
+								std::vector<std::vector<double>>& weights)
+	{
+		const double scale = static_cast<double>(in_size) / out_size;
+		start.resize(out_size);
+		count.resize(out_size);
+		weights.assign(out_size, {});
+
+		for (int i = 0; i < out_size; i++)
+		{
+			std::vector<double>& w = weights[i];
+
+			if (interpolation == Interpolation::AREA)
+			{
+				// overlap of the output footprint [i, i + 1) * scale with every source pixel
+				const double a = i * scale;
+				const double b = (i + 1) * scale;
+				const int first = std::min(static_cast<int>(std::floor(a)), in_size - 1);
+				const int last = std::min(static_cast<int>(std::ceil(b)), in_size);
+
+				start[i] = first;
+				for (int k = first; k < last; k++)
+					w.push_back(std::max(0.0, std::min(b, k + 1.0) - std::max(a, double(k))));
+			}
+			else
+			{
+				// the filter is stretched by the scale factor when shrinking
+				const double filter_scale = std::max(scale, 1.0);
+				const double support = ResampleSupport(interpolation) * filter_scale;
+				const double center = (i + 0.5) * scale;
+				const int first = std::clamp(static_cast<int>(std::floor(center - support + 0.5)), 0, in_size - 1);
+				const int last = std::clamp(static_cast<int>(std::floor(center + support + 0.5)), first + 1, in_size);
+
+				start[i] = first;
+				for (int k = first; k < last; k++)
+					w.push_back(ResampleFilter(interpolation, (k + 0.5 - center) / filter_scale));
+			}
+
+			double sum = 0.0;
+			for (double v : w)
+				sum += v;
+
+			// a window that lost all its weight (e.g. a degenerate footprint) falls back to its first pixel
+			if (std::abs(sum) < 1e-12)
+			{
+				std::fill(w.begin(), w.end(), 0.0);
+				w[0] = sum = 1.0;
+			}
+
+			for (double& v : w)
+				v /= sum;
+
+			count[i] = static_cast<int>(w.size());
+		}
+	}
+
+	// Table with float weights, or fixed-point weights with "bits" fractional bits when W is an integer type
+	template<typename W>
+	ResampleTable<W> BuildResampleTable(int in_size, int out_size, Interpolation interpolation, int bits = 0)
+	{
+		std::vector<int> start, count;
+		std::vector<std::vector<double>> weights;
+		ResampleWeights(in_size, out_size, interpolation, start, count, weights);
+
+		ResampleTable<W> table;
+		table.taps = std::min(*std::max_element(count.begin(), count.end()), in_size);
+		table.start.resize(out_size);
+		table.weights.assign(static_cast<size_t>(out_size) * table.taps, W(0));
+
+		for (int i = 0; i < out_size; i++)
+		{
+			// windows near the end are moved left so all taps stay inside, their weights move right
+			const int first = std::min(start[i], in_size - table.taps);
+			const int offset = start[i] - first;
+			table.start[i] = first;
+
+			W* w = table.weights.data() + static_cast<size_t>(i) * table.taps + offset;
+			if constexpr (std::is_integral_v<W>)
+			{
+				std::vector<float> row(weights[i].begin(), weights[i].end());
+				std::vector<W> quantized;
+				QuantizeKernel(row, bits, quantized);
+				std::copy(quantized.begin(), quantized.end(), w);
+			}
+			else
+			{
+				for (int k = 0; k < count[i]; k++)
+					w[k] = static_cast<W>(weights[i][k]);
+			}
+		}
+
+		return table;
+	}
+
+	// Arithmetic of the two passes. Floating-point: float weights, float intermediate rows.
+	// 8-bit: 14-bit weights, the horizontal pass keeps 6 fractional bits in 16-bit intermediate rows
+	// (room for the overshoot of bicubic and Lanczos), the vertical pass sums in 32 bits.
+	template<pixel_t T>
+	struct ResampleArith
+	{
+		using weight_t = float;
+		using mid_t = float;
+		using acc_t = float;
+		static constexpr int weight_bits = 0;
+		static constexpr int mid_bits = 0;
+	};
+
+	template<>
+	struct ResampleArith<uint8_t>
+	{
+		using weight_t = int16_t;
+		using mid_t = int16_t;
+		using acc_t = int32_t;
+		static constexpr int weight_bits = 14;
+		static constexpr int mid_bits = 6;
+	};
+
+	// Horizontal pass of one source row. The common window lengths are compile-time constants so the
+	// tap loop unrolls; "Taps" 0 reads the length from the table.
+	template<int C, int Taps, typename Arith, pixel_t T>
+	void ResampleRow(const T* src, typename Arith::mid_t* dst, const ResampleTable<typename Arith::weight_t>& table, int out_width)
+	{
+		using weight_t = typename Arith::weight_t;
+		using mid_t = typename Arith::mid_t;
+		using acc_t = typename Arith::acc_t;
+
+		const int taps = Taps > 0 ? Taps : table.taps;
+		const int* start = table.start.data();
+		const weight_t* weights = table.weights.data();
+
+		for (int x = 0; x < out_width; x++)
+		{
+			const T* s = src + start[x] * C;
+			const weight_t* w = weights + static_cast<size_t>(x) * taps;
+
+			acc_t sum[C] = {};
+			for (int k = 0; k < taps; k++)
+			{
+				for (int c = 0; c < C; c++)
+					sum[c] += static_cast<acc_t>(static_cast<weight_t>(s[k * C + c]) * w[k]);
+			}
+
+			for (int c = 0; c < C; c++)
+			{
+				if constexpr (std::is_integral_v<mid_t>)
+				{
+					constexpr int shift = Arith::weight_bits - Arith::mid_bits;
+					dst[x * C + c] = SaturateCast<mid_t>((sum[c] + (acc_t(1) << (shift - 1))) >> shift);
+				}
+				else
+				{
+					dst[x * C + c] = sum[c];
+				}
+			}
+		}
+	}
+
+	// Two-pass separable resampling. Every thread takes a band of output rows and keeps a ring of the
+	// horizontally resampled source rows its vertical windows need; each source row is resampled once per band.
+	template<ImageFormat frmt, pixel_t T>
+	void ResampleSeparable(const Image<frmt, T>& in, Image<frmt, T>& out, Interpolation interpolation)
+	{
+		using arith = ResampleArith<T>;
+		using weight_t = typename arith::weight_t;
+		using mid_t = typename arith::mid_t;
+		using acc_t = typename arith::acc_t;
+
+		constexpr int C = PixelChannels<frmt, T>();
+		const ResampleTable<weight_t> tx = BuildResampleTable<weight_t>(in.width, out.width, interpolation, arith::weight_bits);
+		const ResampleTable<weight_t> ty = BuildResampleTable<weight_t>(in.height, out.height, interpolation, arith::weight_bits);
+
+		ParallelFor(0, out.height, std::max(16, ty.taps), [&](int y0, int y1)
+		{
+			const int out_n = out.width * C;
+			const int ring_size = ty.taps;
+			std::vector<mid_t> ring(static_cast<size_t>(ring_size) * out_n);
+			std::vector<int> ring_row(ring_size, -1);
+			std::vector<const mid_t*> rows(ty.taps);
+			std::vector<acc_t> acc(out_n);
+
+			const auto horizontal = [&](int sy, mid_t* dst)
+			{
+				const T* src = reinterpret_cast<const T*>(in.GetRow(sy));
+				switch (tx.taps)
+				{
+					case 2:
+						ResampleRow<C, 2, arith>(src, dst, tx, out.width);
+						break;
+					case 4:
+						ResampleRow<C, 4, arith>(src, dst, tx, out.width);
+						break;
+					case 6:
+						ResampleRow<C, 6, arith>(src, dst, tx, out.width);
+						break;
+					case 8:
+						ResampleRow<C, 8, arith>(src, dst, tx, out.width);
+						break;
+					default:
+						ResampleRow<C, 0, arith>(src, dst, tx, out.width);
+						break;
+				}
+			};
+
+			for (int y = y0; y < y1; y++)
+			{
+				const int first = ty.start[y];
+				for (int k = 0; k < ty.taps; k++)
+				{
+					const int sy = first + k;
+					const int slot = sy % ring_size;
+					if (ring_row[slot] != sy)
+					{
+						horizontal(sy, ring.data() + static_cast<size_t>(slot) * out_n);
+						ring_row[slot] = sy;
+					}
+					rows[k] = ring.data() + static_cast<size_t>(slot) * out_n;
+				}
+
+				const weight_t* w = ty.weights.data() + static_cast<size_t>(y) * ty.taps;
+				std::fill(acc.begin(), acc.end(), acc_t(0));
+				for (int k = 0; k < ty.taps; k++)
+				{
+					// 16-bit products for 8-bit images, SSE2 has no 32-bit multiply
+					const weight_t c = w[k];
+					if (c == 0)
+						continue;
+
+					const mid_t* row = rows[k];
+					for (int i = 0; i < out_n; i++)
+						acc[i] += static_cast<acc_t>(row[i] * c);
+				}
+
+				T* dst = reinterpret_cast<T*>(out.GetRow(y));
+				if constexpr (std::is_integral_v<acc_t>)
+				{
+					constexpr int shift = arith::weight_bits + arith::mid_bits;
+					for (int i = 0; i < out_n; i++)
+						dst[i] = SaturateCast<T>((acc[i] + (acc_t(1) << (shift - 1))) >> shift);
+				}
+				else
+				{
+					for (int i = 0; i < out_n; i++)
+						dst[i] = SaturateCast<T>(acc[i]);
+				}
+			}
+		});
+	}
+
+	// Nearest neighbor through per-column and per-row source index tables
+	template<ImageFormat frmt, pixel_t T>
+	void ResampleNearest(const Image<frmt, T>& in, Image<frmt, T>& out)
+	{
+		const auto index_table = [](int in_size, int out_size)
+		{
+			std::vector<int> index(out_size);
+			const double scale = static_cast<double>(in_size) / out_size;
+			for (int i = 0; i < out_size; i++)
+				index[i] = std::min(static_cast<int>((i + 0.5) * scale), in_size - 1);
+			return index;
+		};
+
+		const std::vector<int> sx = index_table(in.width, out.width);
+		const std::vector<int> sy = index_table(in.height, out.height);
+
+		ParallelFor(0, out.height, 64, [&](int y0, int y1)
+		{
+			for (int y = y0; y < y1; y++)
+			{
+				const Pixel<frmt, T>* src = in.GetRow(sy[y]);
+				Pixel<frmt, T>* dst = out.GetRow(y);
+				if (y > y0 && sy[y] == sy[y - 1])
+				{
+					std::copy_n(out.GetRow(y - 1), out.width, dst);
+					continue;
+				}
+
+				for (int x = 0; x < out.width; x++)
+					dst[x] = src[sx[x]];
+			}
+		});
+	}
+}
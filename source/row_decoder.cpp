@@ -0,0 +1,412 @@
+#include "row_decoder.hpp"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+namespace qlm::detail
+{
+	static uint16_t Get16(const uint8_t* p)
+	{
+		return static_cast<uint16_t>(p[0] | (p[1] << 8));
+	}
+
+	static uint32_t Get32(const uint8_t* p)
+	{
+		return static_cast<uint32_t>(Get16(p)) | (static_cast<uint32_t>(Get16(p + 2)) << 16);
+	}
+
+	// next header token, skipping whitespace and '#' comments
+	static std::string NextToken(std::istream& stream)
+	{
+		std::string token;
+		int c = stream.get();
+
+		while (c != EOF)
+		{
+			if (c == '#')
+			{
+				while (c != EOF && c != '\n')
+					c = stream.get();
+			}
+			else if (std::isspace(c))
+			{
+				if (!token.empty())
+					break;
+			}
+			else
+			{
+				token.push_back(static_cast<char>(c));
+			}
+			c = stream.get();
+		}
+
+		return token;
+	}
+
+	// non-negative decimal number, -1 for anything else (signs, trailing characters, values beyond int)
+	static int ToInt(const std::string& token)
+	{
+		int value = -1;
+		const char* end = token.data() + token.size();
+		const auto [ptr, ec] = std::from_chars(token.data(), end, value);
+		return ec == std::errc() && ptr == end && value >= 0 ? value : -1;
+	}
+
+	// -------------------------------------------------------------------------------------------------------------
+	// headers
+	// -------------------------------------------------------------------------------------------------------------
+	bool RowDecoder::ParsePNM()
+	{
+		const std::string magic = NextToken(stream);
+
+		if (magic == "P5" || magic == "P6")
+		{
+			// the single whitespace after the max value is consumed by NextToken
+			width = ToInt(NextToken(stream));
+			height = ToInt(NextToken(stream));
+			max_value = ToInt(NextToken(stream));
+			comp = magic == "P5" ? 1 : 3;
+		}
+		else if (magic == "P7")
+		{
+			std::string tuple_type;
+			for (std::string key = NextToken(stream); key != "ENDHDR"; key = NextToken(stream))
+			{
+				if (key.empty())
+					return false;
+				else if (key == "WIDTH")
+					width = ToInt(NextToken(stream));
+				else if (key == "HEIGHT")
+					height = ToInt(NextToken(stream));
+				else if (key == "DEPTH")
+					comp = ToInt(NextToken(stream));
+				else if (key == "MAXVAL")
+					max_value = ToInt(NextToken(stream));
+				else if (key == "TUPLTYPE")
+					tuple_type = NextToken(stream);
+			}
+		}
+		else
+		{
+			return false;
+		}
+
+		if (comp < 1 || comp > 4 || max_value < 1 || max_value > 65535)
+			return false;
+
+		sample_type = max_value < 256 ? SampleType::U8 : SampleType::U16;
+		row_bytes = static_cast<size_t>(width) * comp * SampleSize();
+		file_bpp = static_cast<int>(comp * SampleSize() * 8);
+		data_offset = stream.tellg();
+		top_down = true;
+		layout = Layout::PNM;
+
+		return true;
+	}
+
+	bool RowDecoder::ParseBMP()
+	{
+		uint8_t header[54];
+		if (!stream.read(reinterpret_cast<char*>(header), sizeof(header)))
+			return false;
+
+		const uint32_t info_size = Get32(header + 14);
+		const int32_t h = static_cast<int32_t>(Get32(header + 22));
+		uint32_t compression = Get32(header + 30);
+
+		data_offset = Get32(header + 10);
+		width = static_cast<int32_t>(Get32(header + 18));
+		height = std::abs(h);
+		top_down = h < 0;
+		file_bpp = Get16(header + 28);
+
+		// BI_BITFIELDS is accepted for 32 bits when the masks describe plain BGRA/BGRX
+		uint32_t alpha_mask = 0xFF000000;
+		if (compression == 3 && file_bpp == 32)
+		{
+			uint8_t masks[16];
+			if (!stream.read(reinterpret_cast<char*>(masks), sizeof(masks)))
+				return false;
+
+			if (Get32(masks) != 0x00FF0000 || Get32(masks + 4) != 0x0000FF00 || Get32(masks + 8) != 0x000000FF)
+				compression = ~0u;
+			alpha_mask = info_size >= 56 ? Get32(masks + 12) : 0;
+			if (alpha_mask != 0 && alpha_mask != 0xFF000000)
+				compression = ~0u;
+		}
+		else if (compression != 0)
+		{
+			compression = ~0u;
+		}
+
+		if (info_size < 40 || compression == ~0u || (file_bpp != 8 && file_bpp != 24 && file_bpp != 32))
+		{
+			if (!probe)
+				std::cerr << "Error: only uncompressed 8, 24 and 32 bits BMP can be streamed." << std::endl;
+			return false;
+		}
+
+		if (file_bpp == 8)
+		{
+			uint32_t colors = Get32(header + 46);
+			colors = colors == 0 ? 256 : std::min<uint32_t>(colors, 256);
+
+			palette.assign(256 * 4, 0);
+			stream.seekg(14 + info_size);
+			if (!stream.read(reinterpret_cast<char*>(palette.data()), colors * 4))
+				return false;
+
+			bool gray = true;
+			for (uint32_t i = 0; i < colors; i++)
+				gray = gray && palette[i * 4] == palette[i * 4 + 1] && palette[i * 4] == palette[i * 4 + 2];
+
+			comp = gray ? 1 : 3;
+		}
+		else
+		{
+			comp = (file_bpp == 32 && alpha_mask != 0) ? 4 : 3;
+		}
+
+		sample_type = SampleType::U8;
+		row_bytes = ((static_cast<size_t>(width) * file_bpp + 31) / 32) * 4;
+		layout = Layout::BMP;
+
+		// BI_RGB leaves the fourth byte undefined: like stb_image it is read as alpha unless it is 0 everywhere,
+		// which would otherwise make the image fully transparent. A probe only needs the header.
+		if (comp == 4 && compression == 0 && !probe)
+		{
+			std::vector<uint8_t> row(row_bytes);
+			bool has_alpha = false;
+
+			stream.seekg(data_offset);
+			for (int y = 0; y < height && !has_alpha && stream.read(reinterpret_cast<char*>(row.data()), row.size()); y++)
+			{
+				for (int x = 0; x < width; x++)
+					has_alpha = has_alpha || row[x * 4 + 3] != 0;
+			}
+
+			if (!has_alpha)
+				comp = 3;
+		}
+
+		return true;
+	}
+
+	bool RowDecoder::ParseTGA()
+	{
+		uint8_t header[18];
+		if (!stream.read(reinterpret_cast<char*>(header), sizeof(header)))
+			return false;
+
+		const int id_length = header[0];
+		const int colormap_type = header[1];
+		const int image_type = header[2];
+		const int colormap_length = Get16(header + 5);
+		const int colormap_bits = header[7];
+
+		width = Get16(header + 12);
+		height = Get16(header + 14);
+		file_bpp = header[16];
+		top_down = (header[17] & 0x20) != 0;
+
+		// 2: uncompressed true-color, 3: uncompressed gray
+		const bool valid = (image_type == 2 && (file_bpp == 24 || file_bpp == 32)) ||
+						   (image_type == 3 && (file_bpp == 8 || file_bpp == 16));
+		if (!valid)
+		{
+			if (!probe)
+				std::cerr << "Error: only uncompressed true-color and gray TGA can be streamed." << std::endl;
+			return false;
+		}
+
+		comp = file_bpp / 8;
+		sample_type = SampleType::U8;
+		row_bytes = static_cast<size_t>(width) * comp;
+		data_offset = 18 + id_length + (colormap_type ? colormap_length * ((colormap_bits + 7) / 8) : 0);
+		layout = Layout::TGA;
+
+		return true;
+	}
+
+	bool RowDecoder::ParsePFM()
+	{
+		const std::string magic = NextToken(stream);
+		width = ToInt(NextToken(stream));
+		height = ToInt(NextToken(stream));
+
+		// the single whitespace before the raster is consumed by NextToken
+		const std::string scale_token = NextToken(stream);
+		float scale = 0.0f;
+		const auto [ptr, ec] = std::from_chars(scale_token.data(), scale_token.data() + scale_token.size(), scale);
+
+		if (!stream || (magic != "PF" && magic != "Pf") || ec != std::errc() || ptr != scale_token.data() + scale_token.size())
+			return false;
+
+		comp = magic == "PF" ? 3 : 1;
+		sample_type = SampleType::F32;
+		row_bytes = static_cast<size_t>(width) * comp * sizeof(float);
+		file_bpp = comp * 32;
+		data_offset = stream.tellg();
+		top_down = false;
+		swap_bytes = (scale < 0.0f) != (std::endian::native == std::endian::little);
+		layout = Layout::PFM;
+
+		return true;
+	}
+
+	bool RowDecoder::IsStreamable(const std::string& file_name)
+	{
+		return Open(file_name, true) != nullptr;
+	}
+
+	std::unique_ptr<RowDecoder> RowDecoder::Open(const std::string& file_name, bool probe)
+	{
+		auto decoder = std::make_unique<RowDecoder>();
+		decoder->probe = probe;
+		decoder->stream.open(file_name, std::ios::binary);
+
+		if (!decoder->stream.is_open())
+		{
+			if (!probe)
+				std::cerr << "Error: could not open '" << file_name << "'." << std::endl;
+			return nullptr;
+		}
+
+		char magic[2]{};
+		decoder->stream.read(magic, 2);
+		decoder->stream.seekg(0);
+
+		std::string ext = file_name.substr(file_name.find_last_of('.') + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+
+		bool status{ false };
+		if (magic[0] == 'P' && (magic[1] == '5' || magic[1] == '6' || magic[1] == '7'))
+			status = decoder->ParsePNM();
+		else if (magic[0] == 'P' && (magic[1] == 'F' || magic[1] == 'f'))
+			status = decoder->ParsePFM();
+		else if (magic[0] == 'B' && magic[1] == 'M')
+			status = decoder->ParseBMP();
+		else if (ext == "tga")
+			status = decoder->ParseTGA();
+		else if (!probe)
+			std::cerr << "Error: '" << file_name << "' is not a format that can be streamed." << std::endl;
+
+		if (!status || decoder->width <= 0 || decoder->height <= 0 || decoder->width > max_dimension || decoder->height > max_dimension)
+		{
+			if (!probe)
+				std::cerr << "Error: invalid header in '" << file_name << "'." << std::endl;
+			return nullptr;
+		}
+
+		return decoder;
+	}
+
+	// -------------------------------------------------------------------------------------------------------------
+	// raster
+	// -------------------------------------------------------------------------------------------------------------
+	void RowDecoder::UnpackRow(const uint8_t* src, uint8_t* dst) const
+	{
+		const size_t count = static_cast<size_t>(width) * comp;
+
+		switch (layout)
+		{
+			case Layout::PNM:
+			{
+				if (sample_type == SampleType::U8)
+				{
+					if (max_value == 255)
+						std::memcpy(dst, src, count);
+					else
+						for (size_t i = 0; i < count; i++)
+							dst[i] = static_cast<uint8_t>(std::min(src[i] * 255 / max_value, 255));
+				}
+				else
+				{
+					uint16_t* out = reinterpret_cast<uint16_t*>(dst);
+					for (size_t i = 0; i < count; i++)
+					{
+						const uint32_t v = (src[2 * i] << 8) | src[2 * i + 1];
+						out[i] = static_cast<uint16_t>(max_value == 65535 ? v : std::min<uint32_t>(v * 65535 / max_value, 65535));
+					}
+				}
+				break;
+			}
+			case Layout::PFM:
+			{
+				std::memcpy(dst, src, count * sizeof(float));
+				if (swap_bytes)
+				{
+					for (size_t i = 0; i < count; i++)
+						std::reverse(dst + 4 * i, dst + 4 * i + 4);
+				}
+				break;
+			}
+			case Layout::BMP:
+			case Layout::TGA:
+			{
+				if (file_bpp == 8 && layout == Layout::BMP)
+				{
+					for (int x = 0; x < width; x++)
+					{
+						const uint8_t* entry = &palette[src[x] * 4];
+						if (comp == 1)
+						{
+							dst[x] = entry[0];
+						}
+						else
+						{
+							dst[3 * x] = entry[2];
+							dst[3 * x + 1] = entry[1];
+							dst[3 * x + 2] = entry[0];
+						}
+					}
+				}
+				else if (comp <= 2)
+				{
+					std::memcpy(dst, src, count);
+				}
+				else
+				{
+					// BGR(A) -> RGB(A), 32 bits BMP without alpha skip the unused byte
+					const int src_step = file_bpp / 8;
+					for (int x = 0; x < width; x++, src += src_step, dst += comp)
+					{
+						dst[0] = src[2];
+						dst[1] = src[1];
+						dst[2] = src[0];
+						if (comp == 4)
+							dst[3] = src[3];
+					}
+				}
+				break;
+			}
+		}
+	}
+
+	bool RowDecoder::ReadRows(int y0, int count, uint8_t* samples)
+	{
+		if (y0 < 0 || count <= 0 || y0 + count > height)
+			return false;
+
+		// bottom-up files store the requested band reversed but still contiguous
+		const int first_file_row = top_down ? y0 : height - y0 - count;
+
+		file_rows.resize(row_bytes * count);
+		stream.clear();
+		stream.seekg(data_offset + static_cast<std::streamoff>(first_file_row) * row_bytes);
+		if (!stream.read(reinterpret_cast<char*>(file_rows.data()), file_rows.size()))
+			return false;
+
+		const size_t out_row = static_cast<size_t>(width) * comp * SampleSize();
+		for (int i = 0; i < count; i++)
+		{
+			const int file_row = top_down ? i : count - 1 - i;
+			UnpackRow(&file_rows[file_row * row_bytes], samples + i * out_row);
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace qlm::detail
+{
+	enum class SampleType
+	{
+		U8,
+		U16,
+		F32,
+	};
+
+	// Decoder for formats whose raster is stored row by row without compression:
+	// binary PNM (P5, P6, P7), uncompressed BMP (8-bit palette, 24-bit, 32-bit), uncompressed TGA and PFM.
+	// Rows are returned top-down as interleaved samples; comp is 1 gray, 2 gray + alpha, 3 RGB, 4 RGB + alpha.
+	class RowDecoder
+	{
+	public:
+		// largest width or height accepted, the bound stb_image uses (STBI_MAX_DIMENSIONS)
+		static constexpr int max_dimension = 1 << 24;
+
+	public:
+		int width{ 0 };
+		int height{ 0 };
+		int comp{ 0 };
+		SampleType sample_type{ SampleType::U8 };
+
+	private:
+		enum class Layout
+		{
+			PNM,
+			BMP,
+			TGA,
+			PFM,
+		};
+
+		std::ifstream stream;
+		Layout layout{ Layout::PNM };
+		std::streamoff data_offset{ 0 };
+		size_t row_bytes{ 0 }; // bytes of one row in the file, including padding
+		int file_bpp{ 0 };     // bits per pixel in the file
+		int max_value{ 255 };  // PNM maximum sample value
+		bool top_down{ true };
+		bool swap_bytes{ false };
+		bool probe{ false };   // header checks only, nothing is reported
+		std::vector<uint8_t> palette; // BGRA entries
+		std::vector<uint8_t> file_rows;
+
+	private:
+		bool ParsePNM();
+		bool ParseBMP();
+		bool ParseTGA();
+		bool ParsePFM();
+		void UnpackRow(const uint8_t* src, uint8_t* dst) const;
+
+	public:
+		// Parse the header, returns nullptr if the file is missing or not supported. A probe reports no errors
+		// and skips the raster scans some headers need, it only tells whether the file could be opened.
+		static std::unique_ptr<RowDecoder> Open(const std::string& file_name, bool probe = false);
+
+		// Check that the header describes a layout the decoder supports, without reporting errors
+		static bool IsStreamable(const std::string& file_name);
+
+		size_t SampleSize() const
+		{
+			return sample_type == SampleType::U8 ? 1 : sample_type == SampleType::U16 ? 2 : 4;
+		}
+
+		// Decode rows [y0, y0 + count) into "samples" (count * width * comp samples)
+		bool ReadRows(int y0, int count, uint8_t* samples);
+	};
+}
@@ -0,0 +1,251 @@
+#include "row_encoder.hpp"
+#include "png_encoder.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace qlm::detail
+{
+	// -------------------------------------------------------------------------------------------------------------
+	// PNM: P5 (gray), P6 (RGB) and P7 (PAM, keeps alpha)
+	// -------------------------------------------------------------------------------------------------------------
+	class PnmEncoder : public RowEncoder
+	{
+	private:
+		std::ofstream stream;
+		int width;
+		int comp;
+		int out_comp;
+		std::vector<uint8_t> buffer;
+
+	public:
+		PnmEncoder(const std::string& file_name, int width, int height, int comp, int out_comp, bool pam)
+			: stream(file_name, std::ios::binary), width(width), comp(comp), out_comp(out_comp), buffer(static_cast<size_t>(width) * out_comp)
+		{
+			if (pam)
+			{
+				static constexpr const char* tuple_type[5] = { "", "GRAYSCALE", "GRAYSCALE_ALPHA", "RGB", "RGB_ALPHA" };
+				stream << "P7\nWIDTH " << width << "\nHEIGHT " << height << "\nDEPTH " << out_comp
+					   << "\nMAXVAL 255\nTUPLTYPE " << tuple_type[out_comp] << "\nENDHDR\n";
+			}
+			else
+			{
+				stream << (out_comp == 1 ? "P5" : "P6") << "\n" << width << " " << height << "\n255\n";
+			}
+		}
+
+		bool IsOpen() const
+		{
+			return stream.is_open();
+		}
+
+		bool WriteRow(const uint8_t* row) override
+		{
+			const bool in_gray = comp <= 2;
+			const bool in_alpha = comp == 2 || comp == 4;
+			const int color = out_comp <= 2 ? 1 : 3;
+			const bool out_alpha = out_comp == 2 || out_comp == 4;
+
+			for (int x = 0; x < width; x++)
+			{
+				const uint8_t* src = row + x * comp;
+				uint8_t* dst = &buffer[x * out_comp];
+
+				for (int c = 0; c < color; c++)
+					dst[c] = in_gray ? src[0] : src[c];
+
+				if (out_alpha)
+					dst[color] = in_alpha ? src[comp - 1] : 255;
+			}
+
+			stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+			return static_cast<bool>(stream);
+		}
+
+		bool Finish() override
+		{
+			stream.close();
+			return !stream.fail();
+		}
+	};
+
+	// -------------------------------------------------------------------------------------------------------------
+	// BMP: top-down (negative height) so rows can be written in order, 24-bit BGR or 32-bit BGRA
+	// -------------------------------------------------------------------------------------------------------------
+	class BmpEncoder : public RowEncoder
+	{
+	private:
+		std::ofstream stream;
+		int width;
+		int comp;
+		int out_comp;
+		std::vector<uint8_t> buffer;
+
+		static void Put16(uint8_t* p, uint16_t v)
+		{
+			p[0] = static_cast<uint8_t>(v);
+			p[1] = static_cast<uint8_t>(v >> 8);
+		}
+
+		static void Put32(uint8_t* p, uint32_t v)
+		{
+			Put16(p, static_cast<uint16_t>(v));
+			Put16(p + 2, static_cast<uint16_t>(v >> 16));
+		}
+
+		// rows are padded to 4 bytes
+		static uint64_t RowSize(int width, int out_comp)
+		{
+			return (static_cast<uint64_t>(width) * out_comp + 3) & ~uint64_t(3);
+		}
+
+	public:
+		// size of the whole file, CreateRowEncoder checks that it fits the 32 bits of the header
+		static uint64_t FileSize(int width, int height, int comp)
+		{
+			return 54 + RowSize(width, (comp == 2 || comp == 4) ? 4 : 3) * static_cast<uint64_t>(height);
+		}
+
+		BmpEncoder(const std::string& file_name, int width, int height, int comp)
+			: stream(file_name, std::ios::binary), width(width), comp(comp), out_comp((comp == 2 || comp == 4) ? 4 : 3)
+		{
+			const uint64_t row_size = RowSize(width, out_comp);
+			const uint32_t file_size = static_cast<uint32_t>(FileSize(width, height, comp));
+			const uint32_t image_size = static_cast<uint32_t>(row_size * height);
+			buffer.assign(row_size, 0);
+
+			uint8_t header[54]{};
+			header[0] = 'B';
+			header[1] = 'M';
+			Put32(header + 2, file_size);                        // file size
+			Put32(header + 10, 54);                              // pixel data offset
+			Put32(header + 14, 40);                              // BITMAPINFOHEADER
+			Put32(header + 18, static_cast<uint32_t>(width));
+			Put32(header + 22, static_cast<uint32_t>(-height));  // top-down
+			Put16(header + 26, 1);                               // planes
+			Put16(header + 28, static_cast<uint16_t>(out_comp * 8));
+			Put32(header + 34, image_size);                      // image size
+
+			stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+		}
+
+		bool IsOpen() const
+		{
+			return stream.is_open();
+		}
+
+		bool WriteRow(const uint8_t* row) override
+		{
+			const bool in_gray = comp <= 2;
+
+			for (int x = 0; x < width; x++)
+			{
+				const uint8_t* src = row + x * comp;
+				uint8_t* dst = &buffer[x * out_comp];
+
+				dst[0] = in_gray ? src[0] : src[2];
+				dst[1] = in_gray ? src[0] : src[1];
+				dst[2] = src[0];
+				if (out_comp == 4)
+					dst[3] = src[comp - 1];
+			}
+
+			stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+			return static_cast<bool>(stream);
+		}
+
+		bool Finish() override
+		{
+			stream.close();
+			return !stream.fail();
+		}
+	};
+
+	// -------------------------------------------------------------------------------------------------------------
+	// PNG
+	// -------------------------------------------------------------------------------------------------------------
+	class PngRowEncoder : public RowEncoder
+	{
+	private:
+		std::ofstream stream;
+		PngEncoder encoder;
+
+	public:
+		PngRowEncoder(const std::string& file_name, int width, int height, int comp, int level)
+			: stream(file_name, std::ios::binary), encoder(stream, width, height, comp, level)
+		{
+		}
+
+		bool IsOpen() const
+		{
+			return stream.is_open();
+		}
+
+		bool WriteRow(const uint8_t* row) override
+		{
+			encoder.WriteRow(row);
+			return static_cast<bool>(stream);
+		}
+
+		bool Finish() override
+		{
+			const bool status = encoder.Finish();
+			stream.close();
+			return status && !stream.fail();
+		}
+	};
+
+	std::unique_ptr<RowEncoder> CreateRowEncoder(const std::string& file_name, int width, int height, int comp, int png_level)
+	{
+		std::string ext = file_name.substr(file_name.find_last_of('.') + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+
+		const bool gray = comp <= 2;
+		const bool alpha = comp == 2 || comp == 4;
+
+		const auto open = [&](auto encoder) -> std::unique_ptr<RowEncoder>
+		{
+			if (!encoder->IsOpen())
+			{
+				std::cerr << "Error: could not open '" << file_name << "' for writing." << std::endl;
+				return nullptr;
+			}
+			return encoder;
+		};
+
+		if (ext == "pgm" || ext == "ppm" || ext == "pnm")
+		{
+			// plain PNM has no alpha
+			const int out_comp = (ext == "pgm" || (ext == "pnm" && gray)) ? 1 : 3;
+			if (ext == "pgm" && !gray)
+			{
+				std::cerr << "Error: PGM output requires a gray image." << std::endl;
+				return nullptr;
+			}
+			return open(std::make_unique<PnmEncoder>(file_name, width, height, comp, out_comp, false));
+		}
+		else if (ext == "pam")
+		{
+			const int out_comp = (gray ? 1 : 3) + (alpha ? 1 : 0);
+			return open(std::make_unique<PnmEncoder>(file_name, width, height, comp, out_comp, true));
+		}
+		else if (ext == "bmp")
+		{
+			if (BmpEncoder::FileSize(width, height, comp) > UINT32_MAX)
+			{
+				std::cerr << "Error: '" << file_name << "' would be larger than the 4 GB a BMP file can describe." << std::endl;
+				return nullptr;
+			}
+			return open(std::make_unique<BmpEncoder>(file_name, width, height, comp));
+		}
+		else if (ext == "png")
+		{
+			return open(std::make_unique<PngRowEncoder>(file_name, width, height, comp, png_level));
+		}
+
+		std::cerr << "Error: Unsupported streaming file extension '" << ext << "'." << std::endl;
+		return nullptr;
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace qlm::detail
+{
+	// Encoder fed one row at a time with 8-bit interleaved samples.
+	// comp: 1 gray, 2 gray + alpha, 3 RGB, 4 RGB + alpha
+	class RowEncoder
+	{
+	public:
+		virtual ~RowEncoder() = default;
+
+		virtual bool WriteRow(const uint8_t* row) = 0;
+
+		virtual bool Finish() = 0;
+	};
+
+	// Pick the encoder from the file extension: pgm/ppm/pnm/pam, bmp or png. Returns nullptr on failure.
+	std::unique_ptr<RowEncoder> CreateRowEncoder(const std::string& file_name, int width, int height, int comp, int png_level = 6);
+}
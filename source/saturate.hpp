@@ -0,0 +1,41 @@
+#pragma once
+
+#include "pixel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace qlm::detail
+{
+	// Round and clamp a value to the range of T, floating-point types are only converted
+	template<pixel_t T, typename V>
+	inline T SaturateCast(V v)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			return static_cast<T>(v);
+		}
+		else if constexpr (std::is_floating_point_v<V>)
+		{
+			constexpr V lo = static_cast<V>(std::numeric_limits<T>::lowest());
+			constexpr V hi = static_cast<V>(std::numeric_limits<T>::max());
+
+			// round half away from zero, then clamp; this order with max/min keeps the loops that call it vectorizable
+			if constexpr (std::is_unsigned_v<T>)
+				v += V(0.5);
+			else
+				v += std::copysign(V(0.5), v);
+
+			v = std::max(v, lo);
+			v = std::min(v, hi);
+			return static_cast<T>(v);
+		}
+		else
+		{
+			constexpr V lo = static_cast<V>(std::numeric_limits<T>::lowest());
+			constexpr V hi = static_cast<V>(std::numeric_limits<T>::max());
+			return static_cast<T>(std::clamp(v, lo, hi));
+		}
+	}
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "image.hpp"
+#include "neighborhood.hpp"
+#include "parallel.hpp"
+#include "saturate.hpp"
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace qlm::detail
+{
+	// Arithmetic of a separable pass: coefficient, intermediate (row pass) and accumulator (column pass) types
+	template<typename Coef, typename Mid, typename Acc>
+	struct SeparableArith
+	{
+		using coef_t = Coef;
+		using mid_t = Mid;
+		using acc_t = Acc;
+	};
+
+	using FloatArith = SeparableArith<float, float, float>;
+
+	// Fixed-point arithmetic for 8 and 16-bit pixels, the column accumulator of 16-bit pixels is 64-bit
+	template<pixel_t T>
+	using FixedArith = SeparableArith<int32_t, int32_t, std::conditional_t<(sizeof(T) == 1), int32_t, int64_t>>;
+
+	// Separable 2D convolution of all interleaved channels (alpha included, like Pixel::MAC).
+	// Every thread takes a band of output rows; the row pass writes into a rolling cache of kernel_y.size()
+	// intermediate rows, so each source row is filtered horizontally once per band. The inner loops run
+	// across all the scalars of a row and vectorize.
+	template<ImageFormat frmt, pixel_t T, BorderType border_type, typename Arith>
+	void SeparableConvolve(const Image<frmt, T>& in, Image<frmt, T>& out,
+						   const std::vector<typename Arith::coef_t>& kx, const std::vector<typename Arith::coef_t>& ky,
+						   int shift, const Pixel<frmt, T>& border_pixel)
+	{
+		using coef_t = typename Arith::coef_t;
+		using mid_t = typename Arith::mid_t;
+		using acc_t = typename Arith::acc_t;
+
+		constexpr int C = PixelChannels<frmt, T>();
+		const int width = in.width;
+		const int height = in.height;
+		const int kw = static_cast<int>(kx.size());
+		const int kh = static_cast<int>(ky.size());
+		const int ax = kw / 2;
+		const int ay = kh / 2;
+
+		ParallelFor(0, height, std::max(32, 4 * kh), [&](int y0, int y1)
+		{
+			const int n = width * C;
+			std::vector<Pixel<frmt, T>> ext(width + kw - 1);
+			std::vector<mid_t> cache(static_cast<size_t>(kh) * n);
+			std::vector<acc_t> acc(n);
+
+			// virtual source row sy (possibly outside the image) filtered horizontally into its cache slot
+			const int first_row = y0 - ay;
+			const auto slot = [&](int sy) { return cache.data() + static_cast<size_t>((sy - first_row) % kh) * n; };
+
+			const auto filter_row = [&](int sy)
+			{
+				LoadExtendedRow<border_type>(in, sy, -ax, width + kw - 1, border_pixel, ext.data());
+
+				const T* s = reinterpret_cast<const T*>(ext.data());
+				mid_t* dst = slot(sy);
+				std::fill_n(dst, n, mid_t(0));
+
+				for (int k = 0; k < kw; k++)
+				{
+					const coef_t c = kx[k];
+					const T* sk = s + k * C;
+					for (int i = 0; i < n; i++)
+						dst[i] += static_cast<mid_t>(sk[i]) * c;
+				}
+			};
+
+			for (int sy = first_row; sy < first_row + kh - 1; sy++)
+				filter_row(sy);
+
+			for (int y = y0; y < y1; y++)
+			{
+				filter_row(y - ay + kh - 1);
+
+				std::fill(acc.begin(), acc.end(), acc_t(0));
+				for (int k = 0; k < kh; k++)
+				{
+					const mid_t* row = slot(y - ay + k);
+					const acc_t c = static_cast<acc_t>(ky[k]);
+					for (int i = 0; i < n; i++)
+						acc[i] += static_cast<acc_t>(row[i]) * c;
+				}
+
+				T* dst = reinterpret_cast<T*>(out.GetRow(y));
+				if constexpr (std::is_floating_point_v<acc_t>)
+				{
+					for (int i = 0; i < n; i++)
+						dst[i] = SaturateCast<T>(acc[i]);
+				}
+				else
+				{
+					const acc_t round = shift > 0 ? acc_t(1) << (shift - 1) : acc_t(0);
+					for (int i = 0; i < n; i++)
+						dst[i] = SaturateCast<T>((acc[i] + round) >> shift);
+				}
+			}
+		});
+	}
+
+	// Quantize both kernels for fixed-point arithmetic. Returns the total shift, or -1 when the kernels
+	// cannot keep at least 6 fractional bits per pass without overflow (the float path is used then).
+	template<pixel_t T>
+	int QuantizeKernels(const std::vector<float>& kx, const std::vector<float>& ky, std::vector<int32_t>& qx, std::vector<int32_t>& qy)
+	{
+		const auto abs_sum = [](const std::vector<float>& k)
+		{
+			return std::accumulate(k.begin(), k.end(), 0.0, [](double s, float v) { return s + std::abs(v); }) + 1e-9;
+		};
+
+		const double sx = abs_sum(kx);
+		const double sy = abs_sum(ky);
+		const double max_value = std::max(std::abs(double(std::numeric_limits<T>::lowest())), double(std::numeric_limits<T>::max()));
+
+		// row pass in 32 bits; the column pass also in 32 bits for 8-bit pixels, in 64 bits otherwise
+		constexpr double limit = 1073741824.0; // 2^30, leaves room for rounding and quantization error
+		int bx = 14, by = 14;
+
+		if constexpr (sizeof(T) == 1)
+		{
+			int total = static_cast<int>(std::floor(std::log2(limit / (max_value * sx * sy))));
+			total = std::min(total, 28);
+			bx = total / 2;
+			by = total - bx;
+		}
+		else
+		{
+			bx = std::min(14, static_cast<int>(std::floor(std::log2(limit / (max_value * sx)))));
+			// the intermediate rows stay below 2^30, the 64-bit column accumulator affords more coefficient bits
+			by = std::min(20, static_cast<int>(std::floor(std::log2(limit * 4.0 / sy))));
+		}
+
+		if (bx < 6 || by < 6)
+			return -1;
+
+		QuantizeKernel(kx, bx, qx);
+		QuantizeKernel(ky, by, qy);
+
+		return bx + by;
+	}
+
+	// Separable convolution with the border type resolved once; integer pixels use fixed-point when possible
+	template<ImageFormat frmt, pixel_t T>
+	void SeparableFilter(const Image<frmt, T>& in, Image<frmt, T>& out, const std::vector<float>& kx, const std::vector<float>& ky,
+						 const BorderMode<frmt, T>& border_mode)
+	{
+		if (out.width != in.width || out.height != in.height)
+			out.create(in.width, in.height);
+
+		DispatchBorder(border_mode.border_type, [&](auto policy)
+		{
+			if constexpr (std::is_same_v<T, uint8_t> || std::is_same_v<T, int16_t>)
+			{
+				std::vector<int32_t> qx, qy;
+				const int shift = QuantizeKernels<T>(kx, ky, qx, qy);
+				if (shift >= 0)
+				{
+					SeparableConvolve<frmt, T, policy.value, FixedArith<T>>(in, out, qx, qy, shift, border_mode.border_pixel);
+					return;
+				}
+			}
+
+			SeparableConvolve<frmt, T, policy.value, FloatArith>(in, out, kx, ky, 0, border_mode.border_pixel);
+		});
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "convert.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace qlm::detail
+{
+	// linear -> encoded
+	inline float EncodeTransfer(float v, TransferFunction transfer, float gamma)
+	{
+		switch (transfer)
+		{
+			case TransferFunction::SRGB:
+				return v <= 0.0031308f ? 12.92f * v : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+			case TransferFunction::GAMMA:
+				return std::pow(v, 1.0f / gamma);
+			default:
+				return v;
+		}
+	}
+
+	// encoded -> linear
+	inline float DecodeTransfer(float v, TransferFunction transfer, float gamma)
+	{
+		switch (transfer)
+		{
+			case TransferFunction::SRGB:
+				return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+			case TransferFunction::GAMMA:
+				return std::pow(v, gamma);
+			default:
+				return v;
+		}
+	}
+
+	// uint8 -> float through a 256 entries table
+	class U8ToFloatTable
+	{
+	private:
+		std::array<float, 256> table;
+
+	public:
+		U8ToFloatTable(TransferFunction transfer, float gamma)
+		{
+			for (int i = 0; i < 256; i++)
+				table[i] = DecodeTransfer(i / 255.0f, transfer, gamma);
+		}
+
+		float operator()(uint8_t v) const
+		{
+			return table[v];
+		}
+	};
+
+	// float -> uint8 by quantizing the clamped input to 14 bits and looking up the encoded value
+	class FloatToU8Table
+	{
+	private:
+		static constexpr int size = 1 << 14;
+		std::vector<uint8_t> table;
+
+	public:
+		FloatToU8Table(TransferFunction transfer, float gamma) : table(size + 1)
+		{
+			for (int i = 0; i <= size; i++)
+			{
+				const float encoded = EncodeTransfer(static_cast<float>(i) / size, transfer, gamma);
+				table[i] = static_cast<uint8_t>(std::clamp(encoded * 255.0f + 0.5f, 0.0f, 255.0f));
+			}
+		}
+
+		uint8_t operator()(float v) const
+		{
+			// NaN compares false on both sides and ends up at 0
+			v = v > 0.0f ? (v < 1.0f ? v : 1.0f) : 0.0f;
+			return table[static_cast<int>(v * size + 0.5f)];
+		}
+	};
+
+	inline uint8_t LinearToU8(float v)
+	{
+		v = v > 0.0f ? (v < 1.0f ? v : 1.0f) : 0.0f;
+		return static_cast<uint8_t>(v * 255.0f + 0.5f);
+	}
+
+	// Convert "count" pixels of "ch" interleaved channels, the last channel is alpha
+	inline void RowToFloat(const uint8_t* src, float* dst, int count, int ch, const U8ToFloatTable& lut)
+	{
+		constexpr float scale = 1.0f / 255.0f;
+
+		for (int i = 0; i < count; i++, src += ch, dst += ch)
+		{
+			for (int c = 0; c < ch - 1; c++)
+				dst[c] = lut(src[c]);
+
+			dst[ch - 1] = src[ch - 1] * scale;
+		}
+	}
+
+	// Convert "count" pixels of "ch" channels as decoded by stb, which carry alpha only when "ch" is 2 or 4
+	inline void DecodedToFloat(const uint8_t* src, float* dst, size_t count, int ch, const U8ToFloatTable& lut)
+	{
+		if (ch == 2 || ch == 4)
+		{
+			RowToFloat(src, dst, static_cast<int>(count), ch, lut);
+			return;
+		}
+
+		for (size_t i = 0; i < count * ch; i++)
+			dst[i] = lut(src[i]);
+	}
+
+	inline void RowToU8(const float* src, uint8_t* dst, int count, int ch, const FloatToU8Table& lut)
+	{
+		for (int i = 0; i < count; i++, src += ch, dst += ch)
+		{
+			for (int c = 0; c < ch - 1; c++)
+				dst[c] = lut(src[c]);
+
+			dst[ch - 1] = LinearToU8(src[ch - 1]);
+		}
+	}
+
+	// Linear transfer has no table, keep the loops branch free so the compiler can vectorize them
+	inline void RowToFloatLinear(const uint8_t* src, float* dst, int count)
+	{
+		constexpr float scale = 1.0f / 255.0f;
+
+		for (int i = 0; i < count; i++)
+			dst[i] = src[i] * scale;
+	}
+
+	inline void RowToU8Linear(const float* src, uint8_t* dst, int count)
+	{
+		for (int i = 0; i < count; i++)
+			dst[i] = LinearToU8(src[i]);
+	}
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "geometry.hpp"
+#include "saturate.hpp"
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace qlm::detail
+{
+	// Fixed-point sampling: coordinates carry remap_frac_bits fractional bits, the bilinear weights of every
+	// fraction pair are remap_weight_bits fixed-point numbers that sum to exactly 1
+	constexpr int remap_frac_bits = 5;
+	constexpr int remap_frac_size = 1 << remap_frac_bits;
+	constexpr int remap_weight_bits = 14;
+
+	// Largest coordinate magnitude kept, far outside any image but safe to add to and shift
+	constexpr double remap_coordinate_limit = 1 << 28;
+
+	// Bilinear weights (top-left, top-right, bottom-left, bottom-right) of fraction index fy * remap_frac_size + fx
+	inline const std::array<std::array<int16_t, 4>, remap_frac_size * remap_frac_size>& BilinearWeightTable()
+	{
+		static const auto table = []
+		{
+			std::array<std::array<int16_t, 4>, remap_frac_size * remap_frac_size> t{};
+			constexpr int one = 1 << remap_weight_bits;
+
+			for (int fy = 0; fy < remap_frac_size; fy++)
+			{
+				for (int fx = 0; fx < remap_frac_size; fx++)
+				{
+					const double ax = static_cast<double>(fx) / remap_frac_size;
+					const double ay = static_cast<double>(fy) / remap_frac_size;
+					const double w[4] = { (1 - ax) * (1 - ay), ax * (1 - ay), (1 - ax) * ay, ax * ay };
+
+					// the rounding residual goes to the largest weight so flat areas stay flat
+					std::array<int16_t, 4>& q = t[fy * remap_frac_size + fx];
+					int sum = 0, largest = 0;
+					for (int k = 0; k < 4; k++)
+					{
+						q[k] = static_cast<int16_t>(std::lround(w[k] * one));
+						sum += q[k];
+						largest = w[k] > w[largest] ? k : largest;
+					}
+					q[largest] = static_cast<int16_t>(q[largest] + one - sum);
+				}
+			}
+			return t;
+		}();
+
+		return table;
+	}
+
+	// Integer source coordinate clamped to the safe range
+	inline int ClampCoordinate(double v)
+	{
+		// floor through truncation, std::floor is a library call without SSE4.1
+		v = std::min(std::max(v, -remap_coordinate_limit), remap_coordinate_limit);
+		const int i = static_cast<int>(v);
+		return i - (v < i);
+	}
+
+	// Nearest neighbor gather of "count" pixels at the integer source positions (sx[i], sy[i])
+	template<BorderType border_type, ImageFormat frmt, pixel_t T, typename I>
+	void RemapNearest(const Image<frmt, T>& in, const I* sx, const I* sy, int count, const Pixel<frmt, T>& border_pixel, Pixel<frmt, T>* dst)
+	{
+		const int width = in.width;
+		const int height = in.height;
+
+		for (int i = 0; i < count; i++)
+		{
+			const int x = sx[i];
+			const int y = sy[i];
+
+			if (static_cast<unsigned>(x) < static_cast<unsigned>(width) && static_cast<unsigned>(y) < static_cast<unsigned>(height))
+			{
+				dst[i] = in.GetRow(y)[x];
+				continue;
+			}
+
+			const int bx = BorderIndex<border_type>(x, width);
+			const int by = BorderIndex<border_type>(y, height);
+			dst[i] = bx < 0 || by < 0 ? border_pixel : in.GetRow(by)[bx];
+		}
+	}
+
+	// Bilinear gather at fixed-point positions: integer parts (sx[i], sy[i]) and fraction index frac[i]
+	// (fy * remap_frac_size + fx). Taps inside the image take the fast path, the others follow the border type.
+	// Floating-point pixels are weighted with the same table.
+	template<BorderType border_type, ImageFormat frmt, pixel_t T, typename I>
+	void RemapBilinearFixed(const Image<frmt, T>& in, const I* sx, const I* sy, const uint16_t* frac, int count,
+							const Pixel<frmt, T>& border_pixel, Pixel<frmt, T>* dst)
+	{
+		constexpr int C = PixelChannels<frmt, T>();
+		constexpr int32_t round = 1 << (remap_weight_bits - 1);
+		const auto& table = BilinearWeightTable();
+		const int width = in.width;
+		const int height = in.height;
+		const T* border_scalars = reinterpret_cast<const T*>(&border_pixel);
+
+		for (int i = 0; i < count; i++)
+		{
+			const int x = sx[i];
+			const int y = sy[i];
+			const int16_t* w = table[frac[i]].data();
+			const T* p[4];
+
+			if (static_cast<unsigned>(x) < static_cast<unsigned>(width - 1) && static_cast<unsigned>(y) < static_cast<unsigned>(height - 1))
+			{
+				p[0] = reinterpret_cast<const T*>(in.GetRow(y) + x);
+				p[1] = p[0] + C;
+				p[2] = reinterpret_cast<const T*>(in.GetRow(y + 1) + x);
+				p[3] = p[2] + C;
+			}
+			else
+			{
+				const int x0 = BorderIndex<border_type>(x, width);
+				const int x1 = BorderIndex<border_type>(x + 1, width);
+				const int y0 = BorderIndex<border_type>(y, height);
+				const int y1 = BorderIndex<border_type>(y + 1, height);
+
+				const auto tap = [&](int tx, int ty)
+				{
+					return tx < 0 || ty < 0 ? border_scalars : reinterpret_cast<const T*>(in.GetRow(ty) + tx);
+				};
+
+				p[0] = tap(x0, y0);
+				p[1] = tap(x1, y0);
+				p[2] = tap(x0, y1);
+				p[3] = tap(x1, y1);
+			}
+
+			T* d = reinterpret_cast<T*>(dst + i);
+			for (int c = 0; c < C; c++)
+			{
+				if constexpr (std::is_floating_point_v<T>)
+				{
+					const T sum = p[0][c] * w[0] + p[1][c] * w[1] + p[2][c] * w[2] + p[3][c] * w[3];
+					d[c] = sum * T(1.0 / (1 << remap_weight_bits));
+				}
+				else
+				{
+					const int32_t sum = p[0][c] * w[0] + p[1][c] * w[1] + p[2][c] * w[2] + p[3][c] * w[3];
+					d[c] = SaturateCast<T>((sum + round) >> remap_weight_bits);
+				}
+			}
+		}
+	}
+
+	// Bilinear gather at floating-point positions (u[i], v[i])
+	template<BorderType border_type, ImageFormat frmt, pixel_t T>
+	void RemapBilinearFloat(const Image<frmt, T>& in, const float* u, const float* v, int count, const Pixel<frmt, T>& border_pixel,
+							Pixel<frmt, T>* dst)
+	{
+		constexpr int C = PixelChannels<frmt, T>();
+		const int width = in.width;
+		const int height = in.height;
+		const T* border_scalars = reinterpret_cast<const T*>(&border_pixel);
+
+		for (int i = 0; i < count; i++)
+		{
+			const float fu = std::clamp(u[i], float(-remap_coordinate_limit), float(remap_coordinate_limit));
+			const float fv = std::clamp(v[i], float(-remap_coordinate_limit), float(remap_coordinate_limit));
+			const float flx = std::floor(fu);
+			const float fly = std::floor(fv);
+			const int x = static_cast<int>(flx);
+			const int y = static_cast<int>(fly);
+			const float ax = fu - flx;
+			const float ay = fv - fly;
+			const T* p[4];
+
+			if (static_cast<unsigned>(x) < static_cast<unsigned>(width - 1) && static_cast<unsigned>(y) < static_cast<unsigned>(height - 1))
+			{
+				p[0] = reinterpret_cast<const T*>(in.GetRow(y) + x);
+				p[1] = p[0] + C;
+				p[2] = reinterpret_cast<const T*>(in.GetRow(y + 1) + x);
+				p[3] = p[2] + C;
+			}
+			else
+			{
+				const int x0 = BorderIndex<border_type>(x, width);
+				const int x1 = BorderIndex<border_type>(x + 1, width);
+				const int y0 = BorderIndex<border_type>(y, height);
+				const int y1 = BorderIndex<border_type>(y + 1, height);
+
+				const auto tap = [&](int tx, int ty)
+				{
+					return tx < 0 || ty < 0 ? border_scalars : reinterpret_cast<const T*>(in.GetRow(ty) + tx);
+				};
+
+				p[0] = tap(x0, y0);
+				p[1] = tap(x1, y0);
+				p[2] = tap(x0, y1);
+				p[3] = tap(x1, y1);
+			}
+
+			T* d = reinterpret_cast<T*>(dst + i);
+			for (int c = 0; c < C; c++)
+			{
+				const float top = p[0][c] + ax * (p[1][c] - p[0][c]);
+				const float bottom = p[2][c] + ax * (p[3][c] - p[2][c]);
+				d[c] = SaturateCast<T>(top + ay * (bottom - top));
+			}
+		}
+	}
+}
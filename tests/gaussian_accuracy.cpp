@@ -0,0 +1,234 @@
+#include "gaussian.hpp"
+#include <PixelImage.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares the recursive Gaussian (Deriche) with the exact sampled kernel for sigma 1.5 to 50 with every border
+// type, and GaussianBlur on both sides of its switch from the direct kernel to the recursive filter. The
+// reference is a separable convolution in double precision: radius 8 sigma for the recursive filter, the
+// truncated kernel GaussianBlur applies directly (radius 3 sigma, 4 sigma for floating-point, up to 12)
+// otherwise. Errors are measured in levels of an 8-bit image spanning the same range as the test pattern:
+// the result must stay within 0.1 of a level of the reference (0.25 for the direct 8-bit path, whose kernels are
+// quantized to 11 bits), integer outputs may add 0.5 of their own unit for the rounding.
+
+namespace
+{
+	constexpr double level_tolerance = 0.1;
+	constexpr double fixed_point_level_tolerance = 0.25;
+
+	template<qlm::ImageFormat frmt, qlm::pixel_t T>
+	qlm::Image<frmt, T> TestPattern(int width, int height, double low, double high)
+	{
+		constexpr int C = qlm::PixelChannels<frmt, T>();
+		qlm::Image<frmt, T> img(width, height);
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<double> noise(-0.1, 0.1);
+
+		// steps, a ramp and noise, every channel (alpha included) gets a different pattern
+		for (int y = 0; y < height; y++)
+		{
+			T* row = reinterpret_cast<T*>(img.GetRow(y));
+			for (int x = 0; x < width; x++)
+			{
+				for (int c = 0; c < C; c++)
+				{
+					const double step = ((x / (7 + 5 * c)) + (y / (11 + 3 * c))) % 2 == 0 ? 0.2 : 0.8;
+					const double ramp = 0.1 * static_cast<double>(x + c * y) / (width + height);
+					const double v = std::clamp(step + ramp + noise(rng), 0.0, 1.0);
+					const double scaled = low + v * (high - low);
+					row[x * C + c] = std::is_floating_point_v<T> ? static_cast<T>(scaled) : static_cast<T>(std::lround(scaled));
+				}
+			}
+		}
+
+		return img;
+	}
+
+	// separable Gaussian over [-radius, radius] in double precision, positions outside read the border pixel
+	// when BorderIndex gives -1 (constant border)
+	template<qlm::ImageFormat frmt, qlm::pixel_t T, qlm::BorderType border_type>
+	std::vector<double> Reference(const qlm::Image<frmt, T>& in, double sigma_x, double sigma_y, int radius_x, int radius_y,
+								  const qlm::Pixel<frmt, T>& border_pixel)
+	{
+		constexpr int C = qlm::PixelChannels<frmt, T>();
+		const int width = in.width;
+		const int height = in.height;
+		const T* border = reinterpret_cast<const T*>(&border_pixel);
+
+		const auto kernel = [](double sigma, int radius)
+		{
+			std::vector<double> k(2 * radius + 1);
+			double sum = 0.0;
+			for (int i = -radius; i <= radius; i++)
+				sum += k[i + radius] = std::exp(-0.5 * i * i / (sigma * sigma));
+			for (double& v : k)
+				v /= sum;
+			return k;
+		};
+
+		const std::vector<double> kx = kernel(sigma_x, radius_x);
+		const std::vector<double> ky = kernel(sigma_y, radius_y);
+
+		// the rows outside the image are constant rows of the border pixel, filtered like the others
+		std::vector<double> border_row(static_cast<size_t>(width) * C);
+		for (int j = 0; j < width * C; j++)
+			border_row[j] = border[j % C];
+
+		std::vector<double> temp(static_cast<size_t>(width) * height * C, 0.0);
+		for (int y = 0; y < height; y++)
+		{
+			const T* row = reinterpret_cast<const T*>(in.GetRow(y));
+			for (int x = 0; x < width; x++)
+			{
+				for (int i = -radius_x; i <= radius_x; i++)
+				{
+					const int sx = qlm::BorderIndex<border_type>(x + i, width);
+					for (int c = 0; c < C; c++)
+						temp[(static_cast<size_t>(y) * width + x) * C + c] += kx[i + radius_x] * (sx < 0 ? border[c] : row[sx * C + c]);
+				}
+			}
+		}
+
+		std::vector<double> result(temp.size(), 0.0);
+		for (int y = 0; y < height; y++)
+		{
+			for (int i = -radius_y; i <= radius_y; i++)
+			{
+				const int sy = qlm::BorderIndex<border_type>(y + i, height);
+				const double* src = sy < 0 ? border_row.data() : &temp[static_cast<size_t>(sy) * width * C];
+				double* dst = &result[static_cast<size_t>(y) * width * C];
+				for (int j = 0; j < width * C; j++)
+					dst[j] += ky[i + radius_y] * src[j];
+			}
+		}
+
+		return result;
+	}
+
+	template<qlm::ImageFormat frmt, qlm::pixel_t T>
+	bool Compare(const std::string& name, const qlm::Image<frmt, T>& out, const std::vector<double>& ref, double low, double high,
+				 double levels = level_tolerance)
+	{
+		constexpr int C = qlm::PixelChannels<frmt, T>();
+		const double level = (high - low) / 255.0;
+		const double tolerance = (std::is_floating_point_v<T> ? 0.0 : 0.5) + levels * level;
+
+		double max_error = 0.0;
+		for (int y = 0; y < out.height; y++)
+		{
+			const T* row = reinterpret_cast<const T*>(out.GetRow(y));
+			for (int i = 0; i < out.width * C; i++)
+				max_error = std::max(max_error, std::abs(static_cast<double>(row[i]) - ref[static_cast<size_t>(y) * out.width * C + i]));
+		}
+
+		const bool ok = max_error <= tolerance;
+		std::cout << (ok ? "ok   " : "FAIL ") << name << ": max error " << max_error / level << " levels (tolerance " << tolerance / level << ")"
+				  << std::endl;
+		return ok;
+	}
+
+	template<qlm::ImageFormat frmt, qlm::pixel_t T>
+	qlm::Pixel<frmt, T> BorderPixel(double low, double high)
+	{
+		constexpr int C = qlm::PixelChannels<frmt, T>();
+		qlm::Pixel<frmt, T> pixel{};
+		T* values = reinterpret_cast<T*>(&pixel);
+		for (int c = 0; c < C; c++)
+			values[c] = static_cast<T>(low + (high - low) * (c + 1) / (C + 1));
+		return pixel;
+	}
+
+	// the recursive filter alone, for sigma 1.5 to 50
+	template<qlm::ImageFormat frmt, qlm::pixel_t T, qlm::BorderType border_type>
+	bool CheckRecursive(const char* name, double low, double high)
+	{
+		const qlm::Image<frmt, T> in = TestPattern<frmt, T>(131, 97, low, high);
+		const qlm::Pixel<frmt, T> border_pixel = BorderPixel<frmt, T>(low, high);
+
+		bool pass = true;
+		for (const double sigma : { 1.5, 2.5, 4.0, 8.0, 16.0, 32.0, 50.0 })
+		{
+			// different sigmas along the two axes so both sets of coefficients are checked
+			const double sigma_x = sigma;
+			const double sigma_y = 0.75 * sigma;
+
+			qlm::Image<frmt, T> out;
+			out.create(in.width, in.height);
+			qlm::detail::RecursiveGaussian<frmt, T, border_type>(in, out, sigma_x, sigma_y, border_pixel);
+			const std::vector<double> ref = Reference<frmt, T, border_type>(in, sigma_x, sigma_y, static_cast<int>(std::ceil(8.0 * sigma_x)),
+																			static_cast<int>(std::ceil(8.0 * sigma_y)), border_pixel);
+
+			pass = Compare(std::string(name) + " recursive sigma " + std::to_string(sigma), out, ref, low, high) && pass;
+		}
+
+		return pass;
+	}
+
+	// GaussianBlur just below and just above the largest direct radius of 12
+	template<qlm::ImageFormat frmt, qlm::pixel_t T, qlm::BorderType border_type>
+	bool CheckBlur(const char* name, double low, double high)
+	{
+		const qlm::Image<frmt, T> in = TestPattern<frmt, T>(131, 97, low, high);
+		const qlm::BorderMode<frmt, T> border_mode{ border_type, BorderPixel<frmt, T>(low, high) };
+		const double extent = std::is_floating_point_v<T> ? 4.0 : 3.0;
+
+		bool pass = true;
+		for (const double radius : { 2.0, 11.9, 12.0, 12.1, 20.0 })
+		{
+			for (const double ratio : { 1.0, 0.5 })
+			{
+				const float sigma_x = static_cast<float>(radius / extent);
+				const float sigma_y = static_cast<float>(ratio * sigma_x);
+				const int radius_x = static_cast<int>(std::ceil(extent * sigma_x));
+				const int radius_y = static_cast<int>(std::ceil(extent * sigma_y));
+				const bool recursive = std::max(radius_x, radius_y) > 12;
+
+				// the direct path applies the truncated kernel, the recursive one approximates the whole Gaussian
+				const int reference_x = recursive ? static_cast<int>(std::ceil(8.0 * sigma_x)) : radius_x;
+				const int reference_y = recursive ? static_cast<int>(std::ceil(8.0 * sigma_y)) : radius_y;
+				const double levels = !recursive && sizeof(T) == 1 ? fixed_point_level_tolerance : level_tolerance;
+
+				qlm::Image<frmt, T> out;
+				qlm::GaussianBlur(in, out, sigma_x, ratio == 1.0 ? 0.0f : sigma_y, border_mode);
+				const std::vector<double> ref = Reference<frmt, T, border_type>(in, sigma_x, sigma_y, reference_x, reference_y, border_mode.border_pixel);
+
+				const std::string label = std::string(name) + " GaussianBlur " + (recursive ? "recursive" : "direct") + " sigma " + std::to_string(sigma_x) +
+										  " x " + std::to_string(sigma_y);
+				pass = Compare(label, out, ref, low, high, levels) && pass;
+			}
+		}
+
+		return pass;
+	}
+}
+
+int main()
+{
+	using qlm::BorderType;
+	using qlm::ImageFormat;
+
+	bool pass = true;
+	pass = CheckRecursive<ImageFormat::GRAY, uint8_t, BorderType::BORDER_REPLICATE>("GRAY uint8 replicate", 0.0, 255.0) && pass;
+	pass = CheckRecursive<ImageFormat::RGB, uint8_t, BorderType::BORDER_REFLECT_101>("RGB uint8 reflect101", 0.0, 255.0) && pass;
+	pass = CheckRecursive<ImageFormat::RGB, uint8_t, BorderType::BORDER_CONSTANT>("RGB uint8 constant", 0.0, 255.0) && pass;
+	pass = CheckRecursive<ImageFormat::GRAY, int16_t, BorderType::BORDER_REFLECT>("GRAY int16 reflect", -30000.0, 30000.0) && pass;
+	pass = CheckRecursive<ImageFormat::RGB, int16_t, BorderType::BORDER_REPLICATE>("RGB int16 replicate", -1000.0, 1000.0) && pass;
+	pass = CheckRecursive<ImageFormat::GRAY, int16_t, BorderType::BORDER_WRAP>("GRAY int16 wrap", -1000.0, 1000.0) && pass;
+	pass = CheckRecursive<ImageFormat::GRAY, float, BorderType::BORDER_REFLECT_101>("GRAY float reflect101", 0.0, 1.0) && pass;
+	pass = CheckRecursive<ImageFormat::RGB, float, BorderType::BORDER_REPLICATE>("RGB float replicate", 0.0, 1.0) && pass;
+	pass = CheckRecursive<ImageFormat::GRAY, float, BorderType::BORDER_CONSTANT>("GRAY float constant", 0.0, 1.0) && pass;
+	pass = CheckRecursive<ImageFormat::RGB, float, BorderType::BORDER_WRAP>("RGB float wrap", 0.0, 1.0) && pass;
+
+	pass = CheckBlur<ImageFormat::RGB, uint8_t, BorderType::BORDER_REFLECT_101>("RGB uint8 reflect101", 0.0, 255.0) && pass;
+	pass = CheckBlur<ImageFormat::GRAY, uint8_t, BorderType::BORDER_CONSTANT>("GRAY uint8 constant", 0.0, 255.0) && pass;
+	pass = CheckBlur<ImageFormat::GRAY, int16_t, BorderType::BORDER_WRAP>("GRAY int16 wrap", -1000.0, 1000.0) && pass;
+	pass = CheckBlur<ImageFormat::RGB, float, BorderType::BORDER_REPLICATE>("RGB float replicate", 0.0, 1.0) && pass;
+	pass = CheckBlur<ImageFormat::GRAY, float, BorderType::BORDER_REFLECT>("GRAY float reflect", 0.0, 1.0) && pass;
+
+	return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
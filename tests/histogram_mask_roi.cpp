@@ -0,0 +1,119 @@
+#include <PixelImage.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+// Compares Histogram::Compute with a plain count of the color channels, with and without a mask and a
+// region of interest, for 8, 16-bit and floating-point pixels and for explicit binnings whose range leaves
+// values out. The images are large enough to be split over several threads.
+
+namespace
+{
+	template<qlm::ImageFormat frmt, qlm::pixel_t T>
+	bool Check(const char* name, const qlm::Image<frmt, T>& in, qlm::Histogram<frmt, T>& hist, const qlm::Image<qlm::ImageFormat::GRAY, uint8_t>* mask,
+			   const qlm::Rect& roi)
+	{
+		constexpr int C = qlm::PixelChannels<frmt, T>();
+		constexpr int channels = qlm::Histogram<frmt, T>::channels;
+
+		if (mask != nullptr)
+			hist.Compute(in, *mask, roi);
+		else
+			hist.Compute(in, roi);
+
+		const qlm::Rect area = roi.width > 0 && roi.height > 0 ? roi : qlm::Rect{ 0, 0, in.width, in.height };
+		std::vector<uint64_t> expected(static_cast<size_t>(channels) * hist.Bins(), 0);
+		for (int y = area.y; y < area.y + area.height; y++)
+		{
+			const T* row = reinterpret_cast<const T*>(in.GetRow(y));
+			for (int x = area.x; x < area.x + area.width; x++)
+			{
+				if (mask != nullptr && reinterpret_cast<const uint8_t*>(mask->GetRow(y))[x * qlm::PixelChannels<qlm::ImageFormat::GRAY, uint8_t>()] == 0)
+					continue;
+
+				for (int c = 0; c < channels; c++)
+				{
+					const int bin = hist.Bin(static_cast<double>(row[x * C + c]));
+					if (bin >= 0)
+						expected[static_cast<size_t>(c) * hist.Bins() + bin]++;
+				}
+			}
+		}
+
+		int wrong = 0;
+		for (int c = 0; c < channels; c++)
+			for (int b = 0; b < hist.Bins(); b++)
+				wrong += hist.Count(c, b) != expected[static_cast<size_t>(c) * hist.Bins() + b];
+
+		std::cout << (wrong == 0 ? "ok   " : "FAIL ") << name << (mask != nullptr ? " masked" : "") << " roi " << roi.x << "," << roi.y << " "
+				  << roi.width << "x" << roi.height << ": " << wrong << " wrong bins" << std::endl;
+		return wrong == 0;
+	}
+
+	template<qlm::ImageFormat frmt, qlm::pixel_t T>
+	bool CheckAll(const char* name, qlm::Histogram<frmt, T> hist, double low, double high)
+	{
+		constexpr int C = qlm::PixelChannels<frmt, T>();
+		const int width = 613;
+		const int height = 517;
+
+		// mostly uniform values with a few very frequent ones, so some bins get many counts
+		std::mt19937 rng(3);
+		std::uniform_real_distribution<double> uniform(low, high);
+		qlm::Image<frmt, T> in(width, height);
+		for (int y = 0; y < height; y++)
+		{
+			T* row = reinterpret_cast<T*>(in.GetRow(y));
+			for (int i = 0; i < width * C; i++)
+			{
+				double v = rng() % 4 == 0 ? low + (high - low) * (i % C + 1) / 8.0 : uniform(rng);
+				if constexpr (std::is_floating_point_v<T>)
+				{
+					// away from the bin edges, where Compute (in float) and Bin (in double) may round differently
+					const double width_of_bin = (hist.Max() - hist.Min()) / hist.Bins();
+					const double t = (v - hist.Min()) / width_of_bin;
+					v = hist.Min() + (std::floor(t) + std::clamp(t - std::floor(t), 0.1, 0.9)) * width_of_bin;
+				}
+				row[i] = static_cast<T>(v);
+			}
+		}
+
+		qlm::Image<qlm::ImageFormat::GRAY, uint8_t> mask(width, height);
+		for (int y = 0; y < height; y++)
+		{
+			uint8_t* row = reinterpret_cast<uint8_t*>(mask.GetRow(y));
+			for (int x = 0; x < width; x++)
+				row[x * qlm::PixelChannels<qlm::ImageFormat::GRAY, uint8_t>()] = (x / 7 + y / 5) % 3 == 0 ? 0 : static_cast<uint8_t>(1 + rng() % 255);
+		}
+
+		bool pass = true;
+		for (const qlm::Rect& roi : { qlm::Rect{}, qlm::Rect{ 37, 21, 301, 402 }, qlm::Rect{ 0, 516, 613, 1 }, qlm::Rect{ 612, 0, 1, 517 } })
+		{
+			pass = Check<frmt, T>(name, in, hist, nullptr, roi) && pass;
+			pass = Check<frmt, T>(name, in, hist, &mask, roi) && pass;
+		}
+
+		return pass;
+	}
+}
+
+int main()
+{
+	using qlm::Histogram;
+	using qlm::ImageFormat;
+
+	bool pass = true;
+	pass = CheckAll<ImageFormat::GRAY, uint8_t>("GRAY uint8", {}, 0.0, 256.0) && pass;
+	pass = CheckAll<ImageFormat::RGB, uint8_t>("RGB uint8", {}, 0.0, 256.0) && pass;
+	pass = CheckAll<ImageFormat::RGB, uint8_t>("RGB uint8 40 bins over [16, 236)", { 40, 16.0, 236.0 }, 0.0, 256.0) && pass;
+	pass = CheckAll<ImageFormat::GRAY, uint16_t>("GRAY uint16", {}, 0.0, 65536.0) && pass;
+	pass = CheckAll<ImageFormat::RGB, uint16_t>("RGB uint16 1000 bins over [1000, 51000)", { 1000, 1000.0, 51000.0 }, 0.0, 65536.0) && pass;
+	pass = CheckAll<ImageFormat::GRAY, float>("GRAY float", {}, -0.25, 1.25) && pass;
+	pass = CheckAll<ImageFormat::RGB, float>("RGB float 5000 bins over [-1, 2)", { 5000, -1.0, 2.0 }, -1.5, 2.5) && pass;
+
+	return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
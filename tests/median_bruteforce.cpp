@@ -0,0 +1,107 @@
+#include <PixelImage.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Compares MedianBlur with the median of every window sorted one by one, for the sorting networks (3x3, 5x5),
+// the constant-time 8-bit histograms and the three level 16-bit histograms, with several border types.
+
+namespace
+{
+	template<qlm::ImageFormat frmt, qlm::pixel_t T, qlm::BorderType border_type>
+	bool Check(const char* name, int width, int height, int ksize)
+	{
+		constexpr int C = qlm::PixelChannels<frmt, T>();
+		const int r = ksize / 2;
+
+		// noise over a few large steps, with runs of equal values
+		std::mt19937 rng(ksize);
+		qlm::Image<frmt, T> in(width, height);
+		for (int y = 0; y < height; y++)
+		{
+			T* row = reinterpret_cast<T*>(in.GetRow(y));
+			for (int i = 0; i < width * C; i++)
+			{
+				const uint32_t step = (i / C / 17 + y / 13) % 3 * (std::numeric_limits<T>::max() / 3);
+				row[i] = static_cast<T>(rng() % 5 == 0 ? step : std::min<uint32_t>(step + rng() % (std::numeric_limits<T>::max() / 2), std::numeric_limits<T>::max()));
+			}
+		}
+
+		qlm::BorderMode<frmt, T> border_mode{ border_type };
+		T* border = reinterpret_cast<T*>(&border_mode.border_pixel);
+		for (int c = 0; c < C; c++)
+			border[c] = static_cast<T>(std::numeric_limits<T>::max() / (c + 2));
+
+		qlm::Image<frmt, T> out;
+		qlm::MedianBlur(in, out, ksize, border_mode);
+
+		int wrong = 0;
+		std::vector<T> window(static_cast<size_t>(ksize) * ksize);
+		for (int y = 0; y < height; y++)
+		{
+			const T* row = reinterpret_cast<const T*>(out.GetRow(y));
+			for (int x = 0; x < width; x++)
+			{
+				for (int c = 0; c < C; c++)
+				{
+					size_t n = 0;
+					for (int dy = -r; dy <= r; dy++)
+					{
+						for (int dx = -r; dx <= r; dx++)
+						{
+							const int sx = qlm::BorderIndex<border_type>(x + dx, width);
+							const int sy = qlm::BorderIndex<border_type>(y + dy, height);
+							window[n++] = sx < 0 || sy < 0 ? border[c] : reinterpret_cast<const T*>(in.GetRow(sy))[sx * C + c];
+						}
+					}
+
+					std::nth_element(window.begin(), window.begin() + window.size() / 2, window.end());
+					wrong += row[x * C + c] != window[window.size() / 2];
+				}
+			}
+		}
+
+		std::cout << (wrong == 0 ? "ok   " : "FAIL ") << name << " " << width << "x" << height << " ksize " << ksize << ": " << wrong
+				  << " wrong values" << std::endl;
+		return wrong == 0;
+	}
+
+	template<qlm::ImageFormat frmt, qlm::pixel_t T>
+	bool CheckAll(const char* name)
+	{
+		using qlm::BorderType;
+
+		bool pass = true;
+		for (const int ksize : { 1, 3, 5, 7, 9, 15 })
+		{
+			pass = Check<frmt, T, BorderType::BORDER_REPLICATE>(name, 83, 61, ksize) && pass;
+			pass = Check<frmt, T, BorderType::BORDER_REFLECT_101>(name, 83, 61, ksize) && pass;
+		}
+
+		pass = Check<frmt, T, BorderType::BORDER_CONSTANT>(name, 47, 33, 3) && pass;
+		pass = Check<frmt, T, BorderType::BORDER_WRAP>(name, 47, 33, 5) && pass;
+		pass = Check<frmt, T, BorderType::BORDER_REFLECT>(name, 47, 33, 11) && pass;
+
+		// windows larger than the image, and an image wide enough for several column strips
+		pass = Check<frmt, T, BorderType::BORDER_REFLECT_101>(name, 9, 6, 21) && pass;
+		pass = Check<frmt, T, BorderType::BORDER_REPLICATE>(name, 1200, 40, 7) && pass;
+
+		return pass;
+	}
+}
+
+int main()
+{
+	using qlm::ImageFormat;
+
+	bool pass = true;
+	pass = CheckAll<ImageFormat::GRAY, uint8_t>("GRAY uint8") && pass;
+	pass = CheckAll<ImageFormat::RGB, uint8_t>("RGB uint8") && pass;
+	pass = CheckAll<ImageFormat::GRAY, uint16_t>("GRAY uint16") && pass;
+	pass = CheckAll<ImageFormat::RGB, uint16_t>("RGB uint16") && pass;
+
+	return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,145 @@
+#include "png_encoder.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stb/stb_image.h>
+#include <string>
+#include <vector>
+
+// Encodes images that span several row blocks with the parallel WritePng and with the row-by-row PngEncoder.
+// Both files must decode to the source pixels, the zlib streams must inflate to the same filtered rows, and
+// the Adler-32 merged from the blocks and the CRC of every chunk must be those of the whole data.
+
+namespace
+{
+	std::vector<uint8_t> TestImage(int width, int height, int comp)
+	{
+		std::vector<uint8_t> data(static_cast<size_t>(width) * height * comp);
+		std::mt19937 rng(11);
+
+		// flat areas, gradients and noise so that every row filter and long and short matches occur
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				for (int c = 0; c < comp; c++)
+				{
+					uint8_t v;
+					if (y < height / 4)
+						v = static_cast<uint8_t>(40 * c);
+					else if (y < height / 2)
+						v = static_cast<uint8_t>(x + 3 * y + 50 * c);
+					else if (x < width / 2)
+						v = static_cast<uint8_t>(rng());
+					else
+						v = static_cast<uint8_t>(((x / 8 + y / 8) % 2) * 200 + (rng() % 4));
+					data[(static_cast<size_t>(y) * width + x) * comp + c] = v;
+				}
+			}
+		}
+
+		return data;
+	}
+
+	uint32_t GetU32(const uint8_t* p)
+	{
+		return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+	}
+
+	// Concatenated IDAT payloads, false when a chunk CRC is wrong
+	bool ZlibStream(const std::string& png, std::vector<uint8_t>& zlib)
+	{
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(png.data());
+		size_t pos = 8;
+		while (pos + 12 <= png.size())
+		{
+			const uint32_t length = GetU32(p + pos);
+			const uint8_t* type = p + pos + 4;
+			if (GetU32(p + pos + 8 + length) != qlm::detail::Crc32(0, type, length + 4))
+				return false;
+			if (std::string(reinterpret_cast<const char*>(type), 4) == "IDAT")
+				zlib.insert(zlib.end(), type + 4, type + 4 + length);
+			pos += 12 + length;
+		}
+
+		return pos == png.size();
+	}
+
+	// Filtered rows of the zlib stream, empty when it does not inflate or its Adler-32 is wrong
+	std::vector<uint8_t> Inflate(const std::vector<uint8_t>& zlib)
+	{
+		int size = 0;
+		char* raw = stbi_zlib_decode_malloc(reinterpret_cast<const char*>(zlib.data()), static_cast<int>(zlib.size()), &size);
+		if (raw == nullptr)
+			return {};
+
+		std::vector<uint8_t> rows(raw, raw + size);
+		free(raw);
+		if (qlm::detail::Adler32(1, rows.data(), rows.size()) != GetU32(zlib.data() + zlib.size() - 4))
+			return {};
+
+		return rows;
+	}
+
+	bool Check(int width, int height, int comp, int level, int filter)
+	{
+		const std::vector<uint8_t> data = TestImage(width, height, comp);
+		const size_t row_bytes = static_cast<size_t>(width) * comp;
+
+		std::ostringstream parallel_stream;
+		qlm::detail::WritePng(parallel_stream, data.data(), width, height, comp, level, filter);
+
+		std::ostringstream serial_stream;
+		qlm::detail::PngEncoder encoder(serial_stream, width, height, comp, level, filter);
+		for (int y = 0; y < height; y++)
+			encoder.WriteRow(data.data() + y * row_bytes);
+		encoder.Finish();
+
+		const std::string parallel = parallel_stream.str();
+		const std::string serial = serial_stream.str();
+
+		bool ok = true;
+		for (const std::string* png : { &parallel, &serial })
+		{
+			int w = 0, h = 0, n = 0;
+			uint8_t* decoded = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(png->data()), static_cast<int>(png->size()), &w, &h, &n, comp);
+			ok = ok && decoded != nullptr && w == width && h == height && n == comp && std::equal(data.begin(), data.end(), decoded);
+			stbi_image_free(decoded);
+		}
+
+		std::vector<uint8_t> parallel_zlib, serial_zlib;
+		ok = ok && ZlibStream(parallel, parallel_zlib) && ZlibStream(serial, serial_zlib);
+
+		const std::vector<uint8_t> parallel_rows = Inflate(parallel_zlib);
+		const std::vector<uint8_t> serial_rows = Inflate(serial_zlib);
+		ok = ok && parallel_rows.size() == (row_bytes + 1) * height && parallel_rows == serial_rows;
+
+		std::cout << (ok ? "ok   " : "FAIL ") << width << "x" << height << "x" << comp << " level " << level << " filter " << filter
+				  << ": " << parallel.size() << " bytes parallel, " << serial.size() << " bytes serial" << std::endl;
+		return ok;
+	}
+}
+
+int main()
+{
+	bool pass = true;
+
+	// 300 KB per channel, cut into two to five blocks of about 256 KB
+	for (const int comp : { 1, 2, 3, 4 })
+		pass = Check(601, 500, comp, 6, -1) && pass;
+
+	for (const int level : { 1, 9 })
+		pass = Check(601, 500, 4, level, -1) && pass;
+
+	for (const int filter : { 0, 1, 2, 3, 4 })
+		pass = Check(601, 300, 3, 6, filter) && pass;
+
+	// a single block, and rows longer than a block
+	pass = Check(64, 16, 4, 6, -1) && pass;
+	pass = Check(70000, 4, 4, 6, -1) && pass;
+
+	return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
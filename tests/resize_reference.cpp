@@ -0,0 +1,172 @@
+#include <PixelImage.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+// Compares Resize with a direct double-precision resampling of every output pixel from the whole source:
+// the separable filters centered on (i + 0.5) * scale, widened by the scale factor when shrinking and
+// normalized over the source, exact pixel coverage for AREA and the pixel under the center for NEAREST.
+// Floating-point results must match to 1e-4, 8 and 16-bit results to one unit after rounding.
+
+namespace
+{
+	double Filter(qlm::Interpolation interpolation, double x)
+	{
+		x = std::abs(x);
+		switch (interpolation)
+		{
+			case qlm::Interpolation::BICUBIC:
+				return x < 1.0 ? (1.5 * x - 2.5) * x * x + 1.0 : x < 2.0 ? ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0 : 0.0;
+			case qlm::Interpolation::LANCZOS3:
+			{
+				if (x >= 3.0)
+					return 0.0;
+				if (x == 0.0)
+					return 1.0;
+				const double px = std::numbers::pi * x;
+				return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+			}
+			default:
+				return std::max(0.0, 1.0 - x);
+		}
+	}
+
+	// weights[i][k] of source position k for output position i
+	std::vector<std::vector<double>> Weights(int in_size, int out_size, qlm::Interpolation interpolation)
+	{
+		const double scale = static_cast<double>(in_size) / out_size;
+		std::vector<std::vector<double>> weights(out_size, std::vector<double>(in_size, 0.0));
+
+		for (int i = 0; i < out_size; i++)
+		{
+			std::vector<double>& w = weights[i];
+			if (interpolation == qlm::Interpolation::NEAREST)
+			{
+				w[std::min(static_cast<int>((i + 0.5) * scale), in_size - 1)] = 1.0;
+				continue;
+			}
+
+			double sum = 0.0;
+			for (int k = 0; k < in_size; k++)
+			{
+				if (interpolation == qlm::Interpolation::AREA)
+					w[k] = std::max(0.0, std::min((i + 1) * scale, k + 1.0) - std::max(i * scale, double(k)));
+				else
+					w[k] = Filter(interpolation, (k + 0.5 - (i + 0.5) * scale) / std::max(scale, 1.0));
+				sum += w[k];
+			}
+
+			for (double& v : w)
+				v /= sum;
+		}
+
+		return weights;
+	}
+
+	template<qlm::ImageFormat frmt, qlm::pixel_t T>
+	bool Check(const char* name, int in_width, int in_height, int out_width, int out_height, qlm::Interpolation interpolation)
+	{
+		constexpr int C = qlm::PixelChannels<frmt, T>();
+		constexpr bool integral = std::is_integral_v<T>;
+		const double high = integral ? static_cast<double>(std::numeric_limits<T>::max()) : 1.0;
+		const double low = integral ? static_cast<double>(std::numeric_limits<T>::min()) : 0.0;
+
+		// smooth areas, sharp edges and noise
+		qlm::Image<frmt, T> in(in_width, in_height);
+		std::mt19937 rng(5);
+		for (int y = 0; y < in_height; y++)
+		{
+			T* row = reinterpret_cast<T*>(in.GetRow(y));
+			for (int x = 0; x < in_width * C; x++)
+			{
+				double v = ((x / C + y) % 13 < 6 ? 0.2 : 0.7) + 0.2 * std::sin(0.1 * x + 0.05 * y);
+				if (y % 5 == 0)
+					v = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+				v = low + v * (high - low);
+				row[x] = integral ? static_cast<T>(std::lround(v)) : static_cast<T>(v);
+			}
+		}
+
+		qlm::Image<frmt, T> out;
+		qlm::Resize(in, out, out_width, out_height, interpolation);
+		if (out.width != out_width || out.height != out_height)
+		{
+			std::cout << "FAIL " << name << ": output is " << out.width << "x" << out.height << std::endl;
+			return false;
+		}
+
+		const auto wx = Weights(in_width, out_width, interpolation);
+		const auto wy = Weights(in_height, out_height, interpolation);
+
+		// horizontal pass of every source row, then the vertical sums
+		std::vector<double> temp(static_cast<size_t>(in_height) * out_width * C, 0.0);
+		for (int y = 0; y < in_height; y++)
+		{
+			const T* row = reinterpret_cast<const T*>(in.GetRow(y));
+			for (int x = 0; x < out_width; x++)
+				for (int k = 0; k < in_width; k++)
+					for (int c = 0; c < C; c++)
+						temp[(static_cast<size_t>(y) * out_width + x) * C + c] += wx[x][k] * row[k * C + c];
+		}
+
+		double max_error = 0.0;
+		for (int y = 0; y < out_height; y++)
+		{
+			const T* row = reinterpret_cast<const T*>(out.GetRow(y));
+			for (int i = 0; i < out_width * C; i++)
+			{
+				double ref = 0.0;
+				for (int k = 0; k < in_height; k++)
+					ref += wy[y][k] * temp[static_cast<size_t>(k) * out_width * C + i];
+				if (integral)
+					ref = std::clamp(std::round(ref), low, high);
+				max_error = std::max(max_error, std::abs(row[i] - ref));
+			}
+		}
+
+		const bool ok = max_error <= (integral ? 1.0 : 1e-4);
+		std::cout << (ok ? "ok   " : "FAIL ") << name << " " << in_width << "x" << in_height << " -> " << out_width << "x"
+				  << out_height << ": max error " << max_error << std::endl;
+		return ok;
+	}
+
+	template<qlm::ImageFormat frmt, qlm::pixel_t T>
+	bool CheckAll(const char* name)
+	{
+		using qlm::Interpolation;
+
+		bool pass = true;
+		for (const Interpolation interpolation : { Interpolation::NEAREST, Interpolation::BILINEAR, Interpolation::BICUBIC,
+												   Interpolation::AREA, Interpolation::LANCZOS3 })
+		{
+			// enlarging, shrinking by integer and fractional factors, and one axis of each
+			pass = Check<frmt, T>(name, 37, 29, 101, 64, interpolation) && pass;
+			pass = Check<frmt, T>(name, 120, 90, 40, 30, interpolation) && pass;
+			pass = Check<frmt, T>(name, 117, 83, 50, 31, interpolation) && pass;
+			pass = Check<frmt, T>(name, 64, 90, 150, 41, interpolation) && pass;
+			pass = Check<frmt, T>(name, 9, 7, 2, 23, interpolation) && pass;
+		}
+
+		return pass;
+	}
+}
+
+int main()
+{
+	using qlm::ImageFormat;
+
+	bool pass = true;
+	pass = CheckAll<ImageFormat::GRAY, uint8_t>("GRAY uint8") && pass;
+	pass = CheckAll<ImageFormat::RGB, uint8_t>("RGB uint8") && pass;
+	pass = CheckAll<ImageFormat::RGB, int16_t>("RGB int16") && pass;
+	pass = CheckAll<ImageFormat::GRAY, float>("GRAY float") && pass;
+	pass = CheckAll<ImageFormat::RGB, float>("RGB float") && pass;
+
+	return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}